@@ -13,7 +13,21 @@ HEADERS += \
     $$PWD/include/appimageupdaterbridge.hpp \
     $$PWD/include/appimageupdaterdialog.hpp \
     $$PWD/include/softwareupdatedialog_p.hpp \
-    $$PWD/include/helpers_p.hpp
+    $$PWD/include/helpers_p.hpp \
+    $$PWD/include/sha1hasher_p.hpp \
+    $$PWD/include/appimagebatchscanner_p.hpp \
+    $$PWD/include/appimagebatchscanner.hpp \
+    $$PWD/include/zsyncrequestlimiter_p.hpp \
+    $$PWD/include/appimageupdatemanager_p.hpp \
+    $$PWD/include/appimageupdatemanager.hpp \
+    $$PWD/include/blockingupdater_p.hpp \
+    $$PWD/include/zsyncblockstore_p.hpp \
+    $$PWD/include/tracer_p.hpp \
+    $$PWD/include/zsyncprogressaggregator_p.hpp \
+    $$PWD/include/logging_p.hpp \
+    $$PWD/include/zsyncseedindex_p.hpp \
+    $$PWD/include/zsyncmatchcache_p.hpp \
+    $$PWD/include/zsyncknownblocks_p.hpp
 
 SOURCES += \
     $$PWD/src/appimageupdateinformation_p.cc \
@@ -26,7 +40,21 @@ SOURCES += \
     $$PWD/src/appimageupdaterdialog.cc \
     $$PWD/src/appimageupdaterbridge_enums.cc \
     $$PWD/src/softwareupdatedialog_p.cc \ 
-    $$PWD/src/helpers_p.cc
+    $$PWD/src/helpers_p.cc \
+    $$PWD/src/sha1hasher_p.cc \
+    $$PWD/src/appimagebatchscanner.cc \
+    $$PWD/src/appimagebatchscanner_p.cc \
+    $$PWD/src/zsyncrequestlimiter_p.cc \
+    $$PWD/src/appimageupdatemanager_p.cc \
+    $$PWD/src/appimageupdatemanager.cc \
+    $$PWD/src/blockingupdater_p.cc \
+    $$PWD/src/zsyncblockstore_p.cc \
+    $$PWD/src/tracer_p.cc \
+    $$PWD/src/zsyncprogressaggregator_p.cc \
+    $$PWD/src/logging_p.cc \
+    $$PWD/src/zsyncseedindex_p.cc \
+    $$PWD/src/zsyncmatchcache_p.cc \
+    $$PWD/src/zsyncknownblocks_p.cc
 
 FORMS += $$PWD/src/AppImageUpdaterDialog.ui \
          $$PWD/include/SoftwareUpdateDialog.ui
@@ -47,3 +75,8 @@ LOGGING_DISABLED {
 	message(Logging will be disabled for this build.)
 	DEFINES += LOGGING_DISABLED
 }
+
+STATISTICS_DISABLED {
+	message(Block matcher statistics will be disabled for this build.)
+	DEFINES += STATISTICS_DISABLED
+}
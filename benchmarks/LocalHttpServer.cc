@@ -0,0 +1,244 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : LocalHttpServer.cc
+ * @description : This is where the local benchmark http server is implemented.
+*/
+#include <QHostAddress>
+
+#include "LocalHttpServer.hpp"
+
+static constexpr int BandwidthInterval = 50; /* In milliseconds. */
+
+/*
+ * LocalHttpServer serves files from memory on the loopback interface , It
+ * understands just enough of HTTP/1.1 for the updater , GET with a single
+ * byte range , keep alive and pipelining. Every response is delayed by the
+ * given latency and the body is sent no faster than the given bandwidth.
+ *
+ * A new connection is not served before the given connect latency passed ,
+ * Which stands in for the TCP and TLS handshakes of a real host. The server
+ * speaks plain HTTP/1.1 only , TLS , ALPN and HTTP/2 are not emulated.
+ *
+ * Example:
+ * 	LocalHttpServer server(20, 1024 * 1024, 60);
+ * 	server.addFile("new.AppImage", data);
+ * 	server.listen();
+ * 	auto url = server.url("new.AppImage");
+*/
+LocalHttpServer::LocalHttpServer(int latency, qint64 bandwidth, int connectLatency, QObject *parent)
+    : QObject(parent),
+      n_Latency(latency < 0 ? 0 : latency),
+      n_Bandwidth(bandwidth < 0 ? 0 : bandwidth),
+      n_ConnectLatency(connectLatency < 0 ? 0 : connectLatency),
+      m_Server(this)
+{
+    connect(&m_Server, &QTcpServer::newConnection, this, &LocalHttpServer::handleNewConnection);
+    return;
+}
+
+LocalHttpServer::~LocalHttpServer()
+{
+    m_Server.close();
+    return;
+}
+
+bool LocalHttpServer::listen(void)
+{
+    return m_Server.listen(QHostAddress::LocalHost);
+}
+
+QUrl LocalHttpServer::url(const QString &fileName) const
+{
+    return QUrl(QString("http://127.0.0.1:%1/%2").arg(m_Server.serverPort()).arg(fileName));
+}
+
+void LocalHttpServer::addFile(const QString &fileName, const QByteArray &contents)
+{
+    m_Files.insert("/" + fileName, contents);
+    return;
+}
+
+const QByteArray *LocalHttpServer::file(const QString &path) const
+{
+    auto iter = m_Files.constFind(path);
+    return iter == m_Files.constEnd() ? nullptr : &(*iter);
+}
+
+int LocalHttpServer::latency(void) const
+{
+    return n_Latency;
+}
+
+qint64 LocalHttpServer::bandwidth(void) const
+{
+    return n_Bandwidth;
+}
+
+int LocalHttpServer::connectLatency(void) const
+{
+    return n_ConnectLatency;
+}
+
+void LocalHttpServer::handleNewConnection(void)
+{
+    while(m_Server.hasPendingConnections()) {
+        new LocalHttpConnection(m_Server.nextPendingConnection(), this);
+    }
+    return;
+}
+
+LocalHttpConnection::LocalHttpConnection(QTcpSocket *socket, LocalHttpServer *server)
+    : QObject(server),
+      p_Socket(socket),
+      p_Server(server)
+{
+    p_Socket->setParent(this);
+    m_Age.start();
+    m_BandwidthTimer.setInterval(BandwidthInterval);
+    connect(&m_BandwidthTimer, &QTimer::timeout, this, &LocalHttpConnection::sendChunk);
+    connect(p_Socket, &QTcpSocket::readyRead, this, &LocalHttpConnection::handleReadyRead);
+    connect(p_Socket, &QTcpSocket::disconnected, this, &QObject::deleteLater);
+    return;
+}
+
+LocalHttpConnection::~LocalHttpConnection()
+{
+    return;
+}
+
+void LocalHttpConnection::handleReadyRead(void)
+{
+    m_Buffer += p_Socket->readAll();
+    int end = 0;
+    while((end = m_Buffer.indexOf("\r\n\r\n")) != -1) {
+        auto lines = m_Buffer.left(end).split('\n');
+        m_Buffer.remove(0, end + 4);
+
+        auto requestLine = lines.takeFirst().trimmed().split(' ');
+        if(requestLine.size() < 2) {
+            continue;
+        }
+        Request request;
+        request.n_Received = m_Age.elapsed();
+        request.s_Path = QUrl(QString::fromUtf8(requestLine.at(1))).path();
+        for(auto line : lines) {
+            if(line.toLower().startsWith("range:")) {
+                request.m_Range = line.mid(6).trimmed();
+            }
+        }
+        m_Requests.enqueue(request);
+    }
+    respondNext();
+    return;
+}
+
+void LocalHttpConnection::respondNext(void)
+{
+    if(b_Busy || m_Requests.isEmpty()) {
+        return;
+    }
+    b_Busy = true;
+    qint64 handshake = qMax(static_cast<qint64>(0), p_Server->connectLatency() - m_Age.elapsed());
+    QTimer::singleShot(static_cast<int>(handshake) + p_Server->latency(), this, SLOT(respond()));
+    return;
+}
+
+void LocalHttpConnection::respond(void)
+{
+    auto request = m_Requests.dequeue();
+    auto contents = p_Server->file(request.s_Path);
+    QByteArray head;
+    if(!contents) {
+        head = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+        m_Body.clear();
+    } else {
+        qint64 size = contents->size(),
+               from = 0,
+               to = size - 1;
+        bool partial = false;
+        if(request.m_Range.startsWith("bytes=")) {
+            auto range = request.m_Range.mid(6).split('-');
+            from = range.at(0).toLongLong();
+            if(range.size() > 1 && !range.at(1).isEmpty()) {
+                to = qMin(range.at(1).toLongLong(), size - 1);
+            }
+            partial = (from < size && from <= to);
+        }
+
+        if(request.m_Range.isEmpty() || partial) {
+            m_Body = contents->mid(static_cast<int>(from), static_cast<int>(to - from + 1));
+            head = partial ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n";
+            if(partial) {
+                head += "Content-Range: bytes " + QByteArray::number(from) + "-" +
+                        QByteArray::number(to) + "/" + QByteArray::number(size) + "\r\n";
+            }
+        } else {
+            head = "HTTP/1.1 416 Range Not Satisfiable\r\n";
+            m_Body.clear();
+        }
+        head += "Accept-Ranges: bytes\r\n"
+                "Content-Type: application/octet-stream\r\n"
+                "Connection: keep-alive\r\n"
+                "Content-Length: " + QByteArray::number(m_Body.size()) + "\r\n\r\n";
+    }
+
+    emit p_Server->request(request.s_Path, request.m_Range, m_Body.size(), m_Age.elapsed() - request.n_Received);
+    p_Socket->write(head);
+    n_BodyOffset = 0;
+    if(p_Server->bandwidth() > 0) {
+        m_BandwidthTimer.start();
+        sendChunk();
+        return;
+    }
+    p_Socket->write(m_Body);
+    m_Body.clear();
+    b_Busy = false;
+    respondNext();
+    return;
+}
+
+/* Sends the part of the body allowed in one bandwidth interval. */
+void LocalHttpConnection::sendChunk(void)
+{
+    qint64 chunk = qMax(static_cast<qint64>(1), p_Server->bandwidth() * BandwidthInterval / 1000);
+    int size = static_cast<int>(qMin(chunk, static_cast<qint64>(m_Body.size() - n_BodyOffset)));
+    p_Socket->write(m_Body.constData() + n_BodyOffset, size);
+    n_BodyOffset += size;
+    if(n_BodyOffset < m_Body.size()) {
+        return;
+    }
+    m_BandwidthTimer.stop();
+    m_Body.clear();
+    b_Busy = false;
+    respondNext();
+    return;
+}
@@ -0,0 +1,117 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : LocalHttpServer.hpp
+ * @description : A small in-process HTTP/1.1 server with range support ,
+ * configurable latency and bandwidth for the offline benchmarks.
+*/
+#ifndef LOCAL_HTTP_SERVER_HPP_INCLUDED
+#define LOCAL_HTTP_SERVER_HPP_INCLUDED
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QObject>
+#include <QQueue>
+#include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+
+class LocalHttpConnection;
+
+class LocalHttpServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LocalHttpServer(int latency = 0, qint64 bandwidth = 0, int connectLatency = 0,
+                             QObject *parent = nullptr);
+    ~LocalHttpServer();
+
+    bool listen(void);
+    QUrl url(const QString &fileName) const;
+    void addFile(const QString &fileName, const QByteArray &contents);
+    const QByteArray *file(const QString &path) const;
+    int latency(void) const;
+    qint64 bandwidth(void) const;
+    int connectLatency(void) const;
+
+Q_SIGNALS:
+    /*
+     * Emitted when a response is started , bytes is the size of the body and
+     * wait is the time in milliseconds since the request was received.
+    */
+    void request(QString path, QByteArray range, qint64 bytes, qint64 wait);
+
+private Q_SLOTS:
+    void handleNewConnection(void);
+
+private:
+    int n_Latency = 0; /* Milliseconds before every response. */
+    qint64 n_Bandwidth = 0; /* Bytes per second per connection , 0 means unlimited. */
+    int n_ConnectLatency = 0; /* Milliseconds before a new connection is served. */
+    QTcpServer m_Server; /* A child , So it follows the server to other threads. */
+    QHash<QString, QByteArray> m_Files; /* url path -> contents. */
+};
+
+/* One keep alive connection , Pipelined requests are answered in order. */
+class LocalHttpConnection : public QObject
+{
+    Q_OBJECT
+public:
+    LocalHttpConnection(QTcpSocket *socket, LocalHttpServer *server);
+    ~LocalHttpConnection();
+
+private Q_SLOTS:
+    void handleReadyRead(void);
+    void respond(void);
+    void sendChunk(void);
+
+private:
+    void respondNext(void);
+
+    struct Request {
+        QString s_Path;
+        QByteArray m_Range;
+        qint64 n_Received = 0; /* Milliseconds since the connection was accepted. */
+    };
+
+    bool b_Busy = false;
+    QTcpSocket *p_Socket = nullptr;
+    LocalHttpServer *p_Server = nullptr;
+    QByteArray m_Buffer,
+               m_Body;
+    int n_BodyOffset = 0;
+    QQueue<Request> m_Requests;
+    QTimer m_BandwidthTimer;
+    QElapsedTimer m_Age;
+};
+#endif // LOCAL_HTTP_SERVER_HPP_INCLUDED
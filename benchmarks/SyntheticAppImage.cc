@@ -0,0 +1,223 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : SyntheticAppImage.cc
+ * @description : This is where the synthetic AppImage generator is implemented.
+*/
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QLocale>
+#include <QVector>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <random>
+
+#include "SyntheticAppImage.hpp"
+
+static constexpr int HeaderSize = 4096; /* Elf header , section headers and update information. */
+static constexpr int ElfHeaderSize = 64;
+static constexpr int SectionHeaderSize = 64;
+static constexpr int SectionHeaderCount = 3; /* null , .upd_info , .shstrtab */
+static const QByteArray SectionNames = QByteArray("\0.upd_info\0.shstrtab\0", 21);
+
+template <typename T>
+static void put(QByteArray *buffer, int offset, T value)
+{
+    qToLittleEndian<T>(value, reinterpret_cast<uchar*>(buffer->data() + offset));
+    return;
+}
+
+static QByteArray randomBytes(std::mt19937 *generator, qint64 size)
+{
+    QByteArray bytes;
+    bytes.resize(static_cast<int>(size));
+    for(int i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<char>((*generator)() & 0xff);
+    }
+    return bytes;
+}
+
+static void putSectionHeader(QByteArray *buffer, int index, quint32 name, quint32 type,
+                             quint64 offset, quint64 size)
+{
+    int at = ElfHeaderSize + index * SectionHeaderSize;
+    put<quint32>(buffer, at, name);
+    put<quint32>(buffer, at + 4, type);
+    put<quint64>(buffer, at + 24, offset);
+    put<quint64>(buffer, at + 32, size);
+    put<quint64>(buffer, at + 48, 1); /* sh_addralign */
+    return;
+}
+
+/*
+ * A minimal 64 bit elf header with the AppImage type 2 magic and a .upd_info
+ * section , Just enough for the update information reader.
+*/
+QByteArray SyntheticAppImage::header(const QString &updateString)
+{
+    QByteArray updateInformation = updateString.toUtf8();
+    QByteArray header(HeaderSize, 0);
+    const int sectionNamesOffset = ElfHeaderSize + SectionHeaderCount * SectionHeaderSize;
+    const int updateInformationOffset = sectionNamesOffset + SectionNames.size();
+    Q_ASSERT(updateInformationOffset + updateInformation.size() <= HeaderSize);
+
+    const char ident[] = { 0x7f, 'E', 'L', 'F', 2 /* 64 bit */, 1 /* little endian */, 1, 0,
+                           'A', 'I', 2 /* AppImage type 2 */
+                         };
+    memcpy(header.data(), ident, sizeof(ident));
+    put<quint16>(&header, 16, 2);   /* e_type , executable */
+    put<quint16>(&header, 18, 62);  /* e_machine , x86_64 */
+    put<quint32>(&header, 20, 1);   /* e_version */
+    put<quint64>(&header, 40, ElfHeaderSize); /* e_shoff */
+    put<quint16>(&header, 52, ElfHeaderSize); /* e_ehsize */
+    put<quint16>(&header, 58, SectionHeaderSize); /* e_shentsize */
+    put<quint16>(&header, 60, SectionHeaderCount); /* e_shnum */
+    put<quint16>(&header, 62, 2); /* e_shstrndx */
+
+    putSectionHeader(&header, 1, /*name=*/1, /*SHT_PROGBITS=*/1, updateInformationOffset, updateInformation.size());
+    putSectionHeader(&header, 2, /*name=*/11, /*SHT_STRTAB=*/3, sectionNamesOffset, SectionNames.size());
+    memcpy(header.data() + sectionNamesOffset, SectionNames.constData(), SectionNames.size());
+    memcpy(header.data() + updateInformationOffset, updateInformation.constData(), updateInformation.size());
+    return header;
+}
+
+/*
+ * Generates the old version , a header followed by payloadSize bytes of
+ * random data which looks like compressed data to the delta writer.
+ * The same seed always gives the same file.
+*/
+QByteArray SyntheticAppImage::generate(const QString &updateString, qint64 payloadSize, quint32 seed)
+{
+    std::mt19937 generator(seed);
+    return header(updateString) + randomBytes(&generator, payloadSize);
+}
+
+/*
+ * Derives the new version from the old version with the given edit pattern ,
+ * regions is the number of regions the scattered pattern overwrites.
+*/
+QByteArray SyntheticAppImage::edit(const QByteArray &oldVersion, const QString &updateString,
+                                   EditPattern pattern, quint32 seed, qint32 regions)
+{
+    std::mt19937 generator(seed);
+    QByteArray payload = oldVersion.mid(HeaderSize);
+    auto randomOffset = [&]() -> int {
+        return static_cast<int>(generator() % static_cast<quint32>(qMax(1, payload.size())));
+    };
+
+    switch(pattern) {
+    case Insertions: {
+        QVector<int> offsets;
+        for(int i = 0; i < 32; ++i) {
+            offsets.append(randomOffset());
+        }
+        /* Insert from the back so the offsets stay valid. */
+        std::sort(offsets.begin(), offsets.end(), std::greater<int>());
+        for(auto offset : offsets) {
+            payload.insert(offset, randomBytes(&generator, 64 + generator() % 960));
+        }
+        break;
+    }
+    case Shift:
+        payload.prepend(randomBytes(&generator, 777));
+        break;
+    case Scattered:
+        for(int i = 0; i < regions; ++i) {
+            auto bytes = randomBytes(&generator, 16 + generator() % 240);
+            auto offset = randomOffset();
+            payload.replace(offset, qMin(bytes.size(), payload.size() - offset), bytes);
+        }
+        break;
+    case Append:
+        payload.append(randomBytes(&generator, payload.size() / 20));
+        break;
+    }
+    return header(updateString) + payload;
+}
+
+/*
+ * Writes a zsync control file for the given target , just like zsyncmake
+ * with the given sequential matches and bytes of weak checksum and 16 bytes
+ * of strong checksum per block. The target url is relative to the control file.
+*/
+QByteArray SyntheticAppImage::controlFile(const QByteArray &target, const QString &fileName, qint32 blockSize,
+                                          qint32 seqMatches, qint32 weakBytes)
+{
+    QLocale locale(QLocale::English, QLocale::UnitedStates);
+    QByteArray control;
+    control += "zsync: 0.6.2\n";
+    control += "Filename: " + fileName.toUtf8() + "\n";
+    control += "MTime: " + locale.toString(QDateTime::currentDateTimeUtc(), "ddd, dd MMM yyyy HH:mm:ss").toUtf8() + " +0000\n";
+    control += "Blocksize: " + QByteArray::number(blockSize) + "\n";
+    control += "Length: " + QByteArray::number(target.size()) + "\n";
+    control += "Hash-Lengths: " + QByteArray::number(seqMatches) + "," + QByteArray::number(weakBytes) + ",16\n";
+    control += "URL: " + fileName.toUtf8() + "\n";
+    control += "SHA-1: " + QCryptographicHash::hash(target, QCryptographicHash::Sha1).toHex() + "\n";
+    control += "\n";
+
+    QByteArray block;
+    for(int offset = 0; offset < target.size(); offset += blockSize) {
+        /* The last block is zero padded. */
+        block = target.mid(offset, blockSize);
+        block.append(QByteArray(blockSize - block.size(), 0));
+
+        quint16 a = 0, b = 0;
+        for(int i = 0; i < blockSize; ++i) {
+            auto c = static_cast<quint8>(block.at(i));
+            a += c;
+            b += (blockSize - i) * c;
+        }
+        uchar weak[4];
+        qToBigEndian<quint16>(a, weak);
+        qToBigEndian<quint16>(b, weak + 2);
+        /* Short weak checksums keep the last bytes. */
+        control.append(reinterpret_cast<const char*>(weak) + 4 - weakBytes, weakBytes);
+        control += QCryptographicHash::hash(block, QCryptographicHash::Md4);
+    }
+    return control;
+}
+
+QString SyntheticAppImage::patternName(EditPattern pattern)
+{
+    switch(pattern) {
+    case Insertions:
+        return QString("insertions");
+    case Shift:
+        return QString("shift");
+    case Scattered:
+        return QString("scattered");
+    case Append:
+        return QString("append");
+    }
+    return QString();
+}
@@ -0,0 +1,68 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : SyntheticAppImage.hpp
+ * @description : Generates AppImage like file pairs and their zsync control files
+ * for the offline benchmarks.
+*/
+#ifndef SYNTHETIC_APPIMAGE_HPP_INCLUDED
+#define SYNTHETIC_APPIMAGE_HPP_INCLUDED
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+/*
+ * How the new version differs from the old version.
+ * Insertions - short runs of new data inserted at random places.
+ * Shift      - data prepended to the payload , everything after moves by a odd offset.
+ * Scattered  - small regions overwritten in place , 64 unless given.
+ * Append     - new data appended to the end.
+*/
+enum EditPattern : short {
+    Insertions = 0,
+    Shift,
+    Scattered,
+    Append
+};
+
+class SyntheticAppImage
+{
+public:
+    static QByteArray generate(const QString &updateString, qint64 payloadSize, quint32 seed);
+    static QByteArray edit(const QByteArray &oldVersion, const QString &updateString,
+                           EditPattern pattern, quint32 seed, qint32 regions = 64);
+    static QByteArray controlFile(const QByteArray &target, const QString &fileName, qint32 blockSize,
+                                  qint32 seqMatches = 2, qint32 weakBytes = 4);
+    static QString patternName(EditPattern);
+private:
+    static QByteArray header(const QString &updateString);
+};
+#endif // SYNTHETIC_APPIMAGE_HPP_INCLUDED
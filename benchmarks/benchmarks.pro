@@ -0,0 +1,11 @@
+include(../AppImageUpdaterBridge.pri)
+INCLUDEPATH += .
+TEMPLATE = app
+TARGET = AppImageUpdaterBridgeBenchmarks
+CONFIG += release
+
+SOURCES += main.cc \
+           SyntheticAppImage.cc \
+           LocalHttpServer.cc
+HEADERS += SyntheticAppImage.hpp \
+           LocalHttpServer.hpp
@@ -0,0 +1,578 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : main.cc
+ * @description : Offline benchmarks for the delta updater.
+ *
+ * Generates a synthetic AppImage pair for every edit pattern , serves the new
+ * version and its zsync control file from a local http server and updates the
+ * old version with AppImageDeltaRevisioner. Nothing is fetched from the network.
+ *
+ * The first byte column is the wait of the first range request for its
+ * response , With --connect-latency every new connection stands in for the
+ * handshakes of a remote host so the connections opened during the seed scan
+ * show up there. The server is plain HTTP/1.1 , So TLS , ALPN and HTTP/2 are
+ * not measured , Neither is the missing https warm up with Qt 5.10 to 5.12.
+ *
+ * With --kernels the seed scan kernel is measured alone , without any I/O , for
+ * every seq_matches , weak checksum length and block size it is specialized
+ * for , against a old version which shares nothing with the new version.
+ *
+ * With --sha1 the SHA1 hashing is measured at both of its call sites , hashing
+ * the AppImage in getInfo and verifying the new version in the writer.
+ *
+ * With --cached-check the latency the revisioner adds to a repeated check
+ * for update is measured , everything is cached after the first check.
+ *
+ * With --ranges N the scattered pattern overwrites N regions , So about N block
+ * ranges are requested , Over pipelined HTTP/1.1 and over HTTP/2. Qt only
+ * negotiates HTTP/2 with ALPN over TLS , which the local server does not speak ,
+ * so the HTTP/2 run is reported as skipped.
+ *
+ * Example:
+ * 	$ ./AppImageUpdaterBridgeBenchmarks --size 64 --latency 30 --bandwidth 4096 --pattern shift
+ * 	$ ./AppImageUpdaterBridgeBenchmarks --latency 30 --connect-latency 90 --pattern append
+ * 	$ ./AppImageUpdaterBridgeBenchmarks --size 256 --latency 0 --bandwidth 122070 --threading all
+ * 	$ ./AppImageUpdaterBridgeBenchmarks --kernels --size 64
+ * 	$ ./AppImageUpdaterBridgeBenchmarks --sha1 --size 256
+ * 	$ ./AppImageUpdaterBridgeBenchmarks --cached-check
+ * 	$ ./AppImageUpdaterBridgeBenchmarks --ranges 1000 --latency 30
+*/
+#include <QBuffer>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <AppImageUpdaterBridge>
+#include <atomic>
+
+#include "LocalHttpServer.hpp"
+#include "SyntheticAppImage.hpp"
+#include "../include/sha1hasher_p.hpp"
+#include "../include/zsyncwriter_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+static const QString TargetFileName = QString("Synthetic-latest-x86_64.AppImage");
+
+struct BenchmarkResult {
+    bool b_Succeeded = false;
+    double n_SeedScanSpeed = 0; /* MB/s */
+    qint64 n_BytesDownloaded = 0,
+           n_Requests = 0,
+           n_FirstByte = -1, /* Milliseconds the first range request waited for its response. */
+           n_Time = 0; /* Milliseconds from start to finished. */
+};
+
+static BenchmarkResult runBenchmark(EditPattern pattern, qint64 payloadSize, qint32 blockSize,
+                                    int latency, qint64 bandwidth, int connectLatency,
+                                    ThreadingMode threadingMode, qint32 regions = 64)
+{
+    BenchmarkResult result;
+    QTemporaryDir workingDirectory;
+    LocalHttpServer server(latency, bandwidth, connectLatency);
+    if(!workingDirectory.isValid() || !server.listen()) {
+        return result;
+    }
+
+    QString updateString = "zsync|" + server.url(TargetFileName + ".zsync").toString();
+    QByteArray oldVersion = SyntheticAppImage::generate(updateString, payloadSize, /*seed=*/1),
+               newVersion = SyntheticAppImage::edit(oldVersion, updateString, pattern, /*seed=*/2, regions);
+    server.addFile(TargetFileName, newVersion);
+    server.addFile(TargetFileName + ".zsync", SyntheticAppImage::controlFile(newVersion, TargetFileName, blockSize));
+
+    QString oldVersionPath = workingDirectory.path() + "/Synthetic-x86_64.AppImage";
+    {
+        QFile file(oldVersionPath);
+        if(!file.open(QIODevice::WriteOnly) || file.write(oldVersion) != oldVersion.size()) {
+            return result;
+        }
+        file.setPermissions(file.permissions() | QFileDevice::ExeUser);
+    }
+    QDir(workingDirectory.path()).mkdir("output");
+
+    QElapsedTimer clock;
+    std::atomic<qint64> seedScanStarted(-1);
+    qint64 firstRequest = -1;
+    QObject::connect(&server, &LocalHttpServer::request, [&](QString path, QByteArray range, qint64 bytes, qint64 wait) {
+        Q_UNUSED(range);
+        /* The range probe of the control file parser comes before the seed scan. */
+        if(path != "/" + TargetFileName || seedScanStarted.load() < 0) {
+            return;
+        }
+        if(firstRequest < 0) {
+            firstRequest = clock.elapsed();
+            result.n_FirstByte = wait;
+        }
+        ++result.n_Requests;
+        result.n_BytesDownloaded += bytes;
+    });
+
+    AppImageDeltaRevisioner revisioner(oldVersionPath, threadingMode);
+    revisioner.setOutputDirectory(workingDirectory.path() + "/output");
+
+    QEventLoop loop;
+    QObject::connect(&revisioner, &AppImageDeltaRevisioner::started, [&]() {
+        seedScanStarted.store(clock.elapsed());
+    });
+    QObject::connect(&revisioner, &AppImageDeltaRevisioner::finished, &loop, [&]() {
+        result.b_Succeeded = true;
+        loop.quit();
+    }, Qt::QueuedConnection);
+    QObject::connect(&revisioner, &AppImageDeltaRevisioner::error, &loop, [&](short errorCode) {
+        QTextStream(stderr) << "error: " << errorCodeToString(errorCode) << "\n";
+        loop.quit();
+    }, Qt::QueuedConnection);
+    QTimer::singleShot(10 * 60 * 1000, &loop, SLOT(quit()));
+
+    clock.start();
+    revisioner.start();
+    loop.exec();
+    result.n_Time = clock.elapsed();
+
+    qint64 scanEnd = firstRequest < 0 ? result.n_Time : firstRequest,
+           scanTime = scanEnd - seedScanStarted.load();
+    if(seedScanStarted.load() >= 0 && scanTime > 0) {
+        result.n_SeedScanSpeed = (oldVersion.size() / (1024.0 * 1024.0)) / (scanTime / 1000.0);
+    }
+    return result;
+}
+
+/*
+ * Returns the total duration of the events with the given name in the given
+ * trace file in microseconds , Only events of the given file are counted if
+ * a absolute path is given. Returns a negative value if there is none.
+*/
+static double traceDuration(const QString &traceFile, const QString &name,
+                            const QString &absolutePath = QString())
+{
+    QFile file(traceFile);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    double duration = 0;
+    for(auto event : QJsonDocument::fromJson(file.readAll()).object()["traceEvents"].toArray()) {
+        auto object = event.toObject();
+        if(object["name"].toString() == name &&
+           (absolutePath.isEmpty() || object["args"].toObject()["AbsolutePath"].toString() == absolutePath)) {
+            duration += object["dur"].toDouble();
+        }
+    }
+    return duration > 0 ? duration : -1;
+}
+
+/*
+ * Measures the seed scan of a update plan with the given control file
+ * parameters , Returns the scan speed in MB/s or a negative value on failure.
+ * The scan time is taken from the SeedScan event of the trace file so the
+ * update information and control file stages are not counted.
+*/
+/*
+ * Times the scan kernel alone , The writer is configured for a dry run from
+ * the control file and given the old version from memory. The best of a few
+ * runs is taken since nothing else is measured.
+*/
+static double runKernelBenchmark(qint32 seqMatches, qint32 weakBytes, qint64 payloadSize, qint32 blockSize)
+{
+    const int runs = 3;
+    QString updateString = "zsync|http://127.0.0.1/" + TargetFileName + ".zsync";
+    QByteArray oldVersion = SyntheticAppImage::generate(updateString, payloadSize, /*seed=*/1),
+               newVersion = SyntheticAppImage::generate(updateString, payloadSize, /*seed=*/3),
+               control = SyntheticAppImage::controlFile(newVersion, TargetFileName, blockSize, seqMatches, weakBytes);
+    /* The block checksums follow the empty line after the headers. */
+    QByteArray checkSumBlocks = control.mid(control.indexOf("\n\n") + 2);
+    qint32 blocks = (newVersion.size() + blockSize - 1) / blockSize;
+
+    qint64 best = -1;
+    for(int run = 0; run < runs; ++run) {
+        ZsyncWriterPrivate writer;
+        writer.setDryRun(true);
+        auto buffer = new QBuffer;
+        buffer->setData(checkSumBlocks);
+        writer.setConfiguration(blockSize, blocks, weakBytes, /*strongChecksumBytes=*/16, seqMatches,
+                                newVersion.size(), QString(), TargetFileName, QString(), QUrl(), buffer, true);
+
+        QElapsedTimer clock;
+        clock.start();
+        if(writer.scanSeedData(oldVersion) < 0) {
+            return -1;
+        }
+        qint64 elapsed = clock.nsecsElapsed();
+        best = (best < 0) ? elapsed : qMin(best, elapsed);
+    }
+    if(best <= 0) {
+        return -1;
+    }
+    return (oldVersion.size() / (1024.0 * 1024.0)) / (best / 1000000000.0);
+}
+
+static int runKernelBenchmarks(qint64 payloadSize)
+{
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4\n")
+        .arg("seq_matches", -12)
+        .arg("weak bytes", 12)
+        .arg("block size", 12)
+        .arg("seed scan MB/s", 16);
+
+    int failed = 0;
+    for(qint32 seqMatches : { 1, 2 }) {
+        for(qint32 weakBytes : { 2, 3, 4 }) {
+            /* 8 KiB has no instance of its own , it shows the generic kernel. */
+            for(qint32 blockSize : { 1024, 2048, 4096, 8192 }) {
+                double speed = runKernelBenchmark(seqMatches, weakBytes, payloadSize, blockSize);
+                if(speed < 0) {
+                    ++failed;
+                }
+                out << QString("%1 %2 %3 %4\n")
+                    .arg(seqMatches, -12)
+                    .arg(weakBytes, 12)
+                    .arg(blockSize, 12)
+                    .arg(speed < 0 ? QString("failed") : QString::number(speed, 'f', 1), 16);
+                out.flush();
+            }
+        }
+    }
+    return failed;
+}
+
+/*
+ * Updates a AppImage whose new version only appends to it and measures the SHA1
+ * hashing at both of its call sites from the trace file , i.e hashing the AppImage
+ * in AppImageUpdateInformationPrivate::getInfo and verifying the new version in
+ * ZsyncWriterPrivate::verifyAndConstructTargetFile.
+*/
+static int runSha1Benchmark(qint64 payloadSize, qint32 blockSize)
+{
+    QTextStream out(stdout);
+    QTemporaryDir workingDirectory;
+    LocalHttpServer server(/*latency=*/0, /*bandwidth=*/0);
+    if(!workingDirectory.isValid() || !server.listen()) {
+        return 1;
+    }
+
+    QString updateString = "zsync|" + server.url(TargetFileName + ".zsync").toString();
+    QByteArray oldVersion = SyntheticAppImage::generate(updateString, payloadSize, /*seed=*/1),
+               newVersion = SyntheticAppImage::edit(oldVersion, updateString, Append, /*seed=*/2);
+    server.addFile(TargetFileName, newVersion);
+    server.addFile(TargetFileName + ".zsync", SyntheticAppImage::controlFile(newVersion, TargetFileName, blockSize));
+
+    QString oldVersionPath = workingDirectory.path() + "/Synthetic-x86_64.AppImage",
+            traceFile = workingDirectory.path() + "/sha1.trace.json";
+    {
+        QFile file(oldVersionPath);
+        if(!file.open(QIODevice::WriteOnly) || file.write(oldVersion) != oldVersion.size()) {
+            return 1;
+        }
+        file.setPermissions(file.permissions() | QFileDevice::ExeUser);
+    }
+    QDir(workingDirectory.path()).mkdir("output");
+
+    bool succeeded = false;
+    AppImageDeltaRevisioner revisioner(oldVersionPath, SeparateNetworkThread);
+    revisioner.setOutputDirectory(workingDirectory.path() + "/output");
+    revisioner.setTraceFile(traceFile);
+    QEventLoop loop;
+    QObject::connect(&revisioner, &AppImageDeltaRevisioner::finished, &loop, [&]() {
+        succeeded = true;
+        loop.quit();
+    }, Qt::QueuedConnection);
+    QObject::connect(&revisioner, &AppImageDeltaRevisioner::error, &loop, [&](short errorCode) {
+        QTextStream(stderr) << "error: " << errorCodeToString(errorCode) << "\n";
+        loop.quit();
+    }, Qt::QueuedConnection);
+    QTimer::singleShot(10 * 60 * 1000, &loop, SLOT(quit()));
+    revisioner.start();
+    loop.exec();
+    revisioner.setTraceFile(QString());
+    if(!succeeded) {
+        return 1;
+    }
+
+    struct CallSite {
+        const char *name,
+                   *event;
+        qint64 bytes;
+    };
+    const CallSite callSites[] = {
+        { "getInfo", "AppImageSHA1Hash", oldVersion.size() },
+        { "verifyAndConstructTargetFile", "VerifyTargetFile", newVersion.size() }
+    };
+
+    int failed = 0;
+    out << QString("%1 %2 (hardware accelerated: %3)\n")
+        .arg("call site", -30)
+        .arg("SHA1 GB/s", 12)
+        .arg(Sha1HasherPrivate::isHardwareAccelerated() ? "yes" : "no");
+    for(auto callSite : callSites) {
+        double duration = traceDuration(traceFile, callSite.event);
+        if(duration < 0) {
+            ++failed;
+        }
+        out << QString("%1 %2\n")
+            .arg(callSite.name, -30)
+            .arg(duration < 0 ? QString("failed") :
+                 QString::number((callSite.bytes / (1024.0 * 1024.0 * 1024.0)) / (duration / 1000000.0), 'f', 2), 12);
+    }
+    return failed;
+}
+
+/*
+ * Checks a AppImage for update once and then measures the following checks ,
+ * After the first check the update information and the control file are
+ * cached , So this is the latency added by the revisioner itself from
+ * checkForUpdate to updateAvailable.
+*/
+static int runCachedCheckBenchmark(qint64 payloadSize, qint32 blockSize, ThreadingMode threadingMode)
+{
+    const int checks = 100;
+    QTextStream out(stdout);
+    QTemporaryDir workingDirectory;
+    LocalHttpServer server(/*latency=*/0, /*bandwidth=*/0);
+    if(!workingDirectory.isValid() || !server.listen()) {
+        return 1;
+    }
+
+    QString updateString = "zsync|" + server.url(TargetFileName + ".zsync").toString();
+    QByteArray oldVersion = SyntheticAppImage::generate(updateString, payloadSize, /*seed=*/1),
+               newVersion = SyntheticAppImage::edit(oldVersion, updateString, Append, /*seed=*/2);
+    server.addFile(TargetFileName, newVersion);
+    server.addFile(TargetFileName + ".zsync", SyntheticAppImage::controlFile(newVersion, TargetFileName, blockSize));
+
+    QString oldVersionPath = workingDirectory.path() + "/Synthetic-x86_64.AppImage";
+    {
+        QFile file(oldVersionPath);
+        if(!file.open(QIODevice::WriteOnly) || file.write(oldVersion) != oldVersion.size()) {
+            return 1;
+        }
+        file.setPermissions(file.permissions() | QFileDevice::ExeUser);
+    }
+
+    bool succeeded = false;
+    AppImageDeltaRevisioner revisioner(oldVersionPath, threadingMode);
+    QEventLoop loop;
+    QObject::connect(&revisioner, &AppImageDeltaRevisioner::updateAvailable, &loop, [&]() {
+        succeeded = true;
+        loop.quit();
+    }, Qt::QueuedConnection);
+    QObject::connect(&revisioner, &AppImageDeltaRevisioner::error, &loop, [&](short errorCode) {
+        QTextStream(stderr) << "error: " << errorCodeToString(errorCode) << "\n";
+        loop.quit();
+    }, Qt::QueuedConnection);
+
+    QTimer timeout;
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, &QTimer::timeout, &loop, &QEventLoop::quit);
+
+    QElapsedTimer clock;
+    qint64 best = -1,
+           total = 0;
+    for(int check = 0; check <= checks; ++check) {
+        succeeded = false;
+        timeout.start(60 * 1000);
+        clock.start();
+        revisioner.checkForUpdate();
+        loop.exec();
+        qint64 elapsed = clock.nsecsElapsed() / 1000;
+        if(!succeeded) {
+            return 1;
+        }
+        /* The first check fills the caches. */
+        if(check > 0) {
+            total += elapsed;
+            best = (best < 0) ? elapsed : qMin(best, elapsed);
+        }
+    }
+
+    out << QString("%1 %2 %3\n")
+        .arg("checks", -10)
+        .arg("mean us", 12)
+        .arg("best us", 12);
+    out << QString("%1 %2 %3\n")
+        .arg(checks, -10)
+        .arg(total / checks, 12)
+        .arg(best, 12);
+    return 0;
+}
+
+/*
+ * Updates a AppImage with the given number of scattered regions overwritten ,
+ * So the time is mostly spent on issuing the block range requests.
+*/
+static int runRangesBenchmark(qint32 regions, qint64 payloadSize, qint32 blockSize, int latency,
+                              qint64 bandwidth, int connectLatency, const QList<ThreadingMode> &threadingModes)
+{
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4 %5 %6\n")
+        .arg("protocol", -18)
+        .arg("threading", -10)
+        .arg("requests", 10)
+        .arg("downloaded bytes", 18)
+        .arg("first byte ms", 14)
+        .arg("time ms", 10);
+
+    int failed = 0;
+    for(auto threadingMode : threadingModes) {
+        QString threading = threadingMode == SingleThreaded ? "single" :
+                            threadingMode == SharedThread ? "shared" : "separate";
+        auto result = runBenchmark(Scattered, payloadSize, blockSize, latency, bandwidth,
+                                   connectLatency, threadingMode, regions);
+        if(!result.b_Succeeded) {
+            ++failed;
+            out << QString("%1 %2 failed\n").arg("http/1.1 pipelined", -18).arg(threading, -10);
+            continue;
+        }
+        out << QString("%1 %2 %3 %4 %5 %6\n")
+            .arg("http/1.1 pipelined", -18)
+            .arg(threading, -10)
+            .arg(result.n_Requests, 10)
+            .arg(result.n_BytesDownloaded, 18)
+            .arg(result.n_FirstByte, 14)
+            .arg(result.n_Time, 10);
+        out << QString("%1 %2 skipped , the local server has no TLS to negotiate h2 with ALPN\n")
+            .arg("h2", -18)
+            .arg(threading, -10);
+        out.flush();
+    }
+    return failed;
+}
+
+int main(int ac, char **av)
+{
+    QCoreApplication app(ac, av);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Offline benchmarks for AppImageUpdaterBridge.");
+    parser.addHelpOption();
+    parser.addOptions({
+        { "size", "Payload size of the synthetic AppImage in MiB.", "MiB", "32" },
+        { "block-size", "Block size of the zsync control file.", "bytes", "2048" },
+        { "latency", "Latency of every http response.", "ms", "20" },
+        { "bandwidth", "Bandwidth per connection , 0 is unlimited.", "KiB/s", "0" },
+        { "connect-latency", "Handshake time of every new connection.", "ms", "0" },
+        { "pattern", "insertions , shift , scattered , append or all.", "pattern", "all" },
+        { "threading", "single , shared , separate or all.", "mode", "separate" },
+        { "kernels", "Measure the seed scan kernel of every configuration instead." },
+        { "sha1", "Measure the SHA1 hashing at its call sites instead." },
+        { "cached-check", "Measure the latency of a repeated check for update instead." },
+        { "ranges", "Measure a update which requests about this many block ranges instead.", "N" }
+    });
+    parser.process(app);
+
+    qint64 payloadSize = parser.value("size").toLongLong() * 1024 * 1024;
+    qint32 blockSize = parser.value("block-size").toInt();
+    int latency = parser.value("latency").toInt();
+    qint64 bandwidth = parser.value("bandwidth").toLongLong() * 1024;
+    int connectLatency = parser.value("connect-latency").toInt();
+    QList<ThreadingMode> threadingModes { SeparateNetworkThread };
+    if(parser.value("threading") == "single") {
+        threadingModes = { SingleThreaded };
+    } else if(parser.value("threading") == "shared") {
+        threadingModes = { SharedThread };
+    } else if(parser.value("threading") == "all") {
+        threadingModes = { SingleThreaded, SharedThread, SeparateNetworkThread };
+    }
+
+    QList<EditPattern> patterns { Insertions, Shift, Scattered, Append };
+    if(parser.value("pattern") != "all") {
+        QList<EditPattern> selected;
+        for(auto pattern : patterns) {
+            if(SyntheticAppImage::patternName(pattern) == parser.value("pattern")) {
+                selected << pattern;
+            }
+        }
+        patterns = selected;
+    }
+    if(patterns.isEmpty() || payloadSize <= 0 || blockSize <= 0 || (blockSize & (blockSize - 1))) {
+        parser.showHelp(-1);
+    }
+
+    if(parser.isSet("kernels")) {
+        return runKernelBenchmarks(payloadSize);
+    }
+    if(parser.isSet("sha1")) {
+        return runSha1Benchmark(payloadSize, blockSize);
+    }
+    if(parser.isSet("cached-check")) {
+        return runCachedCheckBenchmark(payloadSize, blockSize, threadingModes.first());
+    }
+    if(parser.isSet("ranges")) {
+        qint32 regions = parser.value("ranges").toInt();
+        if(regions <= 0) {
+            parser.showHelp(-1);
+        }
+        return runRangesBenchmark(regions, payloadSize, blockSize, latency, bandwidth,
+                                  connectLatency, threadingModes);
+    }
+
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+        .arg("pattern", -12)
+        .arg("threading", -10)
+        .arg("seed scan MB/s", 16)
+        .arg("downloaded bytes", 18)
+        .arg("requests", 10)
+        .arg("first byte ms", 14)
+        .arg("time ms", 10);
+
+    int failed = 0;
+    for(auto pattern : patterns) {
+        for(auto threadingMode : threadingModes) {
+            QString threading = threadingMode == SingleThreaded ? "single" :
+                                threadingMode == SharedThread ? "shared" : "separate";
+            auto result = runBenchmark(pattern, payloadSize, blockSize, latency, bandwidth,
+                                       connectLatency, threadingMode);
+            if(!result.b_Succeeded) {
+                ++failed;
+                out << QString("%1 %2 failed\n").arg(SyntheticAppImage::patternName(pattern), -12).arg(threading, -10);
+                continue;
+            }
+            out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+                .arg(SyntheticAppImage::patternName(pattern), -12)
+                .arg(threading, -10)
+                .arg(result.n_SeedScanSpeed, 16, 'f', 1)
+                .arg(result.n_BytesDownloaded, 18)
+                .arg(result.n_Requests, 10)
+                .arg(result.n_FirstByte, 14)
+                .arg(result.n_Time, 10);
+            out.flush();
+        }
+    }
+    return failed;
+}
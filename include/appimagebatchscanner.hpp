@@ -0,0 +1,76 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : appimagebatchscanner.hpp
+ * @description : This is where the batch scanner is described.
+ * The batch scanner extracts the embeded update information and the
+ * SHA1 hash of many AppImages in parallel on a thread pool and reports
+ * every AppImage as soon as it is scanned.
+*/
+#ifndef APPIMAGE_BATCH_SCANNER_HPP_INCLUDED
+#define APPIMAGE_BATCH_SCANNER_HPP_INCLUDED
+#include <QObject>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+namespace AppImageUpdaterBridge
+{
+class AppImageBatchScannerPrivate;
+
+class AppImageBatchScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AppImageBatchScanner(int maxConcurrentReads = 0, QObject *parent = nullptr);
+    ~AppImageBatchScanner();
+
+public Q_SLOTS:
+    void scanDirectory(const QString&);
+    void scanAppImages(const QStringList&);
+    void setMaxConcurrentReads(int);
+    void setCalculateSha1Hash(bool);
+    void cancel(void);
+Q_SIGNALS:
+    void started(void);
+    void canceled(void);
+    void finished(void);
+    void appImageScanned(QJsonObject);
+    void scanError(QString, short);
+    void progress(int, int);
+
+private:
+    void connectSignals();
+    AppImageBatchScannerPrivate *p_BatchScanner = nullptr;
+};
+}
+
+#endif // APPIMAGE_BATCH_SCANNER_HPP_INCLUDED
@@ -0,0 +1,84 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : appimagebatchscanner_p.hpp
+ * @description : This is where the private batch scanner is described.
+*/
+#ifndef APPIMAGE_BATCH_SCANNER_PRIVATE_HPP_INCLUDED
+#define APPIMAGE_BATCH_SCANNER_PRIVATE_HPP_INCLUDED
+#include <QAtomicInt>
+#include <QJsonObject>
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include "appimageupdaterbridge_enums.hpp"
+
+namespace AppImageUpdaterBridge
+{
+class AppImageBatchScannerPrivate : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AppImageBatchScannerPrivate(int maxConcurrentReads = 0, QObject *parent = nullptr);
+    ~AppImageBatchScannerPrivate();
+
+public Q_SLOTS:
+    void scanDirectory(const QString&);
+    void scanAppImages(const QStringList&);
+    void setMaxConcurrentReads(int);
+    void setCalculateSha1Hash(bool);
+    void cancel(void);
+
+private Q_SLOTS:
+    void handleScanResult(int, QString, short, QJsonObject);
+
+Q_SIGNALS:
+    void started(void);
+    void canceled(void);
+    void finished(void);
+    void appImageScanned(QJsonObject);
+    void scanError(QString, short);
+    void progress(int, int);
+private:
+    void enqueue(const QString&, bool);
+
+    bool b_CalculateSha1Hash = true;
+    int n_Scanned = 0,
+        n_Total = 0;
+    QAtomicInt n_Generation; /* Incremented on cancel , stale results are dropped. */
+    QScopedPointer<QThreadPool> p_ThreadPool;
+};
+}
+
+#endif // APPIMAGE_BATCH_SCANNER_PRIVATE_HPP_INCLUDED
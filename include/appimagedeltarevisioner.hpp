@@ -44,12 +44,38 @@
 #include <QObject>
 #include <QJsonObject>
 #include <QString>
+#include <QStringList>
 #include <QFile>
 
+#include "appimageupdaterbridge_enums.hpp"
+
 namespace AppImageUpdaterBridge
 {
 class AppImageDeltaRevisionerPrivate;
 
+/* Options for the blocking API. */
+struct UpdateOptions {
+    QString appImagePath; /* Guessed just like the constructors do if empty. */
+    QString outputDirectory;
+    QNetworkProxy proxy;
+    bool useProxy = false;
+    bool showLog = false;
+    ThreadingMode threadingMode = SeparateNetworkThread;
+    int timeout = -1; /* In milliseconds , -1 waits forever. */
+};
+
+/* Result of the blocking API. */
+struct UpdateResult {
+    short errorCode = NoError;
+    bool canceled = false;
+    bool updateAvailable = false;
+    QString oldVersionPath,
+            newVersionPath,
+            sha1Hash,
+            remoteSha1Hash,
+            releaseNotes;
+};
+
 class AppImageDeltaRevisioner : public QObject
 {
     Q_OBJECT
@@ -57,18 +83,45 @@ public:
     explicit AppImageDeltaRevisioner(bool singleThreaded = true, QObject *parent = nullptr);
     explicit AppImageDeltaRevisioner(const QString&, bool singleThreaded = true, QObject *parent = nullptr);
     explicit AppImageDeltaRevisioner(QFile *, bool singleThreaded = true, QObject *parent = nullptr);
+    explicit AppImageDeltaRevisioner(ThreadingMode, QObject *parent = nullptr);
+    AppImageDeltaRevisioner(const QString&, ThreadingMode, QObject *parent = nullptr);
+    AppImageDeltaRevisioner(QFile *, ThreadingMode, QObject *parent = nullptr);
     ~AppImageDeltaRevisioner();
 
+    /*
+     * Usable from a plain main() , A QCoreApplication is created for the
+     * process if there is none. errorCode is NoCoreApplication only if the
+     * QCoreApplication of the process is being or was already destroyed.
+     * On timeout errorCode is TimeoutError , returned right after the cancel
+     * even if a stage like a stalled AppImage read cannot be interrupted.
+    */
+    static UpdateResult checkForUpdateBlocking(const UpdateOptions &options = UpdateOptions());
+    static UpdateResult updateBlocking(const UpdateOptions &options = UpdateOptions());
+    static bool importMatchCache(const QString&, const QString &directory);
+    static bool exportMatchCache(const QString&, const QString&, const QString&,
+                                 const QString &directory);
+
 public Q_SLOTS:
     void start(void);
     void cancel(void);
     void setAppImage(const QString&);
     void setAppImage(QFile*);
     void setShowLog(bool);
+    void setLogCapture(bool);
+    void getCapturedLog(void);
     void setOutputDirectory(const QString&);
+    void addSeedFile(const QString&);
+    void addSeedDirectory(const QString&);
+    void clearSeedFiles(void);
+    void setBlockStore(const QString&, qint64 maxSize = 268435456);
+    void setMatchCache(const QString&);
     void setProxy(const QNetworkProxy&);
     void getAppImageEmbededInformation(void);
     void checkForUpdate(void);
+    void planUpdate(void);
+    void getStatistics(void);
+    void setTraceFile(const QString&);
+    void setProgressInterval(int);
     void clear(void);
 Q_SIGNALS:
     void started(void);
@@ -76,10 +129,18 @@ Q_SIGNALS:
     void finished(QJsonObject, QString);
     void embededInformation(QJsonObject);
     void updateAvailable(bool, QJsonObject);
+    void updatePlan(QJsonObject);
+    void statistics(QJsonObject);
     void statusChanged(short);
     void error(short);
     void progress(int, qint64, qint64, double, QString);
+    void remainingTime(qint64);
     void logger(QString, QString);
+    void capturedLog(QStringList);
+
+protected:
+    void connectNotify(const QMetaMethod&) override;
+    void disconnectNotify(const QMetaMethod&) override;
 
 private:
     void connectSignals();
@@ -46,20 +46,26 @@
 #define APPIMAGE_DELTA_REVISIONER_PRIVATE_HPP_INCLUDED
 #include <QFile>
 #include <QtGlobal>
+#include <QJsonArray>
 #include <QJsonObject>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkProxy>
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QScopedPointer>
+#include <QSharedPointer>
 #include <QThread>
+#include <QThreadPool>
 
 #include "appimageupdaterbridge_enums.hpp"
 #include "appimageupdateinformation_p.hpp"
 #include "zsyncremotecontrolfileparser_p.hpp"
 #include "zsyncwriter_p.hpp"
 #include "zsyncblockrangedownloader_p.hpp"
+#include "zsyncrequestlimiter_p.hpp"
+#include "zsyncprogressaggregator_p.hpp"
 
 namespace AppImageUpdaterBridge
 {
@@ -70,6 +76,14 @@ public:
     explicit AppImageDeltaRevisionerPrivate(bool singleThreaded = true, QObject *parent = nullptr);
     explicit AppImageDeltaRevisionerPrivate(const QString&, bool singleThreaded = true, QObject *parent = nullptr);
     explicit AppImageDeltaRevisionerPrivate(QFile *, bool singleThreaded = true, QObject *parent = nullptr);
+    explicit AppImageDeltaRevisionerPrivate(ThreadingMode, QObject *parent = nullptr);
+    AppImageDeltaRevisionerPrivate(const QString&, ThreadingMode, QObject *parent = nullptr);
+    AppImageDeltaRevisionerPrivate(QFile *, ThreadingMode, QObject *parent = nullptr);
+    AppImageDeltaRevisionerPrivate(QNetworkAccessManager*, QThread *networkThread, QThread *workerThread,
+                                   ZsyncRequestLimiterPrivate *requestLimiter = nullptr,
+                                   ZsyncRequestLimiterPrivate *seedScanLimiter = nullptr,
+                                   QThreadPool *workerPool = nullptr,
+                                   QObject *parent = nullptr);
     ~AppImageDeltaRevisionerPrivate();
 
 public Q_SLOTS:
@@ -78,19 +92,32 @@ public Q_SLOTS:
     void setAppImage(const QString&);
     void setAppImage(QFile*);
     void setShowLog(bool);
+    void setLogCapture(bool);
+    void getCapturedLog(void);
     void setOutputDirectory(const QString&);
+    void addSeedFile(const QString&);
+    void addSeedDirectory(const QString&);
+    void clearSeedFiles(void);
+    void setBlockStore(const QString&, qint64);
+    void setMatchCache(const QString&);
     void setProxy(const QNetworkProxy&);
     void getAppImageEmbededInformation(void);
     void checkForUpdate(void);
+    void planUpdate(void);
+    void getStatistics(void);
+    void setTraceFile(const QString&);
+    void setProgressInterval(int);
+    void setLoggerConnected(bool);
     void clear(void);
 
 private Q_SLOTS:
-    void doStart(QJsonObject);
-    void resetConnections();
-    void handleBlockDownloaderStarted(void); 
-    void handleBlockDownloaderFinished(void);
+    void resetState(void);
     void handleIndeterminateProgress(int);
+    void handlePartialInformation(QJsonObject);
     void handleUpdateCheckInformation(QJsonObject);
+    void handleEmbededInformation(QJsonObject);
+    void handlePlan(QJsonObject);
+    void handleWriterConfigured(void);
 
 Q_SIGNALS:
     void started(void);
@@ -98,17 +125,63 @@ Q_SIGNALS:
     void finished(QJsonObject, QString);
     void embededInformation(QJsonObject);
     void updateAvailable(bool, QJsonObject);
+    void updatePlan(QJsonObject);
+    void statistics(QJsonObject);
     void statusChanged(short);
     void error(short);
     void progress(int, qint64, qint64, double, QString);
+    void remainingTime(qint64);
     void logger(QString, QString);
+    void capturedLog(QStringList);
+
+    /* Internal requests to the stages. */
+    void requestEmbededInformation(void);
+    void requestControlFile(QJsonObject);
+    void requestZsyncInformation(void);
 private:
-    bool b_Busy = false;
+    enum : short {
+        NoOperation = 0,
+        EmbededInformationOperation,
+        UpdateCheckOperation,
+        UpdateOperation,
+        PlanOperation
+    };
+
+    /* Typed results of the stages. */
+    struct LocalInformation {
+        bool b_Available = false;
+        QString s_AppImagePath,
+                s_Sha1Hash;
+    };
+    struct RemoteInformation {
+        bool b_Available = false;
+        QString s_Sha1Hash,
+                s_ReleaseNotes;
+    };
+
+    void beginOperation(short);
+    void advance(void);
+    void cancelStages(void);
+
+    void init(QNetworkAccessManager*, QThread*, QThread*,
+              ZsyncRequestLimiterPrivate *requestLimiter = nullptr,
+              ZsyncRequestLimiterPrivate *seedScanLimiter = nullptr,
+              QThreadPool *workerPool = nullptr);
+
+    bool b_Busy = false,
+         b_WriterStarted = false; /* The writer and the downloader emit canceled from here on. */
+    short n_Operation = NoOperation;
+    QString s_TraceFile; /* Written when a operation ends , empty if not tracing. */
+    LocalInformation m_LocalInformation; /* Local AppImage path and SHA1 hash. */
+    RemoteInformation m_RemoteInformation; /* Remote SHA1 hash and release notes. */
     QScopedPointer<AppImageUpdateInformationPrivate> p_UpdateInformation;
     QScopedPointer<ZsyncRemoteControlFileParserPrivate> p_ControlFileParser;
     QScopedPointer<ZsyncWriterPrivate> p_DeltaWriter;
     QScopedPointer<ZsyncBlockRangeDownloaderPrivate> p_BlockDownloader;
+    QSharedPointer<ZsyncProgressAggregatorPrivate> p_Progress; /* Lives in this thread , shared with the writer and the downloader. */
     QScopedPointer<QThread> p_SharedThread;
+    QScopedPointer<QThread> p_NetworkThread; /* Only with SeparateNetworkThread. */
+    QNetworkAccessManager *p_NetworkAccessManager = nullptr; /* Not owned if given to the constructor. */
     QScopedPointer<QNetworkAccessManager> p_SharedNetworkAccessManager;
 };
 }
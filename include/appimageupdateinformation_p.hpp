@@ -44,32 +44,43 @@
 #include <QJsonObject>
 #include <QObject>
 #include <QScopedPointer>
+#include <QSharedPointer>
 #include <QString>
+#include <QThreadPool>
 
 #include "appimageupdaterbridge_enums.hpp"
 
 namespace AppImageUpdaterBridge
 {
+class AppImageSHA1HashReceiverPrivate;
+
 class AppImageUpdateInformationPrivate : public QObject
 {
     Q_OBJECT
 public:
     explicit AppImageUpdateInformationPrivate(QObject *parent = nullptr);
     ~AppImageUpdateInformationPrivate();
+
+    static short readUpdateString(QFile*, QString*);
+    static short parseUpdateString(const QString&, QJsonObject*);
 public Q_SLOTS:
     void setAppImage(const QString&);
     void setAppImage(QFile *);
     void setShowLog(bool);
+    void setLoggerConnected(bool);
     void setLoggerName(const QString&);
+    void setHashPool(QThreadPool*);
     void getInfo(void);
     void clear(void);
 
-#ifndef LOGGING_DISABLED
 private Q_SLOTS:
+    void handleAppImageSHA1Hash(QString);
+#ifndef LOGGING_DISABLED
     void handleLogMessage(QString, QString);
 #endif // LOGGING_DISABLED
 
 Q_SIGNALS:
+    void partialInfo(QJsonObject);
     void info(QJsonObject);
     void progress(int);
     void error(short);
@@ -77,8 +88,10 @@ Q_SIGNALS:
     void logger(QString, QString);
 
 private:
-    bool b_Busy = false;
-    QJsonObject m_Info;
+    bool b_Busy = false,
+         b_Hashing = false;
+    QJsonObject m_Info,
+                m_PartialInfo; /* m_Info without the AppImage's SHA1 hash. */
     QString s_AppImageName, /* cache to avoid the overhead for QFileInfo. */
             s_AppImagePath,
 #ifndef LOGGING_DISABLED
@@ -87,9 +100,16 @@ private:
 #endif // LOGGING_DISABLED
             s_AppImageSHA1;
 #ifndef LOGGING_DISABLED
+    bool isLogEnabled(QtMsgType) const;
+    void flushLog(QtMsgType);
+
+    bool b_ShowLog = false,
+         b_LoggerConnected = false; /* Someone listens to the logger signal. */
     QScopedPointer<QDebug> p_Logger;
 #endif // LOGGING_DISABLED
     QFile *p_AppImage = nullptr;
+    QThreadPool *p_HashPool = nullptr; /* Not owned , shared with other updates. */
+    QSharedPointer<AppImageSHA1HashReceiverPrivate> p_HashReceiver;
 };
 }
 #endif // APPIMAGE_UPDATE_INFORMATION_PRIVATE_HPP_INCLUDED
@@ -0,0 +1,89 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : appimageupdatemanager.hpp
+ * @description : This is where the update manager is described.
+ * The update manager updates many AppImages at once on a fixed number
+ * of worker threads with one shared network stack , limiting the
+ * requests in flight and the seed scans across all updates.
+*/
+#ifndef APPIMAGE_UPDATE_MANAGER_HPP_INCLUDED
+#define APPIMAGE_UPDATE_MANAGER_HPP_INCLUDED
+#include <QObject>
+#include <QJsonObject>
+#include <QNetworkProxy>
+#include <QString>
+#include <QStringList>
+
+namespace AppImageUpdaterBridge
+{
+class AppImageUpdateManagerPrivate;
+
+class AppImageUpdateManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AppImageUpdateManager(int workerThreads = 0,
+                                   int maxInFlightRequests = 16,
+                                   int maxConcurrentSeedScans = 0,
+                                   QObject *parent = nullptr);
+    ~AppImageUpdateManager();
+
+public Q_SLOTS:
+    void update(const QStringList&);
+    void checkForUpdate(const QStringList&);
+    void cancel(const QString&);
+    void cancelAll(void);
+    void setOutputDirectory(const QString&);
+    void setBlockStore(const QString&, qint64 maxSize = 268435456);
+    void setProxy(const QNetworkProxy&);
+    void setShowLog(bool);
+Q_SIGNALS:
+    void started(QString);
+    void canceled(QString);
+    void finished(QJsonObject, QString, QString);
+    void updateAvailable(bool, QJsonObject, QString);
+    void error(short, QString);
+    void progress(QString, int, qint64, qint64);
+    void logger(QString, QString);
+    void allFinished(void);
+
+protected:
+    void connectNotify(const QMetaMethod&) override;
+    void disconnectNotify(const QMetaMethod&) override;
+
+private:
+    void connectSignals();
+    AppImageUpdateManagerPrivate *p_UpdateManager = nullptr;
+};
+}
+
+#endif // APPIMAGE_UPDATE_MANAGER_HPP_INCLUDED
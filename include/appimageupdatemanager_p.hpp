@@ -0,0 +1,117 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : appimageupdatemanager_p.hpp
+ * @description : This is where the private update manager is described.
+*/
+#ifndef APPIMAGE_UPDATE_MANAGER_PRIVATE_HPP_INCLUDED
+#define APPIMAGE_UPDATE_MANAGER_PRIVATE_HPP_INCLUDED
+#include <QHash>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkProxy>
+#include <QObject>
+#include <QPair>
+#include <QQueue>
+#include <QScopedPointer>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include "appimageupdaterbridge_enums.hpp"
+
+namespace AppImageUpdaterBridge
+{
+class AppImageDeltaRevisionerPrivate;
+class ZsyncRequestLimiterPrivate;
+
+class AppImageUpdateManagerPrivate : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AppImageUpdateManagerPrivate(int workerThreads = 0,
+                                          int maxInFlightRequests = 16,
+                                          int maxConcurrentSeedScans = 0,
+                                          QObject *parent = nullptr);
+    ~AppImageUpdateManagerPrivate();
+
+public Q_SLOTS:
+    void update(const QStringList&);
+    void checkForUpdate(const QStringList&);
+    void cancel(const QString&);
+    void cancelAll(void);
+    void setOutputDirectory(const QString&);
+    void setBlockStore(const QString&, qint64);
+    void setProxy(const QNetworkProxy&);
+    void setShowLog(bool);
+    void setLoggerConnected(bool);
+
+Q_SIGNALS:
+    void started(QString);
+    void canceled(QString);
+    void finished(QJsonObject, QString, QString);
+    void updateAvailable(bool, QJsonObject, QString);
+    void error(short, QString);
+    void progress(QString, int, qint64, qint64);
+    void logger(QString, QString);
+    void allFinished(void);
+private:
+    enum : short {
+        UpdateJob = 0,
+        CheckForUpdateJob
+    };
+
+    void queueJob(const QString&, short);
+    void startQueuedJobs(void);
+    AppImageDeltaRevisionerPrivate *createJob(const QString&);
+    void removeJob(const QString&);
+    QThread *nextWorkerThread(void);
+
+    bool b_ShowLog = false,
+         b_LoggerConnected = false;
+    int n_NextWorkerThread = 0;
+    QString s_OutputDirectory,
+            s_BlockStoreDirectory;
+    qint64 n_BlockStoreMaxSize = 0;
+    int n_MaxRunningJobs = 1; /* The number of worker threads. */
+    QHash<QString, AppImageDeltaRevisionerPrivate*> m_Jobs; /* AppImage path -> running job. */
+    QQueue<QPair<QString, short>> m_QueuedJobs; /* AppImage path and kind of the jobs not started yet. */
+    QVector<QThread*> m_WorkerThreads;
+    QScopedPointer<QThreadPool> p_WorkerPool; /* Hashes the AppImages and seed indexes of all jobs. */
+    QScopedPointer<QThread> p_NetworkThread;
+    QScopedPointer<QNetworkAccessManager> p_NetworkAccessManager;
+    QScopedPointer<ZsyncRequestLimiterPrivate> p_RequestLimiter;
+    QScopedPointer<ZsyncRequestLimiterPrivate> p_SeedScanLimiter;
+};
+}
+#endif // APPIMAGE_UPDATE_MANAGER_PRIVATE_HPP_INCLUDED
@@ -35,4 +35,6 @@
 #define APPIMAGE_UPDATER_BRIDGE_HPP_INCLUDED
 #include "appimageupdaterbridge_enums.hpp"
 #include "appimagedeltarevisioner.hpp"
+#include "appimagebatchscanner.hpp"
+#include "appimageupdatemanager.hpp"
 #endif // APPIMAGE_UPDATER_BRIDGE_HPP_INCLUDED
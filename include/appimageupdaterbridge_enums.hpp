@@ -158,7 +158,17 @@ enum : short {
     CannotOpenSourceFile,
     NoPermissionToReadWriteTargetFile,
     CannotOpenTargetFile,
-    TargetFileSha1HashMismatch
+    TargetFileSha1HashMismatch,
+
+    /* Blocking updater errors. */
+    NoCoreApplication = 120
+};
+
+/* Threading modes for the delta revisioner. */
+enum ThreadingMode : short {
+    SingleThreaded = 0,   /* Everything runs in the caller's thread. */
+    SharedThread,         /* Network and writer share one extra thread. */
+    SeparateNetworkThread /* Network I/O and the writer get a thread each. */
 };
 
 QString errorCodeToString(short);
@@ -0,0 +1,83 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : blockingupdater_p.hpp
+ * @description : This is where the blocking updater is described.
+ * The blocking updater runs a delta revisioner in its own thread and
+ * blocks the caller until the result is known , So it can be used
+ * without an event loop.
+*/
+#ifndef BLOCKING_UPDATER_PRIVATE_HPP_INCLUDED
+#define BLOCKING_UPDATER_PRIVATE_HPP_INCLUDED
+#include <QJsonObject>
+#include <QObject>
+#include <QScopedPointer>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QString>
+
+#include "appimagedeltarevisioner.hpp"
+
+namespace AppImageUpdaterBridge
+{
+class AppImageDeltaRevisionerPrivate;
+
+class BlockingUpdaterPrivate : public QObject
+{
+    Q_OBJECT
+public:
+    BlockingUpdaterPrivate(const UpdateOptions&, const QSharedPointer<QSemaphore>&);
+    ~BlockingUpdaterPrivate();
+
+    static UpdateResult run(const UpdateOptions&, bool checkOnly);
+    UpdateResult result(void) const;
+
+public Q_SLOTS:
+    void start(bool);
+    void cancel(void);
+
+private Q_SLOTS:
+    void handleFinished(QJsonObject, QString);
+    void handleUpdateAvailable(bool, QJsonObject);
+    void handleError(short);
+    void handleCanceled(void);
+
+private:
+    void done(void);
+
+    bool b_Done = false;
+    UpdateOptions m_Options;
+    UpdateResult m_Result;
+    QSharedPointer<QSemaphore> p_Done; /* Shared , a timed out caller does not wait for us. */
+    QScopedPointer<AppImageDeltaRevisionerPrivate> p_DeltaRevisioner;
+};
+}
+#endif // BLOCKING_UPDATER_PRIVATE_HPP_INCLUDED
@@ -0,0 +1,71 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : sha1hasher_p.hpp
+ * @description : This is where the SHA-1 hasher is described.
+ * The hasher uses the SHA extensions of x86 processors or the crypto
+ * extensions of ARMv8 processors when they are available and falls back
+ * to a portable implementation otherwise. Files are hashed through a single
+ * fixed buffer which is reused for every read.
+*/
+#ifndef SHA1_HASHER_PRIVATE_HPP_INCLUDED
+#define SHA1_HASHER_PRIVATE_HPP_INCLUDED
+#include <QtGlobal>
+#include <QByteArray>
+#include <QFile>
+#include <QScopedArrayPointer>
+
+namespace AppImageUpdaterBridge
+{
+class Sha1HasherPrivate
+{
+public:
+    explicit Sha1HasherPrivate(qint64 bufferSize = 1048576);
+    ~Sha1HasherPrivate();
+
+    void reset(void);
+    void addData(const char*, qint64);
+    bool addData(QFile*, qint64 maxSize = -1);
+    QByteArray result(void);
+
+    static bool isHardwareAccelerated(void);
+private:
+    void processBlocks(const unsigned char*, qint64);
+
+    quint32 p_State[5];
+    quint64 n_Length = 0;
+    qint64 n_BufferSize = 0;
+    int n_PendingBytes = 0;
+    unsigned char p_Pending[64];
+    QScopedArrayPointer<char> p_Buffer; /* Reused for every read of addData(QFile*). */
+};
+}
+#endif // SHA1_HASHER_PRIVATE_HPP_INCLUDED
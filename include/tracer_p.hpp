@@ -0,0 +1,72 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : tracer_p.hpp
+ * @description : A process wide recorder of the phases of the update , which
+ * can be exported as Chrome trace events.
+*/
+#ifndef TRACER_PRIVATE_HPP_INCLUDED
+#define TRACER_PRIVATE_HPP_INCLUDED
+#include <QtGlobal>
+#include <QJsonObject>
+#include <QString>
+
+namespace AppImageUpdaterBridge
+{
+class TracerPrivate
+{
+public:
+    static void acquire(void);
+    static void release(void);
+    static bool isEnabled(void);
+    static qint64 now(void);
+    static void complete(const char *name, qint64 start, const QJsonObject &args = QJsonObject());
+    static void asyncBegin(const char *name, const void *id, const QJsonObject &args = QJsonObject());
+    static void asyncEnd(const char *name, const void *id);
+    static bool save(const QString &path);
+};
+
+/*
+ * Records a complete event from its construction to its destruction ,
+ * Costs nothing but a atomic load if tracing is disabled.
+*/
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name, const QJsonObject &args = QJsonObject());
+    ~TraceScope();
+private:
+    const char *p_Name = nullptr;
+    qint64 n_Start = -1; /* -1 if tracing was disabled at construction. */
+    QJsonObject j_Arguments;
+};
+}
+#endif // TRACER_PRIVATE_HPP_INCLUDED
@@ -31,7 +31,7 @@
  *
  * @filename    : zsyncblockrangedownloader_p.hpp
  * @description : This the main class which manages all block requests and reply
- * also emits the progress overall , This is where the class is described.
+ * also counts the progress overall , This is where the class is described.
 */
 #ifndef ZSYNC_BLOCK_RANGE_DOWNLOADER_PRIVATE_HPP_INCLUDED
 #define ZSYNC_BLOCK_RANGE_DOWNLOADER_PRIVATE_HPP_INCLUDED
@@ -40,32 +40,41 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QList>
+#include <QPair>
 
 #include "zsyncwriter_p.hpp"
 
 namespace AppImageUpdaterBridge
 {
+class ZsyncRequestLimiterPrivate;
 class ZsyncBlockRangeDownloaderPrivate : public QObject
 {
     Q_OBJECT
 public:
-    ZsyncBlockRangeDownloaderPrivate(ZsyncWriterPrivate*,QNetworkAccessManager*);
+    ZsyncBlockRangeDownloaderPrivate(ZsyncWriterPrivate*,QNetworkAccessManager*,ZsyncRequestLimiterPrivate *limiter = nullptr);
     ~ZsyncBlockRangeDownloaderPrivate();
 
+    void setProgressAggregator(QSharedPointer<ZsyncProgressAggregatorPrivate>);
+    void setMaxPendingWriteBytes(qint64);
+
 public Q_SLOTS:
     void cancel(void);
 
 private Q_SLOTS:
+    void preConnect(QUrl);
     void initDownloader(qint64, qint64, QUrl);
     void handleBlockRange(qint32,qint32);
+    void handleEndOfBlockRanges(void);
+    void requestPendingRanges(void);
+    void handleRequestSlot(void);
+    void handleBlockRangeWritten(qint32, qint32);
     void handleBlockReplyFinished(void);
     void handleBlockReplyCancel(void);
     void handleBlockReplyError(QNetworkReply::NetworkError);
-    void handleBlockReplyProgress(qint64, double, QString);
 
 Q_SIGNALS:
     void blockRangesRequested();
-    void progress(int, qint64, qint64, double, QString);
     void cancelAllReply(void);
     void canceled(void);
     void error(short);
@@ -73,14 +82,24 @@ Q_SIGNALS:
     void finished(void);
 
 private:
+    void requestBlockRange(qint32, qint32);
+    void releaseRequestSlot(void);
+    void finishIfDone(void);
+
     QUrl u_TargetFileUrl;
-    qint64 n_BytesTotal = 0,
-           n_BytesReceived = 0,
-           n_BlockReply = 0;
+    qint64 n_BlockReply = 0,
+           n_PendingWriteBytes = 0, /* Requested but not yet written by the writer. */
+           n_MaxPendingWriteBytes = 0;
     bool b_Errored = false,
-         b_CancelRequested = false;
+         b_CancelRequested = false,
+         b_Active = false, /* Between initDownloader and finished or canceled. */
+         b_EndOfRanges = false; /* The writer will not publish more ranges. */
     QNetworkAccessManager *p_Manager = nullptr;
     ZsyncWriterPrivate *p_Writer = nullptr;
+    ZsyncRequestLimiterPrivate *p_Limiter = nullptr;
+    QSharedPointer<ZsyncProgressAggregatorPrivate> p_Progress; /* may be null. */
+    QSharedPointer<ZsyncKnownBlocksPrivate> p_KnownBlocks; /* Checked before every request. */
+    QList<QPair<qint32, qint32>> m_PendingRanges;
 };
 }
 #endif // ZSYNC_BLOCK_RANGE_DOWNLOADER_PRIVATE_HPP_INCLUDED
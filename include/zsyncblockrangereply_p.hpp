@@ -43,6 +43,7 @@
 #include <QNetworkReply>
 
 #include "zsyncwriter_p.hpp"
+#include "zsyncprogressaggregator_p.hpp"
 
 namespace AppImageUpdaterBridge
 {
@@ -50,7 +51,8 @@ class ZsyncBlockRangeReplyPrivate : public QObject
 {
     Q_OBJECT
 public:
-    ZsyncBlockRangeReplyPrivate(ZsyncWriterPrivate*,QNetworkReply*,qint32,qint32);
+    ZsyncBlockRangeReplyPrivate(ZsyncWriterPrivate*,QNetworkReply*,qint32,qint32,
+                                QSharedPointer<ZsyncProgressAggregatorPrivate> progress = QSharedPointer<ZsyncProgressAggregatorPrivate>());
     ~ZsyncBlockRangeReplyPrivate();
 
 public Q_SLOTS:
@@ -65,16 +67,15 @@ private Q_SLOTS:
 Q_SIGNALS:
     void cancelReply(void);
     void canceled(void);
-    void seqProgress(int, qint64, qint64, double, QString);
-    void progress(qint64, double, QString);
     void error(QNetworkReply::NetworkError);
     void finished(void);
     void sendData(QByteArray*);
     void sendBlockDataToWriter(qint32, qint32, QByteArray *);
 
 private:
-    QTime downloadSpeed;
     QScopedPointer<QByteArray> p_RawData;
+    QSharedPointer<ZsyncProgressAggregatorPrivate> p_Progress;
+    bool b_FirstByteReceived = false;
     qint64 n_PreviousBytesReceived = 0;
     qint32 n_RangeFrom = 0,
            n_RangeTo = 0;
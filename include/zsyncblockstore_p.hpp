@@ -0,0 +1,135 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncblockstore_p.hpp
+ * @description : A content addressed store of verified blocks , shared by
+ * all delta writers which use the same directory.
+*/
+#ifndef ZSYNC_BLOCK_STORE_PRIVATE_HPP_INCLUDED
+#define ZSYNC_BLOCK_STORE_PRIVATE_HPP_INCLUDED
+#include <QtGlobal>
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QLockFile>
+#include <QMap>
+#include <QMultiHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+#include "zsyncinternalstructures_p.hpp"
+
+namespace AppImageUpdaterBridge
+{
+class ZsyncBlockStorePrivate
+{
+public:
+    static QSharedPointer<ZsyncBlockStorePrivate> open(const QString &directory, qint64 maxSize);
+    ~ZsyncBlockStorePrivate();
+
+    bool lock(void);
+    void unlock(void);
+    bool lookup(qint32 blockSize, rsum weakCheckSum, unsigned short weakCheckSumMask,
+                const unsigned char *strongCheckSum, qint32 strongCheckSumBytes, QByteArray *block);
+    void insert(qint32 blockSize, rsum weakCheckSum, const unsigned char *strongCheckSum,
+                const char *block);
+    void setMaxSize(qint64);
+    QString directory(void) const;
+
+    /* Used for the seed index and match cache sub directories. */
+    static void pruneDirectory(const QString &directory, const QString &filter);
+
+private:
+    ZsyncBlockStorePrivate(const QString &directory, qint64 maxSize);
+
+    struct Entry {
+        qint32 n_BlockSize = 0;
+        rsum m_WeakCheckSum = { 0, 0 };
+        unsigned char p_StrongCheckSum[CHECKSUM_SIZE];
+        qint64 n_Slot = 0;
+        quint64 n_LastUse = 0;
+    };
+
+    static quint64 indexKey(qint32 blockSize, unsigned short b);
+    QFile *packFile(qint32 blockSize);
+    bool takeSlot(qint32 blockSize, qint64 *slot);
+    void touch(quint64 id);
+    void remove(quint64 id);
+    void sync(void);
+    void load(void);
+    quint64 storedGeneration(void) const;
+
+    QMutex m_Mutex;
+    QLockFile m_LockFile; /* Shared by all processes which use the directory. */
+    QString s_Directory;
+    qint64 n_MaxSize = 0,
+           n_PackSize = 0; /* Bytes taken by all slots of all pack files. */
+    quint64 n_NextId = 0,
+            n_UseCounter = 0,
+            n_Generation = 0; /* Of the loaded index , bumped by every write of any process. */
+    bool b_Dirty = false;
+    QHash<quint64, Entry> m_Entries;
+    QMultiHash<quint64, quint64> m_Index; /* (block size , rsum.b) -> entry. */
+    QMap<quint64, quint64> m_LeastRecentlyUsed; /* last use -> entry , oldest first. */
+    QHash<qint32, qint64> m_SlotCount; /* Slots in the pack file of each block size. */
+    QHash<qint32, QVector<qint64>> m_FreeSlots;
+    QHash<qint32, QSharedPointer<QFile>> m_PackFiles;
+};
+
+/* Locks the given block store for the lifetime of the locker , See lock(). */
+class ZsyncBlockStoreLocker
+{
+public:
+    explicit ZsyncBlockStoreLocker(ZsyncBlockStorePrivate *store)
+        : p_Store((store && store->lock()) ? store : nullptr)
+    {
+        return;
+    }
+
+    ~ZsyncBlockStoreLocker()
+    {
+        if(p_Store) {
+            p_Store->unlock();
+        }
+        return;
+    }
+
+    bool isLocked(void) const
+    {
+        return p_Store != nullptr;
+    }
+private:
+    ZsyncBlockStorePrivate *p_Store = nullptr;
+};
+}
+#endif // ZSYNC_BLOCK_STORE_PRIVATE_HPP_INCLUDED
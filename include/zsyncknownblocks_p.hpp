@@ -0,0 +1,61 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncknownblocks_p.hpp
+ * @description : A bitmap of the target blocks the delta writer already has ,
+ * readable from the downloader thread.
+*/
+#ifndef ZSYNC_KNOWN_BLOCKS_PRIVATE_HPP_INCLUDED
+#define ZSYNC_KNOWN_BLOCKS_PRIVATE_HPP_INCLUDED
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QScopedArrayPointer>
+
+#include "zsyncinternalstructures_p.hpp"
+
+namespace AppImageUpdaterBridge
+{
+class ZsyncKnownBlocksPrivate
+{
+public:
+    void reset(qint32 blocks, qint32 blockSize, qint64 targetFileLength);
+    void set(zs_blockid);
+    bool contains(zs_blockid) const;
+    bool trim(qint32 *from, qint32 *to) const;
+
+private:
+    QScopedArrayPointer<QAtomicInt> p_Words;
+    qint32 n_Blocks = 0,
+           n_BlockSize = 0;
+    qint64 n_TargetFileLength = 0;
+};
+}
+#endif // ZSYNC_KNOWN_BLOCKS_PRIVATE_HPP_INCLUDED
@@ -0,0 +1,79 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncmatchcache_p.hpp
+ * @description : The blocks of a target file found in a seed file , kept
+ * as extents keyed by the SHA1 hashes of both so the seed is not scanned again.
+*/
+#ifndef ZSYNC_MATCH_CACHE_PRIVATE_HPP_INCLUDED
+#define ZSYNC_MATCH_CACHE_PRIVATE_HPP_INCLUDED
+#include <QtGlobal>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+#include "zsyncinternalstructures_p.hpp"
+
+namespace AppImageUpdaterBridge
+{
+class ZsyncMatchCachePrivate
+{
+public:
+    /* blockCount target blocks starting at firstBlock are found at seedOffset. */
+    struct Extent {
+        qint64 seedOffset;
+        zs_blockid firstBlock;
+        qint32 blockCount;
+    };
+
+    static bool load(const QString &directory, const QString &seedSHA1, const QString &targetSHA1,
+                     qint32 blockSize, qint32 blocks, QVector<Extent> *extents);
+    static void save(const QString &directory, const QString &seedSHA1, const QString &targetSHA1,
+                     qint32 blockSize, qint32 blocks, const QVector<Extent> &extents);
+    static bool importFile(const QString &path, const QString &directory);
+    static bool exportFile(const QString &directory, const QString &seedSHA1, const QString &targetSHA1,
+                           const QString &path);
+
+private:
+    struct Header {
+        QString s_SeedSHA1,
+                s_TargetSHA1;
+        qint32 n_BlockSize = 0,
+               n_Blocks = 0;
+    };
+
+    static bool isSha1(const QString&);
+    static QString cachePath(const QString &directory, const QString &seedSHA1, const QString &targetSHA1);
+    static bool read(QIODevice *device, Header *header, QVector<Extent> *extents);
+    static bool write(QIODevice *device, const Header &header, const QVector<Extent> &extents);
+};
+}
+#endif // ZSYNC_MATCH_CACHE_PRIVATE_HPP_INCLUDED
@@ -0,0 +1,83 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncprogressaggregator_p.hpp
+ * @description : Collects the progress of the delta writer and the block
+ * downloads and publishes it at a fixed rate.
+*/
+#ifndef ZSYNC_PROGRESS_AGGREGATOR_PRIVATE_HPP_INCLUDED
+#define ZSYNC_PROGRESS_AGGREGATOR_PRIVATE_HPP_INCLUDED
+#include <QtGlobal>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+namespace AppImageUpdaterBridge
+{
+class ZsyncProgressAggregatorPrivate : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ZsyncProgressAggregatorPrivate(QObject *parent = nullptr);
+    ~ZsyncProgressAggregatorPrivate();
+
+    /* Thread safe , called by the producers in their own threads. */
+    void begin(qint64 bytesDone, qint64 bytesTotal);
+    void setBytes(qint64);
+    void addBytes(qint64);
+
+public Q_SLOTS:
+    void setInterval(int);
+    void stop(void);
+
+private Q_SLOTS:
+    void startPublishing(void);
+    void publish(void);
+
+Q_SIGNALS:
+    void progress(int, qint64, qint64, double, QString);
+    void remainingTime(qint64);
+
+private:
+    QAtomicInteger<qint64> n_BytesDone,
+                           n_BytesTotal;
+    QAtomicInt n_Phase; /* Incremented by every begin , resets the speed estimate. */
+    QTimer m_Timer;
+    QElapsedTimer m_Clock;
+    int n_PublishedPhase = 0;
+    qint64 n_PublishedBytes = -1,
+           n_PublishedTime = 0;
+    double n_Speed = 0.0; /* bytes per second , exponentially weighted. */
+};
+}
+#endif // ZSYNC_PROGRESS_AGGREGATOR_PRIVATE_HPP_INCLUDED
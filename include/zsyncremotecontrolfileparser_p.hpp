@@ -67,10 +67,12 @@ public:
     ~ZsyncRemoteControlFileParserPrivate();
 public Q_SLOTS:
     void clear(void);
+    void cancel(void);
     void setControlFileUrl(const QUrl&);
     void setControlFileUrl(QJsonObject);
     void setLoggerName(const QString&);
     void setShowLog(bool);
+    void setLoggerConnected(bool);
     void getControlFile(void);
     void getUpdateCheckInformation(void);
     void getZsyncInformation(void);
@@ -96,7 +98,10 @@ Q_SIGNALS:
     void error(short);
     void statusChanged(short);
     void logger(QString, QString);
+    void cancelAllReply(void);
 private:
+    void watchReply(QNetworkReply*);
+
     bool b_AcceptRange = false,
          b_Busy = false;
     QJsonObject j_UpdateInformation;
@@ -124,6 +129,11 @@ private:
          u_ControlFileUrl;
 
 #ifndef LOGGING_DISABLED
+    bool isLogEnabled(QtMsgType) const;
+    void flushLog(QtMsgType);
+
+    bool b_ShowLog = false,
+         b_LoggerConnected = false; /* Someone listens to the logger signal. */
     QScopedPointer<QDebug> p_Logger;
 #endif // LOGGING_DISABLED
     QScopedPointer<QBuffer> p_ControlFile;
@@ -0,0 +1,78 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncrequestlimiter_p.hpp
+ * @description : A small thread safe counter which caps the number of block
+ * range requests that can be in flight across many downloaders , and the
+ * number of concurrent seed scans across many writers.
+*/
+#ifndef ZSYNC_REQUEST_LIMITER_PRIVATE_HPP_INCLUDED
+#define ZSYNC_REQUEST_LIMITER_PRIVATE_HPP_INCLUDED
+#include <QtGlobal>
+#include <QObject>
+#include <QMutex>
+#include <QPointer>
+#include <QByteArray>
+#include <QList>
+
+namespace AppImageUpdaterBridge
+{
+class ZsyncRequestLimiterPrivate : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ZsyncRequestLimiterPrivate(int maxInFlightRequests, QObject *parent = nullptr);
+    ~ZsyncRequestLimiterPrivate();
+
+    bool tryAcquire(void);
+    bool tryAcquire(QObject *waiter, const char *member);
+    void release(void);
+    void releaseUnclaimed(QObject *waiter);
+    void removeWaiter(QObject *waiter);
+    int maxInFlightRequests(void) const;
+    int available(void) const;
+
+private:
+    struct Waiter {
+        QPointer<QObject> p_Object;
+        QByteArray s_Member;
+    };
+
+    bool hasWaiter(QObject*) const;
+
+    mutable QMutex m_Mutex;
+    int n_Available = 0,
+        n_MaxInFlightRequests = 0;
+    QList<Waiter> m_Waiters; /* First come first served. */
+    QList<QObject*> m_Granted; /* Got a slot from release but did not take it yet. */
+};
+}
+#endif // ZSYNC_REQUEST_LIMITER_PRIVATE_HPP_INCLUDED
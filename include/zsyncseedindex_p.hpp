@@ -0,0 +1,68 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncseedindex_p.hpp
+ * @description : The rsum and MD4 checksum of every aligned block of a seed
+ * file , kept on the disk so a seed is hashed only once.
+*/
+#ifndef ZSYNC_SEED_INDEX_PRIVATE_HPP_INCLUDED
+#define ZSYNC_SEED_INDEX_PRIVATE_HPP_INCLUDED
+#include <QtGlobal>
+#include <QFile>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+#include "zsyncinternalstructures_p.hpp"
+
+namespace AppImageUpdaterBridge
+{
+class ZsyncSeedIndexPrivate
+{
+public:
+    struct Block {
+        struct rsum r;
+        unsigned char checksum[CHECKSUM_SIZE];
+    } __attribute__((packed));
+
+    static QVector<Block> get(const QString &directory, QFile *seed, const uchar *data, qint32 blockSize,
+                              qint32 checksumBytes, QThreadPool *pool);
+    static QVector<Block> build(const uchar *data, qint64 size, qint32 blockSize, qint32 checksumBytes,
+                                QThreadPool *pool);
+
+private:
+    static QString indexPath(const QString &directory, QFile *seed, qint32 blockSize, qint32 checksumBytes,
+                             QByteArray *identity);
+    static bool load(const QString &path, const QByteArray &identity, qint64 count, QVector<Block> *blocks);
+    static void save(const QString &path, const QByteArray &identity, const QVector<Block> &blocks);
+};
+}
+#endif // ZSYNC_SEED_INDEX_PRIVATE_HPP_INCLUDED
@@ -43,30 +43,80 @@
 #include <QtEndian>
 #include <QFileInfo>
 #include <QtGlobal>
+#include <QJsonArray>
 #include <QJsonObject>
 #include <QObject>
 #include <QUrl>
 #include <QString>
+#include <QStringList>
 #include <QScopedPointer>
-#include <QTime>
+#include <QSharedPointer>
 #include <QTimer>
 #include <QTemporaryFile>
+#include <QThreadPool>
 
 #include "appimageupdaterbridge_enums.hpp"
 #include "zsyncinternalstructures_p.hpp"
+#include "zsyncblockstore_p.hpp"
+#include "zsyncknownblocks_p.hpp"
+#include "zsyncmatchcache_p.hpp"
+#include "zsyncprogressaggregator_p.hpp"
 
 namespace AppImageUpdaterBridge
 {
+class ZsyncRequestLimiterPrivate;
+/*
+ * Counters of the block matcher , The scan kernel counts in a instance per
+ * thread and every writer lives in a single thread , So these are plain
+ * integers and cost a add each. Always part of the writer , Only the counting
+ * is compiled out with STATISTICS_DISABLED.
+*/
+struct ZsyncWriterStatistics {
+    quint64 n_BitHashProbes = 0, /* lookups in the bit hash. */
+            n_BucketHits = 0, /* bit hash and rsum hash bucket hits , i.e hash chain walks. */
+            n_ChainEntries = 0, /* hash chain entries compared. */
+            n_WeakHits = 0, /* entries with a matching weak checksum. */
+            n_Md4Computations = 0,
+            n_StrongHits = 0, /* weak hits confirmed by the strong checksum. */
+            n_BytesRolled = 0, /* bytes the rolling checksum moved over without a match. */
+            n_BlocksWritten = 0,
+            n_AlignedMatches = 0, /* seed blocks matched at their aligned offset , without rolling. */
+            n_BytesCloned = 0, /* seed bytes placed by sharing extents of the filesystem. */
+            n_BytesCopiedInKernel = 0, /* seed bytes placed with copy_file_range. */
+            n_BytesCopiedInUserspace = 0; /* seed bytes read and written back. */
+};
+
 class ZsyncWriterPrivate : public QObject
 {
     Q_OBJECT
 public:
     explicit ZsyncWriterPrivate();
     ~ZsyncWriterPrivate();
+
+    /* Must be set before the writer is moved to its thread. */
+    void setSeedScanLimiter(ZsyncRequestLimiterPrivate*);
+    void setWorkerPool(QThreadPool*);
+    void setProgressAggregator(QSharedPointer<ZsyncProgressAggregatorPrivate>);
+    QSharedPointer<ZsyncKnownBlocksPrivate> knownBlocks(void) const;
+
+    /* Used by the benchmarks. */
+    qint32 scanSeedData(const QByteArray&);
+
+    /* Used by the seed index. */
+    static void calcMd4Checksum(QCryptographicHash*, unsigned char*, const unsigned char*, size_t, size_t);
 public Q_SLOTS:
     void setShowLog(bool);
+    void setLoggerConnected(bool);
     void setLoggerName(const QString&);
     void setOutputDirectory(const QString&);
+    void setDryRun(bool);
+    void addSeedFile(const QString&);
+    void addSeedDirectory(const QString&);
+    void clearSeedFiles(void);
+    void setBlockStore(const QString&, qint64);
+    void setMatchCache(const QString&);
+    void setSourceFileSHA1(const QString&);
+    void getStatistics(void);
     void setConfiguration(qint32,qint32,qint32,
                           qint32,qint32,qint32,
                           const QString&,const QString&,const QString&,
@@ -84,11 +134,11 @@ private Q_SLOTS:
 #ifndef LOGGING_DISABLED
     void handleLogMessage(QString, QString);
 #endif // LOGGING_DISABLED
+    void handleSeedScanSlot(void);
     bool verifyAndConstructTargetFile(void);
     void addToRanges(zs_blockid);
     qint32 alreadyGotBlock(zs_blockid);
     qint32 buildHash(void);
-    qint32 checkCheckSumsOnHashChain(const hash_entry *, const unsigned char *, qint32 );
     quint32 calcRHash(const hash_entry *const);
     void calcMd4Checksum(unsigned char *, const unsigned char*,size_t);
     zs_blockid getHashEntryBlockId(const hash_entry *);
@@ -97,8 +147,38 @@ private Q_SLOTS:
     void writeBlocks(const unsigned char *, zs_blockid, zs_blockid);
     void removeBlockFromHash(zs_blockid);
     qint32 submitSourceData(unsigned char*, size_t, off_t);
+    void flushStatistics(void);
     qint32 submitSourceFile(QFile*);
+    qint32 submitMappedSourceFile(QFile*, uchar*);
+    qint32 submitAlignedBlocks(QFile*, uchar*, QVector<bool>*);
+    qint32 submitCachedMatches(QFile*, uchar*, bool*);
+    void recordMatch(const unsigned char*, zs_blockid, zs_blockid);
+    QString matchCacheDirectory(void) const;
+    QString seedIndexDirectory(void) const;
+    qint32 submitMappedRange(uchar*, qint64, qint64, qint64);
+    qint32 submitBufferedSourceFile(QFile*);
+    bool hasScanBeenCanceled(void);
+    bool addSeedExtent(const unsigned char*, qint64, qint64);
+    void flushSeedExtent(void);
+    qint32 submitExtraSeedFiles(void);
+    QStringList discoverSeedFiles(void);
+    qint32 estimateSeedMatches(QFile*);
+    void submitBlockStore(void);
+    void groupIdenticalBlocks(void);
+    void submitZeroBlocks(void);
+    void replicateBlock(const unsigned char*, zs_blockid);
+    void collectBlocks(const QByteArray&);
     qint32 rangeBeforeBlock(zs_blockid);
+    QVector<QPair<qint32, qint32>> computeRequiredRanges(void);
+    void emitRequiredRanges(void);
+    void requiredRangeBytes(const QPair<qint32, qint32>&, qint32*, qint32*) const;
+    void publishRangesEarly(qint64);
+    void finishEarlyDownload(void);
+    void discardDeferredBlockRanges(void);
+    void pruneRequiredRanges(void);
+    void removeRequiredRanges(zs_blockid, zs_blockid);
+    bool isRangeKnown(zs_blockid, zs_blockid);
+    void emitPlan(void);
     zs_blockid nextKnownBlock(zs_blockid);
 
 Q_SIGNALS:
@@ -106,19 +186,34 @@ Q_SIGNALS:
     void initCancel();
     void finishedConfiguring();
     void blockRange(qint32, qint32);
+    void blockRangeWritten(qint32, qint32);
     void endOfBlockRanges();
     void download(qint64, qint64, QUrl);
     void started();
+    void seedScanStarted(QUrl);
     void canceled();
     void finished(QJsonObject, QString);
-    void progress(int percentage, qint64 bytesReceived, qint64 bytesTotal, double speed, QString units);
+    void plan(QJsonObject);
+    void statistics(QJsonObject);
     void statusChanged(short);
     void error(short);
     void logger(QString, QString);
 private:
+    typedef qint32 (ZsyncWriterPrivate::*ScanKernel)(unsigned char*, size_t, off_t);
+    template <int SeqMatches, int WeakBytes, int BlockShift>
+    qint32 scanSourceData(unsigned char*, size_t, off_t);
+    template <int SeqMatches, int WeakBytes, int BlockShift, bool OnlyOne>
+    qint32 checkHashChain(const hash_entry *, const unsigned char *);
+    static ScanKernel selectScanKernel(qint32, qint32, qint32);
+
     bool b_Started = false,
          b_CancelRequested = false,
-         b_AcceptRange = true;
+         b_AcceptRange = true,
+         b_WaitingForSeedScanSlot = false,
+         b_DryRun = false; /* Only scan the seed files , nothing is written to the disk. */
+    ZsyncRequestLimiterPrivate *p_SeedScanLimiter = nullptr; /* Shared between writers , limits concurrent seed scans. */
+    QThreadPool *p_WorkerPool = QThreadPool::globalInstance(); /* Shared between writers , hashes the seed indexes. */
+    QSharedPointer<ZsyncProgressAggregatorPrivate> p_Progress; /* may be null. */
     QUrl u_TargetFileUrl;
     QPair<rsum, rsum> p_CurrentWeakCheckSums = qMakePair(rsum({ 0, 0 }), rsum({ 0, 0 }));
     qint64 n_BytesWritten = 0;
@@ -132,6 +227,31 @@ private:
            n_Skip = 0,    /* skip forward on next submit_source_data. */
            n_TargetFileLength = 0;
     unsigned short p_WeakCheckSumMask = 0; /* This will be applied to the first 16 bits of the weak checksum. */
+    ScanKernel p_ScanKernel = nullptr; /* Specialized for the configuration , see selectScanKernel. */
+
+    /*
+     * The seed file being scanned , Matched blocks are placed straight from it
+     * as extents instead of being copied through the scan buffer.
+    */
+    int n_SeedHandle = -1;
+    qint64 n_SeedSize = 0;
+    const unsigned char *p_ScanBase = nullptr; /* The data given to the scan kernel , at n_ScanBaseOffset of the seed. */
+    qint64 n_ScanBaseOffset = 0,
+           n_ScanLength = 0;
+    qint64 n_ExtentSeedOffset = 0, /* The pending extent , adjacent matches are merged into it. */
+           n_ExtentTargetOffset = 0,
+           n_ExtentLength = 0;
+    bool b_CloneSupported = true,
+         b_CopyRangeSupported = true;
+
+    /*
+     * The matches of the source file are recorded while it is scanned , So
+     * they can be placed without a scan the next time , see ZsyncMatchCachePrivate.
+    */
+    bool b_MatchCacheSeed = false, /* The source file is being scanned. */
+         b_RecordingMatches = false,
+         b_TransientSeed = false; /* A part file which is removed after the scan , never indexed. */
+    QVector<ZsyncMatchCachePrivate::Extent> m_MatchExtents;
 
     const hash_entry *p_Rover = nullptr,
                       *p_NextMatch = nullptr;
@@ -149,16 +269,51 @@ private:
 
     qint32 n_Ranges = 0;
     zs_blockid *p_Ranges = nullptr; /* Ranges needed to finish the under construction target file. */
-    QVector<QPair<qint32, qint32>> p_RequiredRanges;
+    QVector<QPair<qint32, qint32>> p_RequiredRanges; /* Published and not yet written. */
+    QVector<bool> p_PublishedBlocks; /* Blocks of every range published so far. */
+
+    /*
+     * Ranges may be published while extra seed files are still scanned , The
+     * ranges downloaded meanwhile are written once the scan is done.
+    */
+    struct DeferredBlockRange {
+        qint32 n_From;
+        qint32 n_To;
+        QByteArray *p_Data;
+    };
+    QList<DeferredBlockRange> m_DeferredBlockRanges;
+    bool b_Scanning = false, /* Seed files are scanned after download was emitted. */
+         b_RangesPublished = false, /* download was emitted before the scan was done. */
+         b_AllRangesPublished = false,
+         b_DownloadRequested = false; /* download was emitted , getBlockRanges did not run yet. */
+    QSharedPointer<ZsyncKnownBlocksPrivate> p_KnownBlocks; /* Shared with the downloader. */
+    QVector<qint32> p_BlockGroups; /* Group of identical target blocks of every block , -1 if it is unique. */
+    QVector<QVector<zs_blockid>> p_IdenticalBlocks; /* Blocks of every group , in order. */
+    qint32 n_ZeroBlockGroup = -1; /* The group of all zero blocks , they are never downloaded. */
+    qint64 n_BytesDeduplicated = 0, /* Bytes not requested since a identical block is requested. */
+           n_BytesSynthesized = 0; /* Bytes of zero blocks. */
+    bool b_Replicating = false;
     QScopedPointer<QBuffer> p_TargetFileCheckSumBlocks; /* Checksum blocks that needs to be loaded into the memory.*/
     QScopedPointer<QCryptographicHash> p_Md4Ctx; /* Md4 Hasher context.*/
     QString s_SourceFilePath,
+            s_SourceFileSHA1, /* Given by the revisioner , the match cache is only used if known. */
+            s_MatchCacheDirectory, /* Empty to keep it next to the block store , if any. */
             s_TargetFileName,
             s_TargetFileSHA1,
-            s_OutputDirectory;
+            s_OutputDirectory,
+            s_TargetFileDirectory;
+    QStringList m_SeedFiles, /* Seed files given by the user. */
+                m_SeedDirectories; /* Searched for other versions of the same AppImage. */
+    QSharedPointer<ZsyncBlockStorePrivate> p_BlockStore; /* Optional , shared with other writers. */
+    QJsonArray j_SeedMatches; /* Bytes of the target file found in each seed file. */
     QScopedPointer<QTemporaryFile> p_TargetFile; /* under construction target file. */
-    QScopedPointer<QTime> p_TransferSpeed;
+    ZsyncWriterStatistics m_Statistics; /* Reset on every configuration. */
 #ifndef LOGGING_DISABLED
+    bool isLogEnabled(QtMsgType) const;
+    void flushLog(QtMsgType);
+
+    bool b_ShowLog = false,
+         b_LoggerConnected = false; /* Someone listens to the logger signal. */
     QString s_LogBuffer,
             s_LoggerName;
     QScopedPointer<QDebug> p_Logger;
@@ -0,0 +1,106 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : appimagebatchscanner.cc
+ * @description : This is where the batch scanner is implemented.
+ * The batch scanner extracts the embeded update information and the
+ * SHA1 hash of many AppImages in parallel on a thread pool and reports
+ * every AppImage as soon as it is scanned.
+*/
+#include "../include/appimagebatchscanner_p.hpp"
+#include "../include/appimagebatchscanner.hpp"
+#include "../include/helpers_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+AppImageBatchScanner::AppImageBatchScanner(int maxConcurrentReads, QObject *parent)
+    : QObject(parent)
+{
+    p_BatchScanner = new AppImageBatchScannerPrivate(maxConcurrentReads, this);
+    connectSignals();
+    return;
+}
+
+AppImageBatchScanner::~AppImageBatchScanner()
+{
+    p_BatchScanner->deleteLater();
+    return;
+}
+
+void AppImageBatchScanner::scanDirectory(const QString &directory)
+{
+    getMethod(p_BatchScanner, "scanDirectory(const QString&)")
+    .invoke(p_BatchScanner, Qt::QueuedConnection, Q_ARG(QString, directory));
+    return;
+}
+
+void AppImageBatchScanner::scanAppImages(const QStringList &AppImages)
+{
+    getMethod(p_BatchScanner, "scanAppImages(const QStringList&)")
+    .invoke(p_BatchScanner, Qt::QueuedConnection, Q_ARG(QStringList, AppImages));
+    return;
+}
+
+void AppImageBatchScanner::setMaxConcurrentReads(int maxConcurrentReads)
+{
+    getMethod(p_BatchScanner, "setMaxConcurrentReads(int)")
+    .invoke(p_BatchScanner, Qt::QueuedConnection, Q_ARG(int, maxConcurrentReads));
+    return;
+}
+
+void AppImageBatchScanner::setCalculateSha1Hash(bool choice)
+{
+    getMethod(p_BatchScanner, "setCalculateSha1Hash(bool)")
+    .invoke(p_BatchScanner, Qt::QueuedConnection, Q_ARG(bool, choice));
+    return;
+}
+
+void AppImageBatchScanner::cancel(void)
+{
+    getMethod(p_BatchScanner, "cancel(void)").invoke(p_BatchScanner, Qt::QueuedConnection);
+    return;
+}
+
+void AppImageBatchScanner::connectSignals()
+{
+    connect(p_BatchScanner, &AppImageBatchScannerPrivate::started,
+            this, &AppImageBatchScanner::started, Qt::DirectConnection);
+    connect(p_BatchScanner, &AppImageBatchScannerPrivate::canceled,
+            this, &AppImageBatchScanner::canceled, Qt::DirectConnection);
+    connect(p_BatchScanner, &AppImageBatchScannerPrivate::finished,
+            this, &AppImageBatchScanner::finished, Qt::DirectConnection);
+    connect(p_BatchScanner, &AppImageBatchScannerPrivate::appImageScanned,
+            this, &AppImageBatchScanner::appImageScanned, Qt::DirectConnection);
+    connect(p_BatchScanner, &AppImageBatchScannerPrivate::scanError,
+            this, &AppImageBatchScanner::scanError, Qt::DirectConnection);
+    connect(p_BatchScanner, &AppImageBatchScannerPrivate::progress,
+            this, &AppImageBatchScanner::progress, Qt::DirectConnection);
+}
@@ -0,0 +1,259 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : appimagebatchscanner_p.cc
+ * @description : This is where the private batch scanner is implemented.
+ * Every AppImage is scanned by a AppImageScanRunnable in a thread pool whose
+ * size limits the number of AppImages read concurrently.
+*/
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThread>
+
+#include "../include/appimagebatchscanner_p.hpp"
+#include "../include/appimageupdateinformation_p.hpp"
+#include "../include/sha1hasher_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+/*
+ * Scans a single AppImage in a worker thread and posts the result back to the
+ * receiver's handleScanResult(int, QString, short, QJsonObject) slot.
+ * Nothing is posted if the batch was canceled meanwhile.
+*/
+class AppImageScanRunnable : public QRunnable
+{
+public:
+    AppImageScanRunnable(QObject *receiver, QAtomicInt *generation, const QString &AppImagePath,
+                         bool calculateSha1Hash, bool skipNonAppImages)
+        : b_CalculateSha1Hash(calculateSha1Hash),
+          b_SkipNonAppImages(skipNonAppImages),
+          n_Generation(generation->load()),
+          p_Generation(generation),
+          p_Receiver(receiver),
+          s_AppImagePath(AppImagePath)
+    {
+        return;
+    }
+
+    void run() override
+    {
+        if(p_Generation->load() != n_Generation) {
+            return;
+        }
+
+        QJsonObject result;
+        short errorCode = scan(&result);
+
+        if(p_Generation->load() != n_Generation) {
+            return;
+        }
+        QMetaObject::invokeMethod(p_Receiver, "handleScanResult", Qt::QueuedConnection,
+                                  Q_ARG(int, n_Generation),
+                                  Q_ARG(QString, s_AppImagePath),
+                                  Q_ARG(short, errorCode),
+                                  Q_ARG(QJsonObject, result));
+        return;
+    }
+private:
+    short scan(QJsonObject *result)
+    {
+        QString updateString;
+        QJsonObject updateInformation;
+        QFile AppImage(s_AppImagePath);
+        if(!AppImage.open(QIODevice::ReadOnly)) {
+            return CannotOpenAppimage;
+        }
+
+        short errorCode = AppImageUpdateInformationPrivate::readUpdateString(&AppImage, &updateString);
+        if(errorCode == NoError) {
+            errorCode = AppImageUpdateInformationPrivate::parseUpdateString(updateString, &updateInformation);
+        }
+        if(errorCode != NoError) {
+            /* Files which are not AppImages are silently skipped when scanning directories. */
+            if(b_SkipNonAppImages && (errorCode == InvalidMagicBytes || errorCode == InvalidAppimageType)) {
+                return NoError;
+            }
+            return errorCode;
+        }
+
+        QJsonObject fileInformation {
+            { "AppImageFilePath", s_AppImagePath }
+        };
+        if(b_CalculateSha1Hash) {
+            Sha1HasherPrivate SHA1Hasher;
+            if(!AppImage.seek(0) || !SHA1Hasher.addData(&AppImage)) {
+                return AppimageNotReadable;
+            }
+            fileInformation["AppImageSHA1Hash"] = QString(SHA1Hasher.result().toHex().toUpper());
+        }
+
+        QJsonObject buffer {
+            { "IsEmpty", updateInformation.isEmpty() },
+            { "FileInformation", fileInformation },
+            { "UpdateInformation", updateInformation }
+        };
+        *result = buffer;
+        return NoError;
+    }
+
+    bool b_CalculateSha1Hash = true,
+         b_SkipNonAppImages = false;
+    int n_Generation = 0;
+    QAtomicInt *p_Generation = nullptr;
+    QObject *p_Receiver = nullptr;
+    QString s_AppImagePath;
+};
+
+/*
+ * AppImageBatchScannerPrivate scans many AppImages in parallel , The number of
+ * AppImages read at the same time is limited by the given maxConcurrentReads ,
+ * A value less than 1 uses the ideal thread count of the system.
+ *
+ * Example:
+ * 	AppImageBatchScannerPrivate scanner(4);
+ * 	scanner.scanDirectory("/opt/AppImages");
+*/
+AppImageBatchScannerPrivate::AppImageBatchScannerPrivate(int maxConcurrentReads, QObject *parent)
+    : QObject(parent)
+{
+    p_ThreadPool.reset(new QThreadPool);
+    setMaxConcurrentReads(maxConcurrentReads);
+    return;
+}
+
+AppImageBatchScannerPrivate::~AppImageBatchScannerPrivate()
+{
+    n_Generation.fetchAndAddOrdered(1);
+    p_ThreadPool->clear();
+    p_ThreadPool->waitForDone();
+    return;
+}
+
+void AppImageBatchScannerPrivate::setMaxConcurrentReads(int maxConcurrentReads)
+{
+    if(maxConcurrentReads < 1) {
+        maxConcurrentReads = QThread::idealThreadCount();
+    }
+    p_ThreadPool->setMaxThreadCount(maxConcurrentReads < 1 ? 1 : maxConcurrentReads);
+    return;
+}
+
+void AppImageBatchScannerPrivate::setCalculateSha1Hash(bool choice)
+{
+    b_CalculateSha1Hash = choice;
+    return;
+}
+
+/*
+ * Scans all the files directly inside the given directory , Files which are
+ * not AppImages are skipped without any error.
+*/
+void AppImageBatchScannerPrivate::scanDirectory(const QString &directory)
+{
+    QDirIterator it(directory, QDir::Files | QDir::NoDotAndDotDot | QDir::Readable);
+    while(it.hasNext()) {
+        enqueue(it.next(), /*skipNonAppImages=*/true);
+    }
+
+    /* Nothing to scan. */
+    if(!n_Total) {
+        emit started();
+        emit finished();
+    }
+    return;
+}
+
+/* Scans the given AppImages , Every path which fails is reported with scanError. */
+void AppImageBatchScannerPrivate::scanAppImages(const QStringList &AppImages)
+{
+    for(auto &AppImage : AppImages) {
+        enqueue(AppImage, /*skipNonAppImages=*/false);
+    }
+
+    if(!n_Total) {
+        emit started();
+        emit finished();
+    }
+    return;
+}
+
+/* Drops all the queued AppImages and ignores the results of the running ones. */
+void AppImageBatchScannerPrivate::cancel(void)
+{
+    if(!n_Total) {
+        return;
+    }
+    n_Generation.fetchAndAddOrdered(1);
+    p_ThreadPool->clear();
+    n_Scanned = n_Total = 0;
+    emit canceled();
+    return;
+}
+
+void AppImageBatchScannerPrivate::enqueue(const QString &AppImage, bool skipNonAppImages)
+{
+    if(AppImage.isEmpty()) {
+        return;
+    }
+    if(!n_Total) {
+        emit started();
+    }
+    ++n_Total;
+    p_ThreadPool->start(new AppImageScanRunnable(this, &n_Generation, QFileInfo(AppImage).absoluteFilePath(),
+                        b_CalculateSha1Hash, skipNonAppImages));
+    return;
+}
+
+void AppImageBatchScannerPrivate::handleScanResult(int generation, QString AppImage, short errorCode,
+        QJsonObject result)
+{
+    if(generation != n_Generation.load()) {
+        return;
+    }
+
+    ++n_Scanned;
+    if(errorCode != NoError) {
+        emit scanError(AppImage, errorCode);
+    } else if(!result.isEmpty()) {
+        emit appImageScanned(result);
+    }
+    emit progress(n_Scanned, n_Total);
+
+    if(n_Scanned == n_Total) {
+        n_Scanned = n_Total = 0;
+        emit finished();
+    }
+    return;
+}
@@ -40,7 +40,11 @@
 */
 #include "../include/appimagedeltarevisioner_p.hpp"
 #include "../include/appimagedeltarevisioner.hpp"
+#include "../include/blockingupdater_p.hpp"
 #include "../include/helpers_p.hpp"
+#include "../include/zsyncmatchcache_p.hpp"
+
+#include <QMetaMethod>
 
 using namespace AppImageUpdaterBridge;
 
@@ -68,12 +72,70 @@ AppImageDeltaRevisioner::AppImageDeltaRevisioner(QFile *AppImage, bool singleThr
     return;
 }
 
+AppImageDeltaRevisioner::AppImageDeltaRevisioner(ThreadingMode threadingMode, QObject *parent)
+    : QObject(parent)
+{
+    p_DeltaRevisioner = new AppImageDeltaRevisionerPrivate(threadingMode, this);
+    connectSignals();
+    return;
+}
+
+AppImageDeltaRevisioner::AppImageDeltaRevisioner(const QString &AppImagePath, ThreadingMode threadingMode, QObject *parent)
+    : QObject(parent)
+{
+    p_DeltaRevisioner = new AppImageDeltaRevisionerPrivate(AppImagePath, threadingMode, this);
+    connectSignals();
+    return;
+}
+
+AppImageDeltaRevisioner::AppImageDeltaRevisioner(QFile *AppImage, ThreadingMode threadingMode, QObject *parent)
+    : QObject(parent)
+{
+    p_DeltaRevisioner = new AppImageDeltaRevisionerPrivate(AppImage, threadingMode, this);
+    connectSignals();
+    return;
+}
+
 AppImageDeltaRevisioner::~AppImageDeltaRevisioner()
 {
     p_DeltaRevisioner->deleteLater();
     return;
 }
 
+/*
+ * Checks for a update and blocks until the result is known , This works
+ * without a event loop and even without a QCoreApplication.
+*/
+UpdateResult AppImageDeltaRevisioner::checkForUpdateBlocking(const UpdateOptions &options)
+{
+    return BlockingUpdaterPrivate::run(options, /*checkOnly=*/true);
+}
+
+/* Updates and blocks until the update is finished , canceled or failed. */
+UpdateResult AppImageDeltaRevisioner::updateBlocking(const UpdateOptions &options)
+{
+    return BlockingUpdaterPrivate::run(options, /*checkOnly=*/false);
+}
+
+/*
+ * Adds a match cache file exported on another host to the given match cache
+ * directory , i.e the one given to setMatchCache.
+*/
+bool AppImageDeltaRevisioner::importMatchCache(const QString &file, const QString &directory)
+{
+    return ZsyncMatchCachePrivate::importFile(file, directory);
+}
+
+/*
+ * Writes the match cache of the update from the AppImage with the given SHA1
+ * hash to the new version with the given SHA1 hash to the given file.
+*/
+bool AppImageDeltaRevisioner::exportMatchCache(const QString &seedSHA1, const QString &targetSHA1,
+        const QString &file, const QString &directory)
+{
+    return ZsyncMatchCachePrivate::exportFile(directory, seedSHA1, targetSHA1, file);
+}
+
 void AppImageDeltaRevisioner::start(void)
 {
     getMethod(p_DeltaRevisioner, "start(void)").invoke(p_DeltaRevisioner, Qt::QueuedConnection);
@@ -114,6 +176,40 @@ void AppImageDeltaRevisioner::setOutputDirectory(const QString &dir)
     return;
 }
 
+void AppImageDeltaRevisioner::addSeedFile(const QString &path)
+{
+    getMethod(p_DeltaRevisioner, "addSeedFile(const QString&)")
+    .invoke(p_DeltaRevisioner, Qt::QueuedConnection, Q_ARG(QString, path));
+    return;
+}
+
+void AppImageDeltaRevisioner::addSeedDirectory(const QString &path)
+{
+    getMethod(p_DeltaRevisioner, "addSeedDirectory(const QString&)")
+    .invoke(p_DeltaRevisioner, Qt::QueuedConnection, Q_ARG(QString, path));
+    return;
+}
+
+void AppImageDeltaRevisioner::clearSeedFiles(void)
+{
+    getMethod(p_DeltaRevisioner, "clearSeedFiles(void)").invoke(p_DeltaRevisioner, Qt::QueuedConnection);
+    return;
+}
+
+void AppImageDeltaRevisioner::setBlockStore(const QString &directory, qint64 maxSize)
+{
+    getMethod(p_DeltaRevisioner, "setBlockStore(const QString&, qint64)")
+    .invoke(p_DeltaRevisioner, Qt::QueuedConnection, Q_ARG(QString, directory), Q_ARG(qint64, maxSize));
+    return;
+}
+
+void AppImageDeltaRevisioner::setMatchCache(const QString &directory)
+{
+    getMethod(p_DeltaRevisioner, "setMatchCache(const QString&)")
+    .invoke(p_DeltaRevisioner, Qt::QueuedConnection, Q_ARG(QString, directory));
+    return;
+}
+
 void AppImageDeltaRevisioner::setProxy(const QNetworkProxy &proxy){
     getMethod(p_DeltaRevisioner , "setProxy(const QNetworkProxy&)")
     .invoke(p_DeltaRevisioner , Qt::QueuedConnection, Q_ARG(QNetworkProxy , proxy));
@@ -138,6 +234,72 @@ void AppImageDeltaRevisioner::checkForUpdate(void)
     return;
 }
 
+void AppImageDeltaRevisioner::planUpdate(void)
+{
+    getMethod(p_DeltaRevisioner, "planUpdate(void)").invoke(p_DeltaRevisioner, Qt::QueuedConnection);
+    return;
+}
+
+void AppImageDeltaRevisioner::getStatistics(void)
+{
+    getMethod(p_DeltaRevisioner, "getStatistics(void)").invoke(p_DeltaRevisioner, Qt::QueuedConnection);
+    return;
+}
+
+void AppImageDeltaRevisioner::setTraceFile(const QString &path)
+{
+    getMethod(p_DeltaRevisioner, "setTraceFile(const QString&)")
+    .invoke(p_DeltaRevisioner, Qt::QueuedConnection, Q_ARG(QString, path));
+    return;
+}
+
+void AppImageDeltaRevisioner::setProgressInterval(int msecs)
+{
+    getMethod(p_DeltaRevisioner, "setProgressInterval(int)")
+    .invoke(p_DeltaRevisioner, Qt::QueuedConnection, Q_ARG(int, msecs));
+    return;
+}
+
+void AppImageDeltaRevisioner::setLogCapture(bool choice)
+{
+    getMethod(p_DeltaRevisioner, "setLogCapture(bool)")
+    .invoke(p_DeltaRevisioner, Qt::QueuedConnection, Q_ARG(bool, choice));
+    return;
+}
+
+void AppImageDeltaRevisioner::getCapturedLog(void)
+{
+    getMethod(p_DeltaRevisioner, "getCapturedLog(void)").invoke(p_DeltaRevisioner, Qt::QueuedConnection);
+    return;
+}
+
+/*
+ * The stages only format log messages when someone can see them , So we
+ * tell them whenever the logger signal gets its first or loses its last
+ * receiver.
+*/
+void AppImageDeltaRevisioner::connectNotify(const QMetaMethod &signal)
+{
+    if(p_DeltaRevisioner && signal == QMetaMethod::fromSignal(&AppImageDeltaRevisioner::logger)) {
+        getMethod(p_DeltaRevisioner, "setLoggerConnected(bool)")
+        .invoke(p_DeltaRevisioner, Qt::QueuedConnection, Q_ARG(bool, true));
+    }
+    QObject::connectNotify(signal);
+    return;
+}
+
+void AppImageDeltaRevisioner::disconnectNotify(const QMetaMethod &signal)
+{
+    if(p_DeltaRevisioner &&
+       (!signal.isValid() || signal == QMetaMethod::fromSignal(&AppImageDeltaRevisioner::logger)) &&
+       !isSignalConnected(QMetaMethod::fromSignal(&AppImageDeltaRevisioner::logger))) {
+        getMethod(p_DeltaRevisioner, "setLoggerConnected(bool)")
+        .invoke(p_DeltaRevisioner, Qt::QueuedConnection, Q_ARG(bool, false));
+    }
+    QObject::disconnectNotify(signal);
+    return;
+}
+
 void AppImageDeltaRevisioner::connectSignals()
 {
     connect(p_DeltaRevisioner, &AppImageDeltaRevisionerPrivate::started,
@@ -150,12 +312,20 @@ void AppImageDeltaRevisioner::connectSignals()
             this, &AppImageDeltaRevisioner::embededInformation, Qt::DirectConnection);
     connect(p_DeltaRevisioner, &AppImageDeltaRevisionerPrivate::updateAvailable,
             this, &AppImageDeltaRevisioner::updateAvailable, Qt::DirectConnection);
+    connect(p_DeltaRevisioner, &AppImageDeltaRevisionerPrivate::updatePlan,
+            this, &AppImageDeltaRevisioner::updatePlan, Qt::DirectConnection);
+    connect(p_DeltaRevisioner, &AppImageDeltaRevisionerPrivate::statistics,
+            this, &AppImageDeltaRevisioner::statistics, Qt::DirectConnection);
     connect(p_DeltaRevisioner, &AppImageDeltaRevisionerPrivate::statusChanged,
             this, &AppImageDeltaRevisioner::statusChanged, Qt::DirectConnection);
     connect(p_DeltaRevisioner, &AppImageDeltaRevisionerPrivate::error,
             this, &AppImageDeltaRevisioner::error, Qt::DirectConnection);
     connect(p_DeltaRevisioner, &AppImageDeltaRevisionerPrivate::progress,
             this, &AppImageDeltaRevisioner::progress, Qt::DirectConnection);
+    connect(p_DeltaRevisioner, &AppImageDeltaRevisionerPrivate::remainingTime,
+            this, &AppImageDeltaRevisioner::remainingTime, Qt::DirectConnection);
     connect(p_DeltaRevisioner, &AppImageDeltaRevisionerPrivate::logger,
             this, &AppImageDeltaRevisioner::logger, Qt::DirectConnection);
+    connect(p_DeltaRevisioner, &AppImageDeltaRevisionerPrivate::capturedLog,
+            this, &AppImageDeltaRevisioner::capturedLog, Qt::DirectConnection);
 }
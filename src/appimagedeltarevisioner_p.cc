@@ -41,31 +41,118 @@
 
 #include "../include/appimagedeltarevisioner_p.hpp"
 #include "../include/helpers_p.hpp"
+#include "../include/tracer_p.hpp"
+#include "../include/logging_p.hpp"
 
 using namespace AppImageUpdaterBridge;
 
 AppImageDeltaRevisionerPrivate::AppImageDeltaRevisionerPrivate(bool singleThreaded, QObject *parent)
+    : AppImageDeltaRevisionerPrivate(singleThreaded ? SingleThreaded : SharedThread, parent)
+{
+    return;
+}
+
+/*
+ * With SharedThread everything runs in one extra thread. With SeparateNetworkThread
+ * the control file parser , the block downloader and the network access manager get
+ * a thread of their own , so hashing and disk I/O in the writer never stall the
+ * sockets. The downloader keeps the bytes handed to the writer bounded , So a slow
+ * writer slows down the requests instead of piling up data in memory.
+*/
+AppImageDeltaRevisionerPrivate::AppImageDeltaRevisionerPrivate(ThreadingMode threadingMode, QObject *parent)
     : QObject(parent)
 {
-    setObjectName("AppImageDeltaRevisionerPrivate");
-    if(!singleThreaded) {
+    if(threadingMode != SingleThreaded) {
         p_SharedThread.reset(new QThread);
         p_SharedThread->start();
     }
+    if(threadingMode == SeparateNetworkThread) {
+        p_NetworkThread.reset(new QThread);
+        p_NetworkThread->start();
+    }
+    QThread *networkThread = p_NetworkThread.isNull() ? p_SharedThread.data() : p_NetworkThread.data();
+
     p_SharedNetworkAccessManager.reset(new QNetworkAccessManager);
+    if(networkThread) {
+        p_SharedNetworkAccessManager->moveToThread(networkThread);
+    }
+    init(p_SharedNetworkAccessManager.data(), networkThread, p_SharedThread.data());
+    return;
+}
+
+AppImageDeltaRevisionerPrivate::AppImageDeltaRevisionerPrivate(const QString &AppImagePath, ThreadingMode threadingMode, QObject *parent)
+    : AppImageDeltaRevisionerPrivate(threadingMode, parent)
+{
+    setAppImage(AppImagePath);
+    return;
+}
+
+AppImageDeltaRevisionerPrivate::AppImageDeltaRevisionerPrivate(QFile *AppImage, ThreadingMode threadingMode, QObject *parent)
+    : AppImageDeltaRevisionerPrivate(threadingMode, parent)
+{
+    setAppImage(AppImage);
+    return;
+}
+
+/*
+ * Creates a revisioner which does not own any thread or network access manager ,
+ * the given network access manager and threads are shared with other revisioners.
+ * The control file parser and the block downloader live in the network thread ,
+ * the update information and the delta writer live in the worker thread.
+ * Requests and seed scans are limited by the given limiters if they are
+ * not null , The AppImage and the seed indexes are hashed in the given pool ,
+ * the global thread pool if null.
+ *
+ * Example:
+ * 	AppImageDeltaRevisionerPrivate revisioner(&manager, &networkThread, &workerThread,
+ * 						  &limiter, &seedScanLimiter, &pool);
+*/
+AppImageDeltaRevisionerPrivate::AppImageDeltaRevisionerPrivate(QNetworkAccessManager *networkAccessManager,
+        QThread *networkThread,
+        QThread *workerThread,
+        ZsyncRequestLimiterPrivate *requestLimiter,
+        ZsyncRequestLimiterPrivate *seedScanLimiter,
+        QThreadPool *workerPool,
+        QObject *parent)
+    : QObject(parent)
+{
+    init(networkAccessManager, networkThread, workerThread, requestLimiter, seedScanLimiter, workerPool);
+    return;
+}
+
+void AppImageDeltaRevisionerPrivate::init(QNetworkAccessManager *networkAccessManager,
+        QThread *networkThread,
+        QThread *workerThread,
+        ZsyncRequestLimiterPrivate *requestLimiter,
+        ZsyncRequestLimiterPrivate *seedScanLimiter,
+        QThreadPool *workerPool)
+{
+    setObjectName("AppImageDeltaRevisionerPrivate");
+    p_NetworkAccessManager = networkAccessManager;
     p_UpdateInformation.reset(new AppImageUpdateInformationPrivate);
+    p_UpdateInformation->setHashPool(workerPool);
     p_DeltaWriter.reset(new ZsyncWriterPrivate);
-    if(!singleThreaded) {
-        p_SharedNetworkAccessManager->moveToThread(p_SharedThread.data());
-        p_UpdateInformation->moveToThread(p_SharedThread.data());
-        p_DeltaWriter->moveToThread(p_SharedThread.data());
+    p_DeltaWriter->setSeedScanLimiter(seedScanLimiter);
+    p_DeltaWriter->setWorkerPool(workerPool);
+    /*
+     * Seed scans and downloads only count their bytes , the aggregator publishes them.
+     * The writer and the downloader may outlive us in threads owned by someone else ,
+     * so they share the aggregator , which is deleted in this thread.
+    */
+    p_Progress = QSharedPointer<ZsyncProgressAggregatorPrivate>(new ZsyncProgressAggregatorPrivate,
+                 &QObject::deleteLater);
+    p_DeltaWriter->setProgressAggregator(p_Progress);
+    if(workerThread) {
+        p_UpdateInformation->moveToThread(workerThread);
+        p_DeltaWriter->moveToThread(workerThread);
     }
-    p_ControlFileParser.reset(new ZsyncRemoteControlFileParserPrivate(p_SharedNetworkAccessManager.data()));
+    p_ControlFileParser.reset(new ZsyncRemoteControlFileParserPrivate(p_NetworkAccessManager));
     p_BlockDownloader.reset(new ZsyncBlockRangeDownloaderPrivate(p_DeltaWriter.data(),
-                            p_SharedNetworkAccessManager.data()));
-    if(!singleThreaded) {
-        p_ControlFileParser->moveToThread(p_SharedThread.data());
-        p_BlockDownloader->moveToThread(p_SharedThread.data());
+                            p_NetworkAccessManager, requestLimiter));
+    p_BlockDownloader->setProgressAggregator(p_Progress);
+    if(networkThread) {
+        p_ControlFileParser->moveToThread(networkThread);
+        p_BlockDownloader->moveToThread(networkThread);
     }
     p_ControlFileParser->setObjectName("ZsyncRemoteControlFileParserPrivate");
     p_UpdateInformation->setObjectName("AppImageUpdateInformationPrivate");
@@ -83,9 +170,12 @@ AppImageDeltaRevisionerPrivate::AppImageDeltaRevisionerPrivate(bool singleThread
     connect(p_UpdateInformation.data(), &AppImageUpdateInformationPrivate::progress,
             this, &AppImageDeltaRevisionerPrivate::handleIndeterminateProgress ,
 	    Qt::UniqueConnection);
+    connect(p_UpdateInformation.data(), &AppImageUpdateInformationPrivate::partialInfo,
+            this, &AppImageDeltaRevisionerPrivate::handlePartialInformation,
+	    Qt::UniqueConnection);
     connect(p_UpdateInformation.data(), &AppImageUpdateInformationPrivate::info,
-            this, &AppImageDeltaRevisionerPrivate::embededInformation, 
-	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
+            this, &AppImageDeltaRevisionerPrivate::handleEmbededInformation,
+	    Qt::UniqueConnection);
     connect(p_UpdateInformation.data(), &AppImageUpdateInformationPrivate::error,
             this, &AppImageDeltaRevisionerPrivate::error,
 	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
@@ -107,6 +197,12 @@ AppImageDeltaRevisionerPrivate::AppImageDeltaRevisionerPrivate(bool singleThread
     connect(p_ControlFileParser.data(), &ZsyncRemoteControlFileParserPrivate::logger,
             this, &AppImageDeltaRevisionerPrivate::logger,
 	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
+    connect(p_ControlFileParser.data(), &ZsyncRemoteControlFileParserPrivate::receiveControlFile,
+            p_ControlFileParser.data(), &ZsyncRemoteControlFileParserPrivate::getUpdateCheckInformation,
+	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
+    connect(p_ControlFileParser.data(), &ZsyncRemoteControlFileParserPrivate::updateCheckInformation,
+            this, &AppImageDeltaRevisionerPrivate::handleUpdateCheckInformation,
+	    Qt::UniqueConnection);
     
     /* Connect ZsyncWriterPrivate */
     connect(p_DeltaWriter.data(), &ZsyncWriterPrivate::statusChanged,
@@ -127,6 +223,12 @@ AppImageDeltaRevisionerPrivate::AppImageDeltaRevisionerPrivate(bool singleThread
     connect(p_DeltaWriter.data(), &ZsyncWriterPrivate::finished,
             this, &AppImageDeltaRevisionerPrivate::finished,
 	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
+    connect(p_DeltaWriter.data(), &ZsyncWriterPrivate::statistics,
+            this, &AppImageDeltaRevisionerPrivate::statistics,
+	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
+    connect(p_DeltaWriter.data(), &ZsyncWriterPrivate::plan,
+            this, &AppImageDeltaRevisionerPrivate::handlePlan,
+	    Qt::UniqueConnection);
     
     /* connect BlockDownloader */
     connect(p_BlockDownloader.data(), &ZsyncBlockRangeDownloaderPrivate::error,
@@ -135,35 +237,41 @@ AppImageDeltaRevisionerPrivate::AppImageDeltaRevisionerPrivate(bool singleThread
     connect(p_BlockDownloader.data(), &ZsyncBlockRangeDownloaderPrivate::canceled,
             this, &AppImageDeltaRevisionerPrivate::canceled,
 	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
-    connect(p_BlockDownloader.data(), &ZsyncBlockRangeDownloaderPrivate::started,
-            this, &AppImageDeltaRevisionerPrivate::handleBlockDownloaderStarted, 
-	    (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
-    connect(p_BlockDownloader.data(), &ZsyncBlockRangeDownloaderPrivate::finished,
-            this, &AppImageDeltaRevisionerPrivate::handleBlockDownloaderFinished , 
-	    (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
-    connect(p_BlockDownloader.data(), &ZsyncBlockRangeDownloaderPrivate::progress,
+    connect(p_Progress.data(), &ZsyncProgressAggregatorPrivate::progress,
             this, &AppImageDeltaRevisionerPrivate::progress,
 	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
+    connect(p_Progress.data(), &ZsyncProgressAggregatorPrivate::remainingTime,
+            this, &AppImageDeltaRevisionerPrivate::remainingTime,
+	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
     
     
 
     /* Connect the recieveControlFile signal to ZsyncWriter */
-    connect(p_DeltaWriter.data(), &ZsyncWriterPrivate::progress,
-            this, &AppImageDeltaRevisionerPrivate::progress,
-	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
     connect(p_ControlFileParser.data(), &ZsyncRemoteControlFileParserPrivate::zsyncInformation,
             p_DeltaWriter.data(), &ZsyncWriterPrivate::setConfiguration, 
 	    (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
     connect(p_DeltaWriter.data(), &ZsyncWriterPrivate::finishedConfiguring,
-            p_DeltaWriter.data(), &ZsyncWriterPrivate::start,
+            this, &AppImageDeltaRevisionerPrivate::handleWriterConfigured,
+	    (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
+
+    /* Requests sent by the state machine , connected once for the lifetime of this object. */
+    connect(this, &AppImageDeltaRevisionerPrivate::requestEmbededInformation,
+            p_UpdateInformation.data(), &AppImageUpdateInformationPrivate::getInfo,
+	    (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
+    connect(this, &AppImageDeltaRevisionerPrivate::requestControlFile,
+            p_ControlFileParser.data(),
+            static_cast<void (ZsyncRemoteControlFileParserPrivate::*)(QJsonObject)>(&ZsyncRemoteControlFileParserPrivate::setControlFileUrl),
+	    (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
+    connect(this, &AppImageDeltaRevisionerPrivate::requestZsyncInformation,
+            p_ControlFileParser.data(), &ZsyncRemoteControlFileParserPrivate::getZsyncInformation,
 	    (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
 
 
-   /* Reset connection whenever error, canceled or finished */
-   connect(this , &AppImageDeltaRevisionerPrivate::embededInformation , this , &AppImageDeltaRevisionerPrivate::resetConnections);
-   connect(this , &AppImageDeltaRevisionerPrivate::error , this , &AppImageDeltaRevisionerPrivate::resetConnections);
-   connect(this , &AppImageDeltaRevisionerPrivate::canceled , this , &AppImageDeltaRevisionerPrivate::resetConnections);
-   connect(this , &AppImageDeltaRevisionerPrivate::finished , this , &AppImageDeltaRevisionerPrivate::resetConnections);
+   /* Reset the state whenever error, canceled or finished */
+   connect(this , &AppImageDeltaRevisionerPrivate::error , this , &AppImageDeltaRevisionerPrivate::resetState);
+   connect(this , &AppImageDeltaRevisionerPrivate::canceled , this , &AppImageDeltaRevisionerPrivate::resetState);
+   connect(this , &AppImageDeltaRevisionerPrivate::finished , this , &AppImageDeltaRevisionerPrivate::resetState);
+   return;
 }
 
 AppImageDeltaRevisionerPrivate::AppImageDeltaRevisionerPrivate(const QString &AppImagePath, bool singleThreaded, QObject *parent)
@@ -182,70 +290,66 @@ AppImageDeltaRevisionerPrivate::AppImageDeltaRevisionerPrivate(QFile *AppImage,
 
 AppImageDeltaRevisionerPrivate::~AppImageDeltaRevisionerPrivate()
 {
-    cancel(); /* Cancel anything before exiting. */
+    cancelStages(); /* Cancel anything before exiting. */
+    if(!s_TraceFile.isEmpty()) {
+        TracerPrivate::release();
+    }
     if(!p_SharedThread.isNull()) {
         p_SharedThread->quit();
         p_SharedThread->wait();
+        if(!p_NetworkThread.isNull()) {
+            p_NetworkThread->quit();
+            p_NetworkThread->wait();
+        }
+    } else if(p_DeltaWriter->thread() != thread() || p_BlockDownloader->thread() != thread()) {
+        /*
+         * The threads are owned by someone else and are still running ,
+         * so let them delete their objects.
+        */
+        p_UpdateInformation.take()->deleteLater();
+        p_DeltaWriter.take()->deleteLater();
+        p_ControlFileParser.take()->deleteLater();
+        p_BlockDownloader.take()->deleteLater();
     }
     return;
 }
 
+/*
+ * The revisioner is a small state machine , start , checkForUpdate and
+ * getAppImageEmbededInformation only set the operation and request the
+ * embeded information. Everything else is driven by the handlers below
+ * which advance to the next stage , All connections are made once in init.
+ *
+ * Stages:
+ * 	Idle -> EmbededInformation -> (EmbededInformation + UpdateCheckInformation)
+ * 	     -> updateAvailable    (UpdateCheckOperation)
+ * 	     -> Writing/Downloading -> finished (UpdateOperation)
+ * 	     -> Dry run of the writer -> updatePlan (PlanOperation)
+*/
 void AppImageDeltaRevisionerPrivate::start(void)
 {
-    if(b_Busy){
-	    return;
-    }
-    connect(p_UpdateInformation.data(), SIGNAL(info(QJsonObject)),
-            p_ControlFileParser.data(), SLOT(setControlFileUrl(QJsonObject)),
-	    (Qt::ConnectionType)(Qt::UniqueConnection | Qt::QueuedConnection));
-    connect(p_ControlFileParser.data(), SIGNAL(receiveControlFile(void)),
-            p_ControlFileParser.data(), SLOT(getUpdateCheckInformation(void)),
-	    (Qt::ConnectionType)(Qt::UniqueConnection | Qt::QueuedConnection));
-    connect(p_ControlFileParser.data(), SIGNAL(updateCheckInformation(QJsonObject)),
-            this, SLOT(doStart(QJsonObject)),
-	    (Qt::ConnectionType)(Qt::UniqueConnection | Qt::QueuedConnection));
-    disconnect(p_UpdateInformation.data(), &AppImageUpdateInformationPrivate::progress,
-            this, &AppImageDeltaRevisionerPrivate::handleIndeterminateProgress);
-    disconnect(p_ControlFileParser.data(), &ZsyncRemoteControlFileParserPrivate::progress,
-            this, &AppImageDeltaRevisionerPrivate::handleIndeterminateProgress);
-    disconnect(p_UpdateInformation.data(), &AppImageUpdateInformationPrivate::info,
-               this, &AppImageDeltaRevisionerPrivate::embededInformation);
-    getMethod(p_UpdateInformation.data(), "getInfo(void)").invoke(p_UpdateInformation.data(), Qt::QueuedConnection); 
-    b_Busy = true;
+    beginOperation(UpdateOperation);
     return;
 }
 
-void AppImageDeltaRevisionerPrivate::doStart(QJsonObject information)
+/*
+ * Until the writer is started the operation only waits for the update
+ * information and the control file parser , So their late results are
+ * dropped and canceled is emitted right away. From then on the writer and
+ * the downloader emit canceled once they have stopped.
+*/
+void AppImageDeltaRevisionerPrivate::cancel(void)
 {
-    resetConnections();
-    if(information.isEmpty()) {
-        return;
-    }
-
-    auto embededUpdateInformation = information["EmbededUpdateInformation"].toObject();
-    auto remoteTargetFileSHA1Hash = information["RemoteTargetFileSHA1Hash"].toString();
-    QString localAppImageSHA1Hash = embededUpdateInformation["FileInformation"].toObject()["AppImageSHA1Hash"].toString(),
-            localAppImagePath = embededUpdateInformation["FileInformation"].toObject()["AppImageFilePath"].toString();
-    auto oldVersionInformation = embededUpdateInformation["FileInformation"].toObject();
-
-    if(localAppImageSHA1Hash != remoteTargetFileSHA1Hash) {
-        auto metaObject = p_ControlFileParser->metaObject();
-        metaObject->method(metaObject->indexOfMethod(QMetaObject::normalizedSignature("getZsyncInformation(void)")))
-        .invoke(p_ControlFileParser.data(), Qt::QueuedConnection);
-    } else {
-        /* Current Version is the new version. */
-	emit started(); /* Some may depend on this signal. */
-        QJsonObject newVersionDetails {
-            { "AbsolutePath", oldVersionInformation["AppImageFilePath"].toString() },
-            { "Sha1Hash", oldVersionInformation["AppImageSHA1Hash"].toString() }
-        };
-        emit finished(newVersionDetails, oldVersionInformation["AppImageFilePath"].toString());
+    cancelStages();
+    if(n_Operation != NoOperation && !b_WriterStarted) {
+        emit canceled();
     }
     return;
 }
 
-void AppImageDeltaRevisionerPrivate::cancel(void)
+void AppImageDeltaRevisionerPrivate::cancelStages(void)
 {
+    getMethod(p_ControlFileParser.data(), "cancel(void)").invoke(p_ControlFileParser.data(), Qt::QueuedConnection);
     getMethod(p_DeltaWriter.data(),"cancel(void)").invoke(p_DeltaWriter.data(), Qt::QueuedConnection);
     getMethod(p_BlockDownloader.data(), "cancel(void)").invoke(p_BlockDownloader.data(), Qt::QueuedConnection);
     return;
@@ -286,6 +390,39 @@ void AppImageDeltaRevisionerPrivate::setShowLog(bool choice)
     return;
 }
 
+/*
+ * Keeps the last log messages of all stages in a process wide ring buffer ,
+ * even when nobody shows or listens to the log. Use getCapturedLog to read
+ * them , for example to attach them to a bug report.
+*/
+void AppImageDeltaRevisionerPrivate::setLogCapture(bool choice)
+{
+    LogRingBufferPrivate::setEnabled(choice);
+    return;
+}
+
+/* Emits capturedLog with the messages in the ring buffer , oldest first. */
+void AppImageDeltaRevisionerPrivate::getCapturedLog(void)
+{
+    emit capturedLog(LogRingBufferPrivate::messages());
+    return;
+}
+
+/*
+ * Tells the stages if someone is connected to the public logger signal ,
+ * Log messages are not formatted at all if nobody would see them.
+*/
+void AppImageDeltaRevisionerPrivate::setLoggerConnected(bool connected)
+{
+    getMethod(p_UpdateInformation.data(), "setLoggerConnected(bool)").invoke(p_UpdateInformation.data(),
+            Qt::QueuedConnection, Q_ARG(bool, connected));
+    getMethod(p_ControlFileParser.data(), "setLoggerConnected(bool)").invoke(p_ControlFileParser.data(),
+            Qt::QueuedConnection, Q_ARG(bool, connected));
+    getMethod(p_DeltaWriter.data(), "setLoggerConnected(bool)").invoke(p_DeltaWriter.data(),
+            Qt::QueuedConnection, Q_ARG(bool, connected));
+    return;
+}
+
 void AppImageDeltaRevisionerPrivate::setOutputDirectory(const QString &dir)
 {
     if(b_Busy){
@@ -297,18 +434,74 @@ void AppImageDeltaRevisionerPrivate::setOutputDirectory(const QString &dir)
     return;
 }
 
-void AppImageDeltaRevisionerPrivate::setProxy(const QNetworkProxy &proxy){
-    p_SharedNetworkAccessManager->setProxy(proxy);
+/* Extra seed files are scanned after the default seeds , best matching first. */
+void AppImageDeltaRevisionerPrivate::addSeedFile(const QString &path)
+{
+    if(b_Busy){
+	    return;
+    }
+    getMethod(p_DeltaWriter.data(), "addSeedFile(const QString&)").invoke(p_DeltaWriter.data(),
+            Qt::QueuedConnection,
+            Q_ARG(QString, path));
     return;
 }
 
-void AppImageDeltaRevisionerPrivate::getAppImageEmbededInformation(void)
+void AppImageDeltaRevisionerPrivate::addSeedDirectory(const QString &path)
 {
     if(b_Busy){
 	    return;
     }
-    b_Busy = true;
-    getMethod(p_UpdateInformation.data(), "getInfo(void)").invoke(p_UpdateInformation.data(), Qt::QueuedConnection); 
+    getMethod(p_DeltaWriter.data(), "addSeedDirectory(const QString&)").invoke(p_DeltaWriter.data(),
+            Qt::QueuedConnection,
+            Q_ARG(QString, path));
+    return;
+}
+
+void AppImageDeltaRevisionerPrivate::clearSeedFiles(void)
+{
+    if(b_Busy){
+	    return;
+    }
+    getMethod(p_DeltaWriter.data(), "clearSeedFiles(void)").invoke(p_DeltaWriter.data(), Qt::QueuedConnection);
+    return;
+}
+
+/*
+ * Blocks still missing after the seed scan are looked up in the given block store ,
+ * which is shared by all updaters using the same directory.
+*/
+void AppImageDeltaRevisionerPrivate::setBlockStore(const QString &directory, qint64 maxSize)
+{
+    if(b_Busy){
+	    return;
+    }
+    getMethod(p_DeltaWriter.data(), "setBlockStore(const QString&, qint64)").invoke(p_DeltaWriter.data(),
+            Qt::QueuedConnection,
+            Q_ARG(QString, directory),
+            Q_ARG(qint64, maxSize));
+    return;
+}
+
+/* The scan results of the AppImage are kept in the given directory. */
+void AppImageDeltaRevisionerPrivate::setMatchCache(const QString &directory)
+{
+    if(b_Busy){
+	    return;
+    }
+    getMethod(p_DeltaWriter.data(), "setMatchCache(const QString&)").invoke(p_DeltaWriter.data(),
+            Qt::QueuedConnection,
+            Q_ARG(QString, directory));
+    return;
+}
+
+void AppImageDeltaRevisionerPrivate::setProxy(const QNetworkProxy &proxy){
+    p_NetworkAccessManager->setProxy(proxy);
+    return;
+}
+
+void AppImageDeltaRevisionerPrivate::getAppImageEmbededInformation(void)
+{
+    beginOperation(EmbededInformationOperation);
     return;
 }
 
@@ -326,45 +519,86 @@ void AppImageDeltaRevisionerPrivate::clear(void)
 
 void AppImageDeltaRevisionerPrivate::checkForUpdate(void)
 {
-    if(b_Busy){
-	    return;
-    }
-    connect(p_UpdateInformation.data(), SIGNAL(info(QJsonObject)),
-            p_ControlFileParser.data(), SLOT(setControlFileUrl(QJsonObject)),
-	    (Qt::ConnectionType)(Qt::UniqueConnection | Qt::QueuedConnection));
-    connect(p_ControlFileParser.data(), SIGNAL(receiveControlFile(void)),
-            p_ControlFileParser.data(), SLOT(getUpdateCheckInformation(void)),
-	    (Qt::ConnectionType)(Qt::UniqueConnection | Qt::QueuedConnection));
-    connect(p_ControlFileParser.data(), SIGNAL(updateCheckInformation(QJsonObject)),
-            this, SLOT(handleUpdateCheckInformation(QJsonObject)),
-	    (Qt::ConnectionType)(Qt::UniqueConnection | Qt::QueuedConnection));
-    disconnect(p_UpdateInformation.data(), &AppImageUpdateInformationPrivate::info,
-               this, &AppImageDeltaRevisionerPrivate::embededInformation);
-    getMethod(p_UpdateInformation.data(), "getInfo(void)").invoke(p_UpdateInformation.data(), Qt::QueuedConnection); 
-    b_Busy = true;
+    beginOperation(UpdateCheckOperation);
     return;
 }
 
-void AppImageDeltaRevisionerPrivate::handleBlockDownloaderStarted(void)
+/*
+ * Scans the seed files against the remote control file without writing
+ * anything and emits updatePlan with the bytes left to download.
+*/
+void AppImageDeltaRevisionerPrivate::planUpdate(void)
 {
-    connect(p_BlockDownloader.data(), &ZsyncBlockRangeDownloaderPrivate::progress,
-            this, &AppImageDeltaRevisionerPrivate::progress,
-	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
-    disconnect(p_DeltaWriter.data(), &ZsyncWriterPrivate::progress,
-            this, &AppImageDeltaRevisionerPrivate::progress); 
+    beginOperation(PlanOperation);
+    return;
+}
+
+/*
+ * Emits statistics with the block matcher counters of the last seed scan ,
+ * the writer answers in its own thread so this is safe while busy.
+*/
+void AppImageDeltaRevisionerPrivate::getStatistics(void)
+{
+    getMethod(p_DeltaWriter.data(), "getStatistics(void)").invoke(p_DeltaWriter.data(), Qt::QueuedConnection);
+    return;
 }
 
-void AppImageDeltaRevisionerPrivate::handleBlockDownloaderFinished(void)
+/*
+ * Records the phases of every operation from now on and writes them as
+ * Chrome trace events to the given file whenever a operation ends , The
+ * file can be loaded in Perfetto or chrome://tracing. An empty path stops
+ * tracing.
+ *
+ * Note:
+ * 	The recorder is shared by the whole process , So the file also has the
+ * 	events of other revisioners which trace at the same time.
+*/
+void AppImageDeltaRevisionerPrivate::setTraceFile(const QString &path)
+{
+    if(b_Busy) {
+        return;
+    }
+    if(s_TraceFile.isEmpty() && !path.isEmpty()) {
+        TracerPrivate::acquire();
+    } else if(!s_TraceFile.isEmpty() && path.isEmpty()) {
+        TracerPrivate::release();
+    }
+    s_TraceFile = path;
+    return;
+}
+
+/*
+ * Sets how often the progress of seed scans and downloads is published , in
+ * milliseconds. The default is 100 , i.e 10 times per second.
+*/
+void AppImageDeltaRevisionerPrivate::setProgressInterval(int msecs)
 {
-    connect(p_DeltaWriter.data(), &ZsyncWriterPrivate::progress,
-            this, &AppImageDeltaRevisionerPrivate::progress, (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
-    disconnect(p_BlockDownloader.data(), &ZsyncBlockRangeDownloaderPrivate::progress,
-            this, &AppImageDeltaRevisionerPrivate::progress);
+    p_Progress->setInterval(msecs);
+    return;
 }
 
+/* Starts a operation if no other operation is running. */
+void AppImageDeltaRevisionerPrivate::beginOperation(short operation)
+{
+    if(b_Busy) {
+        return;
+    }
+    b_Busy = true;
+    b_WriterStarted = false;
+    n_Operation = operation;
+    TracerPrivate::asyncBegin("Operation", this, QJsonObject { { "Operation", operation } });
+    m_LocalInformation = LocalInformation();
+    m_RemoteInformation = RemoteInformation();
+    emit requestEmbededInformation();
+    return;
+}
 
+/* The indeterminate progress of the information stages is not shown while updating. */
 void AppImageDeltaRevisionerPrivate::handleIndeterminateProgress(int percentage)
 {
+    if(n_Operation == UpdateOperation) {
+        return;
+    }
     emit progress(percentage,
                   /*no bytes received*/0,
                   /*no bytes total*/0,
@@ -373,51 +607,167 @@ void AppImageDeltaRevisionerPrivate::handleIndeterminateProgress(int percentage)
     return;
 }
 
+/* The update information is parsed , the control file can be requested while hashing. */
+void AppImageDeltaRevisionerPrivate::handlePartialInformation(QJsonObject information)
+{
+    if(n_Operation != UpdateCheckOperation && n_Operation != UpdateOperation &&
+       n_Operation != PlanOperation) {
+        return;
+    }
+    emit requestControlFile(information);
+    return;
+}
+
+void AppImageDeltaRevisionerPrivate::handleEmbededInformation(QJsonObject information)
+{
+    if(n_Operation == EmbededInformationOperation) {
+        resetState();
+        emit embededInformation(information);
+        return;
+    }
+    if(n_Operation == NoOperation || m_LocalInformation.b_Available) {
+        return;
+    }
+
+    auto fileInformation = information["FileInformation"].toObject();
+    m_LocalInformation.b_Available = true;
+    m_LocalInformation.s_AppImagePath = fileInformation["AppImageFilePath"].toString();
+    m_LocalInformation.s_Sha1Hash = fileInformation["AppImageSHA1Hash"].toString();
+    advance();
+    return;
+}
+
 void AppImageDeltaRevisionerPrivate::handleUpdateCheckInformation(QJsonObject information)
 {
-    resetConnections();
+    if(n_Operation != UpdateCheckOperation && n_Operation != UpdateOperation &&
+       n_Operation != PlanOperation) {
+        return;
+    }
+    if(m_RemoteInformation.b_Available) {
+        return;
+    }
     if(information.isEmpty()) {
+        resetState();
+        return;
+    }
+
+    m_RemoteInformation.b_Available = true;
+    m_RemoteInformation.s_Sha1Hash = information["RemoteTargetFileSHA1Hash"].toString();
+    m_RemoteInformation.s_ReleaseNotes = information["ReleaseNotes"].toString();
+    advance();
+    return;
+}
+
+/*
+ * Called whenever a result arrives , moves to the next stage once both
+ * the local and the remote information are known.
+*/
+void AppImageDeltaRevisionerPrivate::advance(void)
+{
+    if(!m_LocalInformation.b_Available || !m_RemoteInformation.b_Available) {
+        return;
+    }
+    bool isUpdateAvailable = (m_LocalInformation.s_Sha1Hash != m_RemoteInformation.s_Sha1Hash);
+
+    if(n_Operation == UpdateCheckOperation) {
+        QJsonObject updateInfo {
+            { "AbsolutePath", m_LocalInformation.s_AppImagePath },
+            { "Sha1Hash", m_LocalInformation.s_Sha1Hash },
+            { "RemoteSha1Hash", m_RemoteInformation.s_Sha1Hash },
+            { "ReleaseNotes", m_RemoteInformation.s_ReleaseNotes }
+        };
+        resetState();
+        emit updateAvailable(isUpdateAvailable, updateInfo);
         return;
     }
 
-    auto embededUpdateInformation = information["EmbededUpdateInformation"].toObject();
-    auto remoteTargetFileSHA1Hash = information["RemoteTargetFileSHA1Hash"].toString();
-    auto releaseNotes = information["ReleaseNotes"].toString();
-    QString localAppImageSHA1Hash = embededUpdateInformation["FileInformation"].toObject()["AppImageSHA1Hash"].toString(),
-            localAppImagePath = embededUpdateInformation["FileInformation"].toObject()["AppImageFilePath"].toString();
+    /* The writer only uses the match cache of this exact AppImage. */
+    getMethod(p_DeltaWriter.data(), "setSourceFileSHA1(const QString&)").invoke(p_DeltaWriter.data(),
+            Qt::QueuedConnection, Q_ARG(QString, m_LocalInformation.s_Sha1Hash));
+
+    if(n_Operation == PlanOperation) {
+        if(!isUpdateAvailable) {
+            QJsonObject deltaPlan {
+                { "UpdateAvailable", false },
+                { "AbsolutePath", m_LocalInformation.s_AppImagePath },
+                { "BytesToDownload", 0 },
+                { "RequestCount", 0 },
+                { "RequiredRanges", QJsonArray() },
+                { "SeedFiles", QJsonArray() }
+            };
+            resetState();
+            emit updatePlan(deltaPlan);
+            return;
+        }
+        /* Stays busy until the writer has finished its dry run. */
+        getMethod(p_DeltaWriter.data(), "setDryRun(bool)").invoke(p_DeltaWriter.data(),
+                Qt::QueuedConnection, Q_ARG(bool, true));
+        emit requestZsyncInformation();
+        return;
+    }
 
-    QJsonObject updateInfo {
-	    { "AbsolutePath" , localAppImagePath },
-	    { "Sha1Hash" , localAppImageSHA1Hash },
-	    { "RemoteSha1Hash" , remoteTargetFileSHA1Hash },
-	    { "ReleaseNotes" , releaseNotes }
+    if(isUpdateAvailable) {
+        getMethod(p_DeltaWriter.data(), "setDryRun(bool)").invoke(p_DeltaWriter.data(),
+                Qt::QueuedConnection, Q_ARG(bool, false));
+        /*
+         * From here on the writer and the downloader take over , they can be
+         * canceled and restarted just like before , So we are not busy anymore.
+        */
+        b_Busy = false;
+        emit requestZsyncInformation();
+        return;
+    }
+
+    /* Current Version is the new version. */
+    QJsonObject newVersionDetails {
+        { "AbsolutePath", m_LocalInformation.s_AppImagePath },
+        { "Sha1Hash", m_LocalInformation.s_Sha1Hash }
     };
-    emit updateAvailable((localAppImageSHA1Hash != remoteTargetFileSHA1Hash), updateInfo);
+    QString oldVersionPath = m_LocalInformation.s_AppImagePath;
+    emit started(); /* Some may depend on this signal. */
+    emit finished(newVersionDetails, oldVersionPath);
+    return;
+}
+
+void AppImageDeltaRevisionerPrivate::handlePlan(QJsonObject deltaPlan)
+{
+    if(n_Operation != PlanOperation) {
+        return;
+    }
+    deltaPlan.insert("UpdateAvailable", true);
+    deltaPlan.insert("AbsolutePath", m_LocalInformation.s_AppImagePath);
+    resetState();
+    emit updatePlan(deltaPlan);
     return;
 }
 
-void AppImageDeltaRevisionerPrivate::resetConnections(){
+/*
+ * The writer is only started if the operation was not canceled while it was
+ * configured , It would not be stopped by anyone otherwise.
+*/
+void AppImageDeltaRevisionerPrivate::handleWriterConfigured(void)
+{
+    if(n_Operation != UpdateOperation && n_Operation != PlanOperation) {
+        return;
+    }
+    b_WriterStarted = true;
+    getMethod(p_DeltaWriter.data(), "start(void)").invoke(p_DeltaWriter.data(), Qt::QueuedConnection);
+    return;
+}
+
+void AppImageDeltaRevisionerPrivate::resetState(void)
+{
+    p_Progress->stop();
+    if(n_Operation != NoOperation) {
+        TracerPrivate::asyncEnd("Operation", this);
+        if(!s_TraceFile.isEmpty()) {
+            TracerPrivate::save(s_TraceFile); /* Tracing never fails a update. */
+        }
+    }
     b_Busy = false;
-    
-    disconnect(p_UpdateInformation.data(), SIGNAL(info(QJsonObject)),
-               p_ControlFileParser.data(), SLOT(setControlFileUrl(QJsonObject)));
-    disconnect(p_ControlFileParser.data(), SIGNAL(receiveControlFile(void)),
-               p_ControlFileParser.data(), SLOT(getUpdateCheckInformation(void)));
-    disconnect(p_ControlFileParser.data(), SIGNAL(updateCheckInformation(QJsonObject)),
-               this, SLOT(handleUpdateCheckInformation(QJsonObject)));
-    disconnect(p_ControlFileParser.data(), SIGNAL(updateCheckInformation(QJsonObject)),  
-		    this, SLOT(doStart(QJsonObject)));
-    connect(p_UpdateInformation.data(), &AppImageUpdateInformationPrivate::info,
-            this, &AppImageDeltaRevisionerPrivate::embededInformation, 
-	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
-    connect(p_UpdateInformation.data(), &AppImageUpdateInformationPrivate::progress,
-            this, &AppImageDeltaRevisionerPrivate::handleIndeterminateProgress ,
-	    Qt::UniqueConnection);
-    connect(p_ControlFileParser.data(), &ZsyncRemoteControlFileParserPrivate::progress,
-            this, &AppImageDeltaRevisionerPrivate::handleIndeterminateProgress,
-	    Qt::UniqueConnection);
-    connect(p_DeltaWriter.data(), &ZsyncWriterPrivate::progress,
-            this, &AppImageDeltaRevisionerPrivate::progress, 
-	    (Qt::ConnectionType)(Qt::DirectConnection | Qt::UniqueConnection));
+    b_WriterStarted = false;
+    n_Operation = NoOperation;
+    m_LocalInformation = LocalInformation();
+    m_RemoteInformation = RemoteInformation();
     return;
 }
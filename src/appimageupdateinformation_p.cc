@@ -34,34 +34,40 @@
  * from AppImages is implemented.
 */
 #include <QBuffer>
+#include <QMutex>
 #include <QProcessEnvironment>
+#include <QRunnable>
+#include <cstring>
+#include <limits>
+#include <unistd.h>
 
 #include "../include/appimageupdateinformation_p.hpp"
+#include "../include/sha1hasher_p.hpp"
+#include "../include/tracer_p.hpp"
+#include "../include/logging_p.hpp"
 
 /*
  * An efficient logging system.
  * Warning: Hard coded to work only with this class.
 */
 #ifndef LOGGING_DISABLED
-#define LOGS *(p_Logger.data()) <<
+#define LOGS(type) { if(isLogEnabled(type)) { *(p_Logger.data()) <<
 #define LOGR <<
-#define LOGE ; \
-	     emit(logger(s_LogBuffer , s_AppImagePath)); \
-	     s_LogBuffer.clear();
+#define LOGE(type) ; flushLog(type); } }
 #else
-#define LOGS (void)
+#define LOGS(type) { if(false) { (void)
 #define LOGR ;(void)
-#define LOGE ;
+#define LOGE(type) ; } }
 #endif // LOGGING_DISABLED
 
-#define INFO_START LOGS "   INFO: " LOGR
-#define INFO_END LOGE
+#define INFO_START LOGS(QtInfoMsg) "   INFO: " LOGR
+#define INFO_END LOGE(QtInfoMsg)
 
-#define WARNING_START LOGS "WARNING: " LOGR
-#define WARNING_END LOGE
+#define WARNING_START LOGS(QtWarningMsg) "WARNING: " LOGR
+#define WARNING_END LOGE(QtWarningMsg)
 
-#define FATAL_START LOGS "  FATAL: " LOGR
-#define FATAL_END LOGE
+#define FATAL_START LOGS(QtCriticalMsg) "  FATAL: " LOGR
+#define FATAL_END LOGE(QtCriticalMsg)
 
 
 /*
@@ -79,44 +85,7 @@
 #define APPIMAGE_PERMISSION_ERROR() emit(error(NoReadPermission));
 #define APPIMAGE_NOT_FOUND_ERROR() emit(error(AppimageNotFound));
 #define APPIMAGE_READ_ERROR() emit(error(AppimageNotReadable));
-#define APPIMAGE_INVALID_UI_ERROR() emit(error(InvalidUpdateInformation));
-#define APPIMAGE_EMPTY_UI_ERROR() emit(error(EmptyUpdateInformation));
 #define MAGIC_BYTES_ERROR() emit(error(InvalidMagicBytes));
-#define ELF_FORMAT_ERROR() emit(error(UnsupportedElfFormat));
-#define SECTION_HEADER_NOT_FOUND_ERROR() emit(error(SectionHeaderNotFound));
-#define APPIMAGE_TYPE_ERROR() emit(error(InvalidAppimageType));
-#define UNSUPPORTED_TRANSPORT_ERROR() emit(error(UnsupportedTransport));
-
-
-/*
- * Sets the offset and length of the need section header
- * from a elf file.
- *
- * Example:
- *      long unsigned offset = 0 , length = 0;
- *      ElfXX_Ehdr *elfXX = (ElfXX_Ehdr *) data;
- *      ElfXX_Shdr *shdrXX = (ElfXX_Shdr *) (data + elfXX->e_shoff);
- *      strTab = (char *)(data + shdrXX[elfXX->e_shstrndx].sh_offset);
- *      lookupSectionHeaders(strTab , shdr , elf , ".section_header_name" , offset , length , progress);
- *
- * Note:
- * 	progress must be a Qt signal which takes int as a parameter.
- */
-#define lookupSectionHeaders(strTab , shdr , elf , section , offset , length , progsig) \
-						{ \
-						for(int i = 0; i < elf->e_shnum; i++) { \
-						  emit(progsig((int)((i * 100)/elf->e_shnum))); \
-						  QCoreApplication::processEvents(); \
-						  if(!strcmp(&strTab[shdr[i].sh_name] , section)){ \
-							  offset = shdr[i].sh_offset; \
-							  length = shdr[i].sh_size; \
-							  emit(progsig(80)); \
-							  break;\
-						  } \
-						 }\
-					        }
-
-
 
 
 using namespace AppImageUpdaterBridge;
@@ -128,6 +97,7 @@ using namespace AppImageUpdaterBridge;
 static constexpr auto AppimageType1UpdateInfoPos = 0x8373;
 static constexpr auto AppimageType1UpdateInfoLen = 0x200;
 static constexpr auto AppimageType2UpdateInfoShdr = (char*)".upd_info";
+static constexpr auto AppimageType2UpdateInfoMaxLen = 0x10000; /* 64 KiB , appimagetool reserves 1 KiB. */
 static constexpr char AppimageUpdateInfoDelimiter = 0x7c;
 static constexpr auto ElfMagicPos = 0x1;
 static constexpr auto IsoMagicPos = 0x8001;
@@ -255,6 +225,94 @@ private:
     bool *p_Bool = nullptr;
 };
 
+/*
+ * The object a hash runnable reports to , cleared when the object is
+ * destroyed since the runnable may still run in a shared pool then.
+*/
+namespace AppImageUpdaterBridge
+{
+class AppImageSHA1HashReceiverPrivate
+{
+public:
+    QMutex m_Mutex;
+    QObject *p_Receiver = nullptr;
+};
+}
+
+/*
+ * Calculates the SHA1 hash of the AppImage in a worker thread with its own
+ * file handle , The result is posted back to the given receiver's
+ * handleAppImageSHA1Hash(QString) slot , An empty hash means the AppImage
+ * could not be read.
+*/
+class AppImageSHA1HashRunnable : public QRunnable
+{
+public:
+    AppImageSHA1HashRunnable(const QSharedPointer<AppImageSHA1HashReceiverPrivate> &receiver,
+                             const QString &AppImagePath)
+        : p_Receiver(receiver),
+          s_AppImagePath(AppImagePath)
+    {
+        return;
+    }
+
+    void run() override
+    {
+        TraceScope traceScope("AppImageSHA1Hash", QJsonObject { { "AbsolutePath", s_AppImagePath } });
+        QString hash;
+        QFile AppImage(s_AppImagePath);
+        if(AppImage.open(QIODevice::ReadOnly)) {
+            Sha1HasherPrivate SHA1Hasher;
+            if(SHA1Hasher.addData(&AppImage)) {
+                hash = QString(SHA1Hasher.result().toHex().toUpper());
+            }
+        }
+        QMutexLocker locker(&p_Receiver->m_Mutex);
+        if(p_Receiver->p_Receiver) {
+            QMetaObject::invokeMethod(p_Receiver->p_Receiver, "handleAppImageSHA1Hash",
+                                      Qt::QueuedConnection, Q_ARG(QString, hash));
+        }
+        return;
+    }
+private:
+    QSharedPointer<AppImageSHA1HashReceiverPrivate> p_Receiver;
+    QString s_AppImagePath;
+};
+
+
+/*
+ * Reads exactly size bytes at the given offset from the given QFile into the
+ * given buffer without changing the position of the QFile.
+ * When the QFile has a native handle this is a single positional read(pread),
+ * else we fallback to seek and read.
+ * Returns true if all the bytes were read.
+*/
+static bool readAt(QFile *IO, qint64 offset, void *buffer, qint64 size)
+{
+    if(offset < 0 || size < 0) {
+        return false;
+    }
+
+    int fd = IO->handle();
+    if(fd >= 0 && (sizeof(off_t) >= sizeof(qint64) || offset + size <= 0x7fffffff)) {
+        char *p = (char*)buffer;
+        while(size > 0) {
+            ssize_t n = ::pread(fd, p, (size_t)size, (off_t)offset);
+            if(n <= 0) {
+                return false;
+            }
+            p += n;
+            offset += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    qint64 before = IO->pos();
+    bool ok = IO->seek(offset) && IO->read((char*)buffer, size) == size;
+    IO->seek(before);
+    return ok;
+}
 
 /*
  * Returns a new QByteArray which contains the contents from the given QFile from the given offset to the given
@@ -268,13 +326,104 @@ private:
 static QByteArray read(QFile *IO, qint64 offset, qint64 max)
 {
     QByteArray ret;
-    qint64 before = IO->pos();
-    IO->seek(offset);
-    ret = IO->read(max);
-    IO->seek(before);
+    qint64 size = IO->size();
+    if(offset < 0 || max <= 0 || offset >= size) {
+        return ret;
+    }
+    ret.resize((int)qMin(max, size - offset));
+    if(!readAt(IO, offset, ret.data(), ret.size())) {
+        ret.clear();
+    }
     return ret;
 }
 
+/*
+ * Finds the offset and length of the given section in a elf file without
+ * mapping the file. Only the elf header , the section header table and the
+ * section header string table are read , each with a single positional read.
+ * Every offset and size taken from the file is validated against the file size
+ * before it is used.
+ *
+ * Returns NoError and sets offset and length on success , else returns
+ * UnsupportedElfFormat for a malformed elf file or SectionHeaderNotFound.
+ *
+ * Example:
+ *      qint64 offset = 0 , length = 0;
+ *      short errorCode = lookupSectionHeader<Elf64_Ehdr, Elf64_Shdr>(&file, ".upd_info", &offset, &length);
+*/
+template <typename Ehdr, typename Shdr>
+static short lookupSectionHeader(QFile *IO, const char *section, qint64 *offset, qint64 *length)
+{
+    static constexpr quint64 MaxStringTableSize = 1048576; /* 1 MiB , A sane string table is far smaller. */
+    const quint64 fileSize = (quint64)IO->size();
+    Ehdr elf;
+    if(!readAt(IO, 0, &elf, sizeof(elf))) {
+        return UnsupportedElfFormat;
+    }
+
+    const quint64 shoff = elf.e_shoff,
+                  shnum = elf.e_shnum,
+                  shentsize = elf.e_shentsize;
+    /*
+     * Section headers of other sizes are not used by any real elf file , rejecting
+     * them also keeps the table far below the limit of a QByteArray.
+    */
+    if(!shoff || !shnum || shentsize != sizeof(Shdr) || elf.e_shstrndx >= shnum ||
+            shoff > fileSize || shnum * shentsize > fileSize - shoff ||
+            shnum * shentsize > (quint64)std::numeric_limits<int>::max()) {
+        return UnsupportedElfFormat;
+    }
+
+    /* Read the entire section header table at once. */
+    QByteArray table;
+    table.resize((int)(shnum * shentsize));
+    if(!readAt(IO, (qint64)shoff, table.data(), table.size())) {
+        return UnsupportedElfFormat;
+    }
+
+    auto sectionAt = [&](quint64 index) -> Shdr {
+        Shdr shdr;
+        memcpy(&shdr, table.constData() + index * shentsize, sizeof(shdr));
+        return shdr;
+    };
+
+    /* Read the section header string table. */
+    Shdr strTabHeader = sectionAt(elf.e_shstrndx);
+    const quint64 strTabOffset = strTabHeader.sh_offset,
+                  strTabSize = strTabHeader.sh_size;
+    if(!strTabSize || strTabSize > MaxStringTableSize ||
+            strTabOffset > fileSize || strTabSize > fileSize - strTabOffset) {
+        return UnsupportedElfFormat;
+    }
+
+    QByteArray strTab;
+    strTab.resize((int)strTabSize);
+    if(!readAt(IO, (qint64)strTabOffset, strTab.data(), strTab.size())) {
+        return UnsupportedElfFormat;
+    }
+
+    /* The name we compare with includes the terminating null character. */
+    const quint64 sectionNameSize = strlen(section) + 1;
+    for(quint64 i = 0; i < shnum; ++i) {
+        Shdr shdr = sectionAt(i);
+        const quint64 name = shdr.sh_name;
+        if(name >= strTabSize || strTabSize - name < sectionNameSize ||
+                memcmp(strTab.constData() + name, section, sectionNameSize)) {
+            continue;
+        }
+
+        const quint64 sectionOffset = shdr.sh_offset,
+                      sectionSize = shdr.sh_size;
+        if(sectionOffset > fileSize || sectionSize > fileSize - sectionOffset) {
+            return UnsupportedElfFormat;
+        }
+        *offset = (qint64)sectionOffset;
+        *length = (qint64)sectionSize;
+        return NoError;
+    }
+    return SectionHeaderNotFound;
+}
+
 static QByteArray readLine(QFile *IO)
 {
     QByteArray ret;
@@ -306,6 +455,126 @@ static QByteArray getExecPathFromDesktopFile(QFile *file)
 }
 
 
+/*
+ * Reads the raw update information string embeded in the given AppImage , This
+ * only uses positional reads and does not depend on any object state , So it can
+ * be called from any thread as long as the QFile is not shared.
+ * Returns NoError on success or the error code describing the failure.
+ *
+ * Example:
+ * 	QString updateString;
+ * 	short errorCode = AppImageUpdateInformationPrivate::readUpdateString(&file, &updateString);
+*/
+short AppImageUpdateInformationPrivate::readUpdateString(QFile *AppImage, QString *updateString)
+{
+    if(!AppImage || !updateString) {
+        return AppimageNotReadable;
+    }
+    updateString->clear();
+
+    auto magicBytes = read(AppImage, /*offset=*/8,/*maxchars=*/ 3);
+    if(magicBytes.size() < 3 || (magicBytes[0] != 'A' && magicBytes[1] != 'I')) {
+        return InvalidMagicBytes;
+    }
+
+    /*
+     * 0x1H -> Type 1 AppImage.
+     * 0x2H -> Type 2 AppImage. (Latest Version)
+    */
+    int type = (int)magicBytes[2];
+    if(type == 0x2) {
+        qint64 offset = 0, length = 0;
+        short errorCode = NoError;
+        unsigned char ident[EI_NIDENT];
+
+        if(!readAt(AppImage, 0, &ident, sizeof(ident))) {
+            return UnsupportedElfFormat;
+        }
+
+        if(ident[EI_CLASS] == ELFCLASS32) {
+            errorCode = lookupSectionHeader<Elf32_Ehdr, Elf32_Shdr>(AppImage, AppimageType2UpdateInfoShdr,
+                        &offset, &length);
+        } else if(ident[EI_CLASS] == ELFCLASS64) {
+            errorCode = lookupSectionHeader<Elf64_Ehdr, Elf64_Shdr>(AppImage, AppimageType2UpdateInfoShdr,
+                        &offset, &length);
+        } else {
+            errorCode = UnsupportedElfFormat;
+        }
+
+        if(errorCode == UnsupportedElfFormat) {
+            return UnsupportedElfFormat;
+        }
+        if(errorCode != NoError || offset == 0 || length == 0) {
+            return SectionHeaderNotFound;
+        }
+        /* The update information is zero padded , anything beyond the limit is garbage. */
+        *updateString = QString::fromUtf8(read(AppImage, offset, qMin(length, (qint64)AppimageType2UpdateInfoMaxLen)));
+    } else if(type == 0x1 ||
+              ((read(AppImage, ElfMagicPos, ElfMagicValueSize) == ElfMagicValue) &&
+               (read(AppImage, IsoMagicPos, IsoMagicValueSize) == IsoMagicValue))) {
+        /* Unknown types which look like an ISO 9660 image are guessed to be type 1. */
+        *updateString = QString::fromUtf8(read(AppImage, AppimageType1UpdateInfoPos, AppimageType1UpdateInfoLen));
+    } else {
+        return InvalidAppimageType;
+    }
+    return updateString->isEmpty() ? EmptyUpdateInformation : NoError;
+}
+
+/*
+ * Parses the raw update information string into the 'UpdateInformation' json object
+ * used throughout the library.
+ * Returns NoError on success or the error code describing the failure.
+*/
+short AppImageUpdateInformationPrivate::parseUpdateString(const QString &updateString, QJsonObject *updateInformation)
+{
+    if(!updateInformation) {
+        return InvalidUpdateInformation;
+    }
+    *updateInformation = QJsonObject();
+    if(updateString.isEmpty()) {
+        return EmptyUpdateInformation;
+    }
+
+    /*
+     * Split the raw update information with the specified
+     * delimiter.
+    */
+    auto data = updateString.split(AppimageUpdateInfoDelimiter);
+
+    if(data.size() == 2) {
+        QJsonObject buffer {
+            { "transport", data.at(0) },
+            { "zsyncUrl", data.at(1) }
+        };
+        *updateInformation = buffer;
+    } else if(data.size() == 5) {
+        if(data.at(0) == "gh-releases-zsync") {
+            QJsonObject buffer {
+                {"transport", data.at(0) },
+                {"username", data.at(1) },
+                {"repo", data.at(2) },
+                {"tag", data.at(3) },
+                {"filename", data.at(4) }
+            };
+            *updateInformation = buffer;
+        } else if(data.at(0) == "bintray-zsync") {
+            QJsonObject buffer {
+                {"transport", data.at(0) },
+                {"username", data.at(1) },
+                {"repo", data.at(2) },
+                {"packageName", data.at(3) },
+                {"filename", data.at(4) }
+            };
+            *updateInformation = buffer;
+        } else {
+            return UnsupportedTransport;
+        }
+    } else {
+        return InvalidUpdateInformation;
+    }
+    return NoError;
+}
+
 /*
  * AppImageUpdateInformationPrivate is the worker class that provides the ability to easily get the update
  * information from an AppImage. This class can be constructed in two ways. The default construct sets the
@@ -328,6 +597,9 @@ AppImageUpdateInformationPrivate::AppImageUpdateInformationPrivate(QObject *pare
         throw;
     }
 #endif // LOGGING_DISABLED
+    p_HashPool = QThreadPool::globalInstance();
+    p_HashReceiver.reset(new AppImageSHA1HashReceiverPrivate);
+    p_HashReceiver->p_Receiver = this;
     emit statusChanged(Idle);
     return;
 }
@@ -338,6 +610,18 @@ AppImageUpdateInformationPrivate::AppImageUpdateInformationPrivate(QObject *pare
 */
 AppImageUpdateInformationPrivate::~AppImageUpdateInformationPrivate()
 {
+    QMutexLocker locker(&p_HashReceiver->m_Mutex);
+    p_HashReceiver->p_Receiver = nullptr; /* The hash result is discarded with this object. */
+    return;
+}
+
+/*
+ * The AppImage is hashed in the given pool , Which is shared and bounded by
+ * whoever runs many updates at once. The global thread pool is used by default.
+*/
+void AppImageUpdateInformationPrivate::setHashPool(QThreadPool *pool)
+{
+    p_HashPool = pool ? pool : QThreadPool::globalInstance();
     return;
 }
 
@@ -366,7 +650,7 @@ void AppImageUpdateInformationPrivate::setLoggerName(const QString &name)
  */
 void AppImageUpdateInformationPrivate::setAppImage(const QString &AppImagePath)
 {
-    if(b_Busy) {
+    if(b_Busy || b_Hashing) {
         return;
     }
     clear(); /* clear old data */
@@ -395,7 +679,7 @@ void AppImageUpdateInformationPrivate::setAppImage(const QString &AppImagePath)
 */
 void AppImageUpdateInformationPrivate::setAppImage(QFile *AppImage)
 {
-    if(b_Busy) {
+    if(b_Busy || b_Hashing) {
         return;
     }
     clear(); /* clear old data. */
@@ -426,6 +710,7 @@ void AppImageUpdateInformationPrivate::setShowLog(bool logNeeded)
         return;
     }
 #ifndef LOGGING_DISABLED
+    b_ShowLog = logNeeded;
     if(logNeeded) {
         connect(this, &AppImageUpdateInformationPrivate::logger,
                 this, &AppImageUpdateInformationPrivate::handleLogMessage,
@@ -439,10 +724,53 @@ void AppImageUpdateInformationPrivate::setShowLog(bool logNeeded)
 #endif // LOGGING_DISABLED
 }
 
+/*
+ * Tells if anyone is connected to the logger signal , only then the log
+ * messages are formatted and emitted.
+*/
+void AppImageUpdateInformationPrivate::setLoggerConnected(bool connected)
+{
+#ifndef LOGGING_DISABLED
+    b_LoggerConnected = connected;
+#else
+    (void)connected;
+#endif
+    return;
+}
+
+#ifndef LOGGING_DISABLED
+/*
+ * Returns true if a log message of the given type would be seen by anyone ,
+ * the message is not even formatted otherwise.
+*/
+bool AppImageUpdateInformationPrivate::isLogEnabled(QtMsgType type) const
+{
+    if(!b_ShowLog && !b_LoggerConnected && !LogRingBufferPrivate::isEnabled()) {
+        return false;
+    }
+    return lcUpdateInformation().isEnabled(type);
+}
+
+/* Hands the formatted message to the ring buffer and the logger signal. */
+void AppImageUpdateInformationPrivate::flushLog(QtMsgType type)
+{
+    LogRingBufferPrivate::append(type, s_LoggerName, s_LogBuffer);
+    if(b_ShowLog || b_LoggerConnected) {
+        emit(logger(s_LogBuffer, s_AppImagePath));
+    }
+    s_LogBuffer.clear();
+    return;
+}
+#endif // LOGGING_DISABLED
+
 
 void AppImageUpdateInformationPrivate::getInfo(void)
 {
-    if(b_Busy) {
+    /*
+     * If we are still hashing the AppImage then the info signal will be emitted
+     * once its done.
+    */
+    if(b_Busy || b_Hashing) {
         return;
     }
     AutoBoolCounter bc(&b_Busy);
@@ -453,6 +781,7 @@ void AppImageUpdateInformationPrivate::getInfo(void)
     * that the user called getInfo() twice or more.
     */
     if(!m_Info.isEmpty()) {
+        emit(partialInfo(m_PartialInfo));
         emit(info(m_Info));
         return;
     }
@@ -586,9 +915,7 @@ void AppImageUpdateInformationPrivate::getInfo(void)
     }
 
 
-    QString AppImageSHA1;
     QString updateString;
-    QStringList data;
 
     /*
      * Read the magic byte , i.e the AI stamp on the given binary. The characters 'AI'
@@ -598,6 +925,7 @@ void AppImageUpdateInformationPrivate::getInfo(void)
     emit statusChanged(ReadingAppimageMagicBytes);
     QCoreApplication::processEvents();
 
+    QScopedPointer<TraceScope> traceScope(new TraceScope("ReadElf", QJsonObject { { "AbsolutePath", s_AppImagePath } }));
     auto magicBytes = read(p_AppImage, /*offset=*/8,/*maxchars=*/ 3);
     if (magicBytes[0] != 'A' && magicBytes[1] != 'I') {
         /*
@@ -628,222 +956,116 @@ void AppImageUpdateInformationPrivate::getInfo(void)
 
 
 
-    /*
-     * Calculate the AppImages SHA1 Hash which will be used later to find if we need to update the
-     * AppImage.
-    */
-    emit statusChanged(CalculatingAppimageSha1Hash);
+    emit statusChanged(FindingAppimageType);
     QCoreApplication::processEvents();
 
     {
-        qint64 bufferSize = 0;
-        if(p_AppImage->size() >= 1073741824) { // 1 GiB and more.
-            bufferSize = 104857600; // copy per 100 MiB.
-        } else if(p_AppImage->size() >= 1048576 ) { // 1 MiB and more.
-            bufferSize = 1048576; // copy per 1 MiB.
-        } else if(p_AppImage->size() >= 1024) { // 1 KiB and more.
-            bufferSize = 4096; // copy per 4 KiB.
-        } else { // less than 1 KiB
-            bufferSize = 1024; // copy per 1 KiB.
-        }
-
-        QCryptographicHash *SHA1Hasher = new QCryptographicHash(QCryptographicHash::Sha1);
-        while(!p_AppImage->atEnd()) {
-            SHA1Hasher->addData(p_AppImage->read(bufferSize));
-            QCoreApplication::processEvents();
+        short errorCode = readUpdateString(p_AppImage, &updateString);
+        if(errorCode != NoError) {
+            emit statusChanged(Idle);
+            FATAL_START  " getInfo : cannot read update information(" LOGR errorCodeToString(errorCode) LOGR ")." FATAL_END;
+            emit(error(errorCode));
+            return;
         }
-        p_AppImage->seek(0); // rewind file to the top for later use.
-        AppImageSHA1 = QString(SHA1Hasher->result().toHex().toUpper());
-        delete SHA1Hasher;
     }
+    traceScope.reset();
 
-    emit statusChanged(FindingAppimageType);
+    emit(progress(80)); /*Signal progress.*/
+    emit statusChanged(Idle);
     QCoreApplication::processEvents();
 
-    /*
-     * 0x1H -> Type 1 AppImage.
-     * 0x2H -> Type 2 AppImage. (Latest Version)
-    */
-    int type = (int)magicBytes[2];
-    if(type == 0x1) {
-        INFO_START  " getInfo : AppImage is confirmed to be type 1." INFO_END;
-        progress(/*percentage=*/80); /*Signal progress.*/
-        emit statusChanged(ReadingAppimageUpdateInformation);
-        QCoreApplication::processEvents();
-
-        updateString = QString::fromUtf8(read(p_AppImage, AppimageType1UpdateInfoPos, AppimageType1UpdateInfoLen));
-    } else if(type == 0x2) {
-
-        INFO_START  " getInfo : AppImage is confirmed to be type 2." INFO_END;
-        INFO_START  " getInfo : mapping AppImage to memory." INFO_END;
-
-        {
-            uint8_t *data = NULL;
-            char *strTab = NULL;
-            unsigned long offset = 0, length = 0;
-
-            emit statusChanged(MappingAppimageToMemory);
-            uchar *mapped = p_AppImage->map(/*offset=*/0, /*max=*/p_AppImage->size());
-
-            if(mapped == NULL) {
-                emit statusChanged(Idle);
-                FATAL_START  " getInfo : not enough memory to map AppImage to memory." FATAL_END;
-                MEMORY_ERROR();
-                return;
-            }
-
-            emit statusChanged(FindingAppimageArchitecture);
-            QCoreApplication::processEvents();
-            data = (uint8_t*) mapped;
-
-            if((((Elf32_Ehdr*)data)->e_ident[EI_CLASS] == ELFCLASS32)) {
-                INFO_START  " getInfo : AppImage architecture is x86 (32 bits)." INFO_END;
-
-                Elf32_Ehdr *elf32 = (Elf32_Ehdr *) data;
-                Elf32_Shdr *shdr32 = (Elf32_Shdr *) (data + elf32->e_shoff);
-
-                strTab = (char *)(data + shdr32[elf32->e_shstrndx].sh_offset);
-                emit statusChanged(SearchingForUpdateInformationSectionHeader);
-
-                lookupSectionHeaders(strTab, shdr32, elf32, AppimageType2UpdateInfoShdr,
-                                     /*variable to set offset=*/offset, /*length of the header=*/length,
-                                     /*Progress signal to use=*/progress);
-            } else if((((Elf64_Ehdr*)data)->e_ident[EI_CLASS] == ELFCLASS64)) {
-                INFO_START  " getInfo : AppImage architecture is x86_64 (64 bits)." INFO_END;
-
-                Elf64_Ehdr *elf64 = (Elf64_Ehdr *) data;
-                Elf64_Shdr *shdr64 = (Elf64_Shdr *) (data + elf64->e_shoff);
-
-                strTab = (char *)(data + shdr64[elf64->e_shstrndx].sh_offset);
-                emit statusChanged(SearchingForUpdateInformationSectionHeader);
-                lookupSectionHeaders(strTab, shdr64, elf64, AppimageType2UpdateInfoShdr,
-                                     offset, length, progress);
-            } else {
-                emit statusChanged(UnmappingAppimageFromMemory);
-                p_AppImage->unmap(mapped);
-                emit statusChanged(Idle);
-                FATAL_START  " getInfo : Unsupported elf format." FATAL_END;
-                ELF_FORMAT_ERROR();
-                return;
-            }
+    INFO_START " getInfo : updateString(" LOGR updateString LOGR ")." INFO_END;
 
-            emit statusChanged(UnmappingAppimageFromMemory);
-            p_AppImage->unmap(mapped);
-
-            if(offset == 0 || length == 0) {
-                emit statusChanged(Idle);
-                FATAL_START  " getInfo : cannot find '"
-                LOGR AppimageType2UpdateInfoShdr LOGR "' section header." FATAL_END;
-                SECTION_HEADER_NOT_FOUND_ERROR();
-            } else {
-                emit statusChanged(ReadingAppimageUpdateInformation);
-                updateString = QString::fromUtf8(read(p_AppImage, offset, length));
-            }
+    emit statusChanged(FinalizingAppimageEmbededUpdateInformation);
 
+    QJsonObject updateInformation;
+    {
+        short errorCode = parseUpdateString(updateString, &updateInformation);
+        if(errorCode != NoError) {
             emit statusChanged(Idle);
-        }
-    } else {
-        WARNING_START  " getInfo : unable to confirm AppImage type." WARNING_END;
-        if(
-            (read(p_AppImage, ElfMagicPos, ElfMagicValueSize) == ElfMagicValue) &&
-            (read(p_AppImage, IsoMagicPos, IsoMagicValueSize) == IsoMagicValue)
-        ) {
-            WARNING_START  " getInfo : guessing AppImage type to be 1." WARNING_END;
-            emit(progress(80));
-            emit statusChanged(ReadingAppimageUpdateInformation);
-            updateString = QString::fromUtf8(read(p_AppImage, AppimageType1UpdateInfoPos, AppimageType1UpdateInfoLen));
-        } else {
-            emit statusChanged(Idle);
-            FATAL_START  " getInfo : invalid AppImage type(" LOGR type LOGR ")." FATAL_END;
-            APPIMAGE_TYPE_ERROR();
+            FATAL_START  " getInfo : invalid update information(" LOGR errorCodeToString(errorCode) LOGR ")." FATAL_END;
+            emit(error(errorCode));
             return;
         }
     }
 
-    emit statusChanged(Idle);
-    QCoreApplication::processEvents();
-
-    if(updateString.isEmpty()) {
-        FATAL_START  " getInfo : update information is empty." FATAL_END;
-        APPIMAGE_EMPTY_UI_ERROR();
-        return;
-    }
-
-    INFO_START " getInfo : updateString(" LOGR updateString LOGR ")." INFO_END;
-
     /*
-     * Split the raw update information with the specified
-     * delimiter.
+     * This will be sent along the update information , The SHA1 hash of the AppImage
+     * is added once its calculated.
     */
-    data = updateString.split(AppimageUpdateInfoDelimiter);
-
-    // This will be sent along the update information.
     QJsonObject fileInformation {
-        { "AppImageFilePath", s_AppImagePath },
-        { "AppImageSHA1Hash", AppImageSHA1 }
+        { "AppImageFilePath", s_AppImagePath }
     };
 
-    QJsonObject updateInformation; // will be filled up later on.
+    {
+        QJsonObject buffer {
+            { "IsEmpty", updateInformation.isEmpty() },
+            { "FileInformation", fileInformation },
+            { "UpdateInformation", updateInformation }
+        };
+        m_PartialInfo = buffer;
+    }
 
-    emit statusChanged(FinalizingAppimageEmbededUpdateInformation);
+    /*
+     * The update information is all that is needed to retrive the remote control
+     * file , So emit it right away and calculate the AppImage's SHA1 hash in a
+     * worker thread meanwhile , The complete information is emitted with the info
+     * signal when the hash is calculated.
+    */
+    emit(partialInfo(m_PartialInfo));
 
-    if(data.size() < 2) {
-        emit statusChanged(Idle);
-        FATAL_START  " getInfo : update information has invalid delimiters." FATAL_END;
-        APPIMAGE_INVALID_UI_ERROR();
+    INFO_START  " getInfo : calculating AppImage sha1 hash." INFO_END;
+    emit statusChanged(CalculatingAppimageSha1Hash);
+    b_Hashing = true;
+
+    /*
+     * The worker thread opens the AppImage again by its path , A QFile given with
+     * setAppImage(QFile*) may have no path or its path may be unlinked , Such a
+     * device is hashed here through the given QFile itself.
+    */
+    if(!s_AppImagePath.isEmpty() && QFileInfo(s_AppImagePath).isFile()) {
+        p_HashPool->start(new AppImageSHA1HashRunnable(p_HashReceiver, s_AppImagePath));
         return;
-    } else if(data.size() == 2) {
-        {
-            QJsonObject buffer {
-                { "transport", data.at(0) },
-                { "zsyncUrl", data.at(1) }
-            };
-            updateInformation = buffer;
+    }
+
+    QString AppImageSHA1;
+    {
+        TraceScope traceScope("AppImageSHA1Hash", QJsonObject { { "AbsolutePath", s_AppImagePath } });
+        Sha1HasherPrivate SHA1Hasher;
+        bool hashed = p_AppImage->seek(0);
+        while(hashed && !p_AppImage->atEnd()) {
+            hashed = SHA1Hasher.addData(p_AppImage, 16777216); // hash per 16 MiB.
+            QCoreApplication::processEvents();
         }
-    } else if(data.size() == 5) {
-        if(data.at(0) == "gh-releases-zsync") {
-            {
-                QJsonObject buffer {
-                    {"transport", data.at(0) },
-                    {"username", data.at(1) },
-                    {"repo", data.at(2) },
-                    {"tag", data.at(3) },
-                    {"filename", data.at(4) }
-                };
-                updateInformation = buffer;
-            }
-        } else if(data.at(0) == "bintray-zsync") {
-            {
-                QJsonObject buffer {
-                    {"transport", data.at(0) },
-                    {"username", data.at(1) },
-                    {"repo", data.at(2) },
-                    {"packageName", data.at(3) },
-                    {"filename", data.at(4) }
-                };
-                updateInformation = buffer;
-            }
-        } else {
-            emit statusChanged(Idle);
-            FATAL_START  " getInfo : unsupported transport mechanism given." FATAL_END;
-            UNSUPPORTED_TRANSPORT_ERROR();
-            return;
+        p_AppImage->seek(0); // rewind file to the top for later use.
+        if(hashed) {
+            AppImageSHA1 = QString(SHA1Hasher.result().toHex().toUpper());
         }
+    }
+    QMetaObject::invokeMethod(this, "handleAppImageSHA1Hash", Qt::QueuedConnection, Q_ARG(QString, AppImageSHA1));
+    return;
+}
 
-    } else {
+/*
+ * This private slot receives the SHA1 hash of the AppImage calculated in the
+ * worker thread and completes the update information.
+*/
+void AppImageUpdateInformationPrivate::handleAppImageSHA1Hash(QString AppImageSHA1)
+{
+    b_Hashing = false;
+    if(AppImageSHA1.isEmpty()) {
+        m_PartialInfo = QJsonObject();
         emit statusChanged(Idle);
-        FATAL_START " getInfo : update information has invalid number of entries(" LOGR data.size() LOGR ")." FATAL_END;
-        APPIMAGE_INVALID_UI_ERROR();
+        FATAL_START  " handleAppImageSHA1Hash : cannot read AppImage to calculate its sha1 hash." FATAL_END;
+        APPIMAGE_READ_ERROR();
         return;
     }
 
     {
-        QJsonObject buffer {
-            { "IsEmpty", updateInformation.isEmpty() },
-            { "FileInformation", fileInformation },
-            { "UpdateInformation", updateInformation }
-        };
-        m_Info = buffer;
+        auto fileInformation = m_PartialInfo["FileInformation"].toObject();
+        fileInformation["AppImageSHA1Hash"] = AppImageSHA1;
+        m_Info = m_PartialInfo;
+        m_Info["FileInformation"] = fileInformation;
     }
 
     emit statusChanged(Idle);
@@ -862,10 +1084,11 @@ void AppImageUpdateInformationPrivate::getInfo(void)
 */
 void AppImageUpdateInformationPrivate::clear(void)
 {
-    if(b_Busy) {
+    if(b_Busy || b_Hashing) {
         return;
     }
     m_Info = QJsonObject(); /* TODO: if QJsonObject has a clear in future , use it instead. */
+    m_PartialInfo = QJsonObject();
 #ifndef LOGGING_DISABLED
     s_LogBuffer.clear();
 #endif
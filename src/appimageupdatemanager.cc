@@ -0,0 +1,158 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : appimageupdatemanager.cc
+ * @description : This is where the update manager is implemented.
+ * The update manager updates many AppImages at once on a fixed number
+ * of worker threads with one shared network stack , limiting the
+ * requests in flight and the seed scans across all updates.
+*/
+#include "../include/appimageupdatemanager_p.hpp"
+#include "../include/appimageupdatemanager.hpp"
+#include "../include/helpers_p.hpp"
+
+#include <QMetaMethod>
+
+using namespace AppImageUpdaterBridge;
+
+AppImageUpdateManager::AppImageUpdateManager(int workerThreads, int maxInFlightRequests,
+        int maxConcurrentSeedScans, QObject *parent)
+    : QObject(parent)
+{
+    p_UpdateManager = new AppImageUpdateManagerPrivate(workerThreads, maxInFlightRequests,
+            maxConcurrentSeedScans, this);
+    connectSignals();
+    return;
+}
+
+AppImageUpdateManager::~AppImageUpdateManager()
+{
+    p_UpdateManager->deleteLater();
+    return;
+}
+
+void AppImageUpdateManager::update(const QStringList &AppImages)
+{
+    getMethod(p_UpdateManager, "update(const QStringList&)")
+    .invoke(p_UpdateManager, Qt::QueuedConnection, Q_ARG(QStringList, AppImages));
+    return;
+}
+
+void AppImageUpdateManager::checkForUpdate(const QStringList &AppImages)
+{
+    getMethod(p_UpdateManager, "checkForUpdate(const QStringList&)")
+    .invoke(p_UpdateManager, Qt::QueuedConnection, Q_ARG(QStringList, AppImages));
+    return;
+}
+
+void AppImageUpdateManager::cancel(const QString &AppImage)
+{
+    getMethod(p_UpdateManager, "cancel(const QString&)")
+    .invoke(p_UpdateManager, Qt::QueuedConnection, Q_ARG(QString, AppImage));
+    return;
+}
+
+void AppImageUpdateManager::cancelAll(void)
+{
+    getMethod(p_UpdateManager, "cancelAll(void)").invoke(p_UpdateManager, Qt::QueuedConnection);
+    return;
+}
+
+void AppImageUpdateManager::setOutputDirectory(const QString &dir)
+{
+    getMethod(p_UpdateManager, "setOutputDirectory(const QString&)")
+    .invoke(p_UpdateManager, Qt::QueuedConnection, Q_ARG(QString, dir));
+    return;
+}
+
+void AppImageUpdateManager::setBlockStore(const QString &directory, qint64 maxSize)
+{
+    getMethod(p_UpdateManager, "setBlockStore(const QString&, qint64)")
+    .invoke(p_UpdateManager, Qt::QueuedConnection, Q_ARG(QString, directory), Q_ARG(qint64, maxSize));
+    return;
+}
+
+void AppImageUpdateManager::setProxy(const QNetworkProxy &proxy)
+{
+    getMethod(p_UpdateManager, "setProxy(const QNetworkProxy&)")
+    .invoke(p_UpdateManager, Qt::QueuedConnection, Q_ARG(QNetworkProxy, proxy));
+    return;
+}
+
+void AppImageUpdateManager::setShowLog(bool choice)
+{
+    getMethod(p_UpdateManager, "setShowLog(bool)")
+    .invoke(p_UpdateManager, Qt::QueuedConnection, Q_ARG(bool, choice));
+    return;
+}
+
+/* See AppImageDeltaRevisioner::connectNotify. */
+void AppImageUpdateManager::connectNotify(const QMetaMethod &signal)
+{
+    if(p_UpdateManager && signal == QMetaMethod::fromSignal(&AppImageUpdateManager::logger)) {
+        getMethod(p_UpdateManager, "setLoggerConnected(bool)")
+        .invoke(p_UpdateManager, Qt::QueuedConnection, Q_ARG(bool, true));
+    }
+    QObject::connectNotify(signal);
+    return;
+}
+
+void AppImageUpdateManager::disconnectNotify(const QMetaMethod &signal)
+{
+    if(p_UpdateManager &&
+       (!signal.isValid() || signal == QMetaMethod::fromSignal(&AppImageUpdateManager::logger)) &&
+       !isSignalConnected(QMetaMethod::fromSignal(&AppImageUpdateManager::logger))) {
+        getMethod(p_UpdateManager, "setLoggerConnected(bool)")
+        .invoke(p_UpdateManager, Qt::QueuedConnection, Q_ARG(bool, false));
+    }
+    QObject::disconnectNotify(signal);
+    return;
+}
+
+void AppImageUpdateManager::connectSignals()
+{
+    connect(p_UpdateManager, &AppImageUpdateManagerPrivate::started,
+            this, &AppImageUpdateManager::started, Qt::DirectConnection);
+    connect(p_UpdateManager, &AppImageUpdateManagerPrivate::canceled,
+            this, &AppImageUpdateManager::canceled, Qt::DirectConnection);
+    connect(p_UpdateManager, &AppImageUpdateManagerPrivate::finished,
+            this, &AppImageUpdateManager::finished, Qt::DirectConnection);
+    connect(p_UpdateManager, &AppImageUpdateManagerPrivate::updateAvailable,
+            this, &AppImageUpdateManager::updateAvailable, Qt::DirectConnection);
+    connect(p_UpdateManager, &AppImageUpdateManagerPrivate::error,
+            this, &AppImageUpdateManager::error, Qt::DirectConnection);
+    connect(p_UpdateManager, &AppImageUpdateManagerPrivate::progress,
+            this, &AppImageUpdateManager::progress, Qt::DirectConnection);
+    connect(p_UpdateManager, &AppImageUpdateManagerPrivate::logger,
+            this, &AppImageUpdateManager::logger, Qt::DirectConnection);
+    connect(p_UpdateManager, &AppImageUpdateManagerPrivate::allFinished,
+            this, &AppImageUpdateManager::allFinished, Qt::DirectConnection);
+}
@@ -0,0 +1,332 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : appimageupdatemanager_p.cc
+ * @description : This is where the private update manager is implemented.
+*/
+#include "../include/appimageupdatemanager_p.hpp"
+#include "../include/appimagedeltarevisioner_p.hpp"
+#include "../include/zsyncrequestlimiter_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+/*
+ * AppImageUpdateManagerPrivate runs many AppImageDeltaRevisionerPrivate jobs
+ * at once without giving each of them its own thread and network access manager.
+ * All jobs share one network thread with a single QNetworkAccessManager , so
+ * connections to the same host are reused , and a fixed number of worker threads
+ * which run the update information and the delta writers in round robin.
+ * The number of block range requests in flight and the number of seed files
+ * scanned at the same time are limited across all jobs.
+ *
+ * Atmost as many jobs as there are worker threads run at the same time , the
+ * rest wait in a queue. The AppImages and seed indexes of all jobs are hashed
+ * in one pool with the same number of threads.
+ *
+ * Example:
+ * 	AppImageUpdateManagerPrivate manager(4, 16, 2);
+ * 	manager.update(QStringList() << "/opt/A.AppImage" << "/opt/B.AppImage");
+*/
+AppImageUpdateManagerPrivate::AppImageUpdateManagerPrivate(int workerThreads,
+        int maxInFlightRequests,
+        int maxConcurrentSeedScans,
+        QObject *parent)
+    : QObject(parent)
+{
+    if(workerThreads < 1) {
+        workerThreads = QThread::idealThreadCount() < 1 ? 1 : QThread::idealThreadCount();
+    }
+    if(maxConcurrentSeedScans < 1) {
+        maxConcurrentSeedScans = workerThreads;
+    }
+
+    p_NetworkThread.reset(new QThread);
+    p_NetworkThread->start();
+    p_NetworkAccessManager.reset(new QNetworkAccessManager);
+    p_NetworkAccessManager->moveToThread(p_NetworkThread.data());
+
+    for(int i = 0; i < workerThreads; ++i) {
+        auto thread = new QThread;
+        thread->start();
+        m_WorkerThreads.append(thread);
+    }
+
+    n_MaxRunningJobs = workerThreads;
+    p_WorkerPool.reset(new QThreadPool);
+    p_WorkerPool->setMaxThreadCount(workerThreads);
+
+    p_RequestLimiter.reset(new ZsyncRequestLimiterPrivate(maxInFlightRequests));
+    p_SeedScanLimiter.reset(new ZsyncRequestLimiterPrivate(maxConcurrentSeedScans));
+    return;
+}
+
+AppImageUpdateManagerPrivate::~AppImageUpdateManagerPrivate()
+{
+    /* Jobs hand their objects to the threads for deletion ,
+     * so delete them before the threads are stopped. */
+    m_QueuedJobs.clear();
+    for(auto iter = m_Jobs.begin(), end = m_Jobs.end(); iter != end; ++iter) {
+        (*iter)->disconnect(this);
+        delete (*iter);
+    }
+    m_Jobs.clear();
+
+    for(auto iter = m_WorkerThreads.begin(), end = m_WorkerThreads.end(); iter != end; ++iter) {
+        (*iter)->quit();
+        (*iter)->wait();
+        delete (*iter);
+    }
+    m_WorkerThreads.clear();
+
+    p_NetworkThread->quit();
+    p_NetworkThread->wait();
+    p_NetworkAccessManager.reset();
+    return;
+}
+
+void AppImageUpdateManagerPrivate::update(const QStringList &AppImages)
+{
+    for(auto iter = AppImages.constBegin(), end = AppImages.constEnd(); iter != end; ++iter) {
+        queueJob(*iter, UpdateJob);
+    }
+    startQueuedJobs();
+    return;
+}
+
+void AppImageUpdateManagerPrivate::checkForUpdate(const QStringList &AppImages)
+{
+    for(auto iter = AppImages.constBegin(), end = AppImages.constEnd(); iter != end; ++iter) {
+        queueJob(*iter, CheckForUpdateJob);
+    }
+    startQueuedJobs();
+    return;
+}
+
+/* Cancels the running or queued update of the given AppImage. */
+void AppImageUpdateManagerPrivate::cancel(const QString &AppImage)
+{
+    auto job = m_Jobs.value(AppImage);
+    if(job) {
+        job->cancel();
+        return;
+    }
+    for(int i = 0; i < m_QueuedJobs.size(); ++i) {
+        if(m_QueuedJobs.at(i).first == AppImage) {
+            m_QueuedJobs.removeAt(i);
+            emit canceled(AppImage);
+            if(m_Jobs.isEmpty() && m_QueuedJobs.isEmpty()) {
+                emit allFinished();
+            }
+            break;
+        }
+    }
+    return;
+}
+
+void AppImageUpdateManagerPrivate::cancelAll(void)
+{
+    auto queuedJobs = m_QueuedJobs;
+    m_QueuedJobs.clear();
+    for(auto iter = queuedJobs.constBegin(), end = queuedJobs.constEnd(); iter != end; ++iter) {
+        emit canceled((*iter).first);
+    }
+    for(auto iter = m_Jobs.constBegin(), end = m_Jobs.constEnd(); iter != end; ++iter) {
+        (*iter)->cancel();
+    }
+    if(!queuedJobs.isEmpty() && m_Jobs.isEmpty()) {
+        emit allFinished();
+    }
+    return;
+}
+
+/* Only affects jobs which are started after this call. */
+void AppImageUpdateManagerPrivate::setOutputDirectory(const QString &dir)
+{
+    s_OutputDirectory = dir;
+    return;
+}
+
+/*
+ * All jobs share the same block store , So blocks of one updated AppImage
+ * can be used by the others. Only affects jobs which are started after this call.
+*/
+void AppImageUpdateManagerPrivate::setBlockStore(const QString &directory, qint64 maxSize)
+{
+    s_BlockStoreDirectory = directory;
+    n_BlockStoreMaxSize = maxSize;
+    return;
+}
+
+/* The proxy is shared by all jobs since they share the network access manager. */
+void AppImageUpdateManagerPrivate::setProxy(const QNetworkProxy &proxy)
+{
+    p_NetworkAccessManager->setProxy(proxy);
+    return;
+}
+
+void AppImageUpdateManagerPrivate::setShowLog(bool choice)
+{
+    b_ShowLog = choice;
+    for(auto iter = m_Jobs.constBegin(), end = m_Jobs.constEnd(); iter != end; ++iter) {
+        (*iter)->setShowLog(choice);
+    }
+    return;
+}
+
+/* Jobs only format log messages if someone listens to the logger signal. */
+void AppImageUpdateManagerPrivate::setLoggerConnected(bool connected)
+{
+    b_LoggerConnected = connected;
+    for(auto iter = m_Jobs.constBegin(), end = m_Jobs.constEnd(); iter != end; ++iter) {
+        (*iter)->setLoggerConnected(connected);
+    }
+    return;
+}
+
+/* Worker threads are handed out in round robin. */
+QThread *AppImageUpdateManagerPrivate::nextWorkerThread(void)
+{
+    auto thread = m_WorkerThreads.at(n_NextWorkerThread);
+    n_NextWorkerThread = (n_NextWorkerThread + 1) % m_WorkerThreads.size();
+    return thread;
+}
+
+/* A AppImage which already has a running or queued job is ignored. */
+void AppImageUpdateManagerPrivate::queueJob(const QString &AppImage, short kind)
+{
+    if(m_Jobs.contains(AppImage)) {
+        return;
+    }
+    for(auto iter = m_QueuedJobs.constBegin(), end = m_QueuedJobs.constEnd(); iter != end; ++iter) {
+        if((*iter).first == AppImage) {
+            return;
+        }
+    }
+    m_QueuedJobs.enqueue(qMakePair(AppImage, kind));
+    return;
+}
+
+/* Starts queued jobs while fewer than the worker budget are running. */
+void AppImageUpdateManagerPrivate::startQueuedJobs(void)
+{
+    while(m_Jobs.size() < n_MaxRunningJobs && !m_QueuedJobs.isEmpty()) {
+        auto queued = m_QueuedJobs.dequeue();
+        auto job = createJob(queued.first);
+        if(!job) {
+            continue;
+        }
+        if(queued.second == CheckForUpdateJob) {
+            job->checkForUpdate();
+        } else {
+            job->start();
+        }
+    }
+    return;
+}
+
+/*
+ * Creates a new job for the given AppImage , returns nullptr if the AppImage
+ * already has a running job. All signals of the job are forwarded with the
+ * AppImage path attached , the job is removed as soon as it is done.
+*/
+AppImageDeltaRevisionerPrivate *AppImageUpdateManagerPrivate::createJob(const QString &AppImage)
+{
+    if(m_Jobs.contains(AppImage)) {
+        return nullptr;
+    }
+
+    auto job = new AppImageDeltaRevisionerPrivate(p_NetworkAccessManager.data(),
+            p_NetworkThread.data(),
+            nextWorkerThread(),
+            p_RequestLimiter.data(),
+            p_SeedScanLimiter.data(),
+            p_WorkerPool.data());
+    m_Jobs.insert(AppImage, job);
+
+    /*
+     * Jobs emit from the shared threads , giving 'this' as the context
+     * makes every forward a queued call into this thread.
+    */
+    connect(job, &AppImageDeltaRevisionerPrivate::started, this, [this, AppImage]() {
+        emit started(AppImage);
+    });
+    connect(job, &AppImageDeltaRevisionerPrivate::progress, this,
+    [this, AppImage](int percentage, qint64 bytesReceived, qint64 bytesTotal, double speed, QString units) {
+        Q_UNUSED(speed);
+        Q_UNUSED(units);
+        emit progress(AppImage, percentage, bytesReceived, bytesTotal);
+    });
+    connect(job, &AppImageDeltaRevisionerPrivate::logger,
+            this, &AppImageUpdateManagerPrivate::logger);
+    connect(job, &AppImageDeltaRevisionerPrivate::finished, this, [this, AppImage](QJsonObject info, QString oldVersionPath) {
+        emit finished(info, oldVersionPath, AppImage);
+        removeJob(AppImage);
+    });
+    connect(job, &AppImageDeltaRevisionerPrivate::updateAvailable, this, [this, AppImage](bool available, QJsonObject info) {
+        emit updateAvailable(available, info, AppImage);
+        removeJob(AppImage);
+    });
+    connect(job, &AppImageDeltaRevisionerPrivate::canceled, this, [this, AppImage]() {
+        emit canceled(AppImage);
+        removeJob(AppImage);
+    });
+    connect(job, &AppImageDeltaRevisionerPrivate::error, this, [this, AppImage](short errorCode) {
+        emit error(errorCode, AppImage);
+        removeJob(AppImage);
+    });
+
+    job->setShowLog(b_ShowLog);
+    job->setLoggerConnected(b_LoggerConnected);
+    if(!s_OutputDirectory.isEmpty()) {
+        job->setOutputDirectory(s_OutputDirectory);
+    }
+    if(!s_BlockStoreDirectory.isEmpty()) {
+        job->setBlockStore(s_BlockStoreDirectory, n_BlockStoreMaxSize);
+    }
+    job->setAppImage(AppImage);
+    return job;
+}
+
+void AppImageUpdateManagerPrivate::removeJob(const QString &AppImage)
+{
+    auto job = m_Jobs.take(AppImage);
+    if(!job) {
+        return;
+    }
+    job->disconnect(this);
+    job->deleteLater();
+
+    startQueuedJobs();
+    if(m_Jobs.isEmpty() && m_QueuedJobs.isEmpty()) {
+        emit allFinished();
+    }
+    return;
+}
@@ -255,6 +255,9 @@ QString AppImageUpdaterBridge::errorCodeToString(short errorCode)
     case TargetFileSha1HashMismatch:
         ret += "TargetFileSha1HashMismatch";
         break;
+    case NoCoreApplication:
+        ret += "NoCoreApplication";
+        break;
 
     default:
         ret += "Unknown";
@@ -440,6 +443,9 @@ QString AppImageUpdaterBridge::errorCodeToDescriptionString(short errorCode)
     case TargetFileSha1HashMismatch:
         errorString = QString::fromUtf8("The newly constructed AppImage failed the integrity check, please try again.");
         break;
+    case NoCoreApplication:
+        errorString = QString::fromUtf8("The QCoreApplication of the process is already destroyed.");
+        break;
     default:
         errorString = QString::fromUtf8("Unknown error.");
         break;
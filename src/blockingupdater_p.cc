@@ -0,0 +1,227 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : blockingupdater_p.cc
+ * @description : This is where the blocking updater is implemented.
+ * The blocking updater runs a delta revisioner in its own thread and
+ * blocks the caller until the result is known , So it can be used
+ * without an event loop.
+*/
+#include <QCoreApplication>
+#include <QMutex>
+#include <QThread>
+
+#include "../include/blockingupdater_p.hpp"
+#include "../include/appimagedeltarevisioner_p.hpp"
+#include "../include/helpers_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+static constexpr int CancelGracePeriod = 2000; /* In milliseconds. */
+
+/*
+ * A plain main() may not have a QCoreApplication , One is created for the
+ * whole process then. It is never destroyed since the threads of a timed out
+ * update may still use it. Returns false if the QCoreApplication of the
+ * process is being or was already destroyed.
+*/
+static bool ensureCoreApplication(void)
+{
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+    if(QCoreApplication::instance()) {
+        return true;
+    }
+    if(QCoreApplication::closingDown()) {
+        return false;
+    }
+    static int argc = 1;
+    static char applicationName[] = "AppImageUpdaterBridge";
+    static char *argv[] = { applicationName, nullptr };
+    new QCoreApplication(argc, argv);
+    return true;
+}
+
+BlockingUpdaterPrivate::BlockingUpdaterPrivate(const UpdateOptions &options, const QSharedPointer<QSemaphore> &done)
+    : QObject(),
+      m_Options(options),
+      p_Done(done)
+{
+    return;
+}
+
+BlockingUpdaterPrivate::~BlockingUpdaterPrivate()
+{
+    return;
+}
+
+/*
+ * Runs a update or a update check in a new thread and blocks until it is
+ * done or the timeout given in the options is reached. The caller does not
+ * need a event loop , nothing is dispatched in the caller's thread. A
+ * QCoreApplication is created if there is none , So the first call should
+ * come from the main thread then.
+ *
+ * On timeout the update is canceled and TimeoutError is returned within the
+ * cancel grace period. A stage which cannot be interrupted , like a stalled
+ * read of the AppImage , is not waited for , The updater is deleted in its
+ * own thread once it lets go and the thread quits after it.
+ *
+ * Example:
+ * 	UpdateOptions options;
+ * 	options.appImagePath = "/opt/A.AppImage";
+ * 	auto result = BlockingUpdaterPrivate::run(options, true);
+*/
+UpdateResult BlockingUpdaterPrivate::run(const UpdateOptions &options, bool checkOnly)
+{
+    if(!ensureCoreApplication()) {
+        UpdateResult result;
+        result.errorCode = NoCoreApplication;
+        return result;
+    }
+
+    QSharedPointer<QSemaphore> done(new QSemaphore);
+    auto thread = new QThread;
+    auto updater = new BlockingUpdaterPrivate(options, done);
+    updater->moveToThread(thread);
+    connect(updater, &QObject::destroyed, thread, &QThread::quit, Qt::DirectConnection);
+    thread->start();
+
+    getMethod(updater, "start(bool)").invoke(updater, Qt::QueuedConnection, Q_ARG(bool, checkOnly));
+
+    if(!done->tryAcquire(1, options.timeout)) {
+        getMethod(updater, "cancel(void)").invoke(updater, Qt::QueuedConnection);
+        UpdateResult result;
+        result.errorCode = TimeoutError;
+        result.canceled = done->tryAcquire(1, CancelGracePeriod);
+
+        /* Deleted by the event loop of this thread , if it ever runs. */
+        connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+        updater->deleteLater();
+        return result;
+    }
+
+    auto result = updater->result();
+    updater->deleteLater();
+    thread->wait();
+    delete thread;
+    return result;
+}
+
+UpdateResult BlockingUpdaterPrivate::result(void) const
+{
+    return m_Result;
+}
+
+/* Called in the updater's thread , So the revisioner lives in this thread. */
+void BlockingUpdaterPrivate::start(bool checkOnly)
+{
+    p_DeltaRevisioner.reset(new AppImageDeltaRevisionerPrivate(m_Options.appImagePath, m_Options.threadingMode));
+    connect(p_DeltaRevisioner.data(), &AppImageDeltaRevisionerPrivate::finished,
+            this, &BlockingUpdaterPrivate::handleFinished);
+    connect(p_DeltaRevisioner.data(), &AppImageDeltaRevisionerPrivate::updateAvailable,
+            this, &BlockingUpdaterPrivate::handleUpdateAvailable);
+    connect(p_DeltaRevisioner.data(), &AppImageDeltaRevisionerPrivate::error,
+            this, &BlockingUpdaterPrivate::handleError);
+    connect(p_DeltaRevisioner.data(), &AppImageDeltaRevisionerPrivate::canceled,
+            this, &BlockingUpdaterPrivate::handleCanceled);
+
+    p_DeltaRevisioner->setShowLog(m_Options.showLog);
+    if(!m_Options.outputDirectory.isEmpty()) {
+        p_DeltaRevisioner->setOutputDirectory(m_Options.outputDirectory);
+    }
+    if(m_Options.useProxy) {
+        p_DeltaRevisioner->setProxy(m_Options.proxy);
+    }
+
+    if(checkOnly) {
+        p_DeltaRevisioner->checkForUpdate();
+    } else {
+        p_DeltaRevisioner->start();
+    }
+    return;
+}
+
+void BlockingUpdaterPrivate::cancel(void)
+{
+    if(p_DeltaRevisioner.isNull()) {
+        return;
+    }
+    p_DeltaRevisioner->cancel();
+    return;
+}
+
+void BlockingUpdaterPrivate::handleFinished(QJsonObject newVersion, QString oldVersionPath)
+{
+    m_Result.newVersionPath = newVersion["AbsolutePath"].toString();
+    m_Result.sha1Hash = newVersion["Sha1Hash"].toString();
+    m_Result.oldVersionPath = oldVersionPath;
+    m_Result.updateAvailable = (m_Result.newVersionPath != oldVersionPath);
+    done();
+    return;
+}
+
+void BlockingUpdaterPrivate::handleUpdateAvailable(bool isUpdateAvailable, QJsonObject information)
+{
+    m_Result.updateAvailable = isUpdateAvailable;
+    m_Result.oldVersionPath = information["AbsolutePath"].toString();
+    m_Result.sha1Hash = information["Sha1Hash"].toString();
+    m_Result.remoteSha1Hash = information["RemoteSha1Hash"].toString();
+    m_Result.releaseNotes = information["ReleaseNotes"].toString();
+    done();
+    return;
+}
+
+void BlockingUpdaterPrivate::handleError(short errorCode)
+{
+    m_Result.errorCode = errorCode;
+    done();
+    return;
+}
+
+void BlockingUpdaterPrivate::handleCanceled(void)
+{
+    m_Result.canceled = true;
+    done();
+    return;
+}
+
+/* Only the first result counts , wakes up the caller. */
+void BlockingUpdaterPrivate::done(void)
+{
+    if(b_Done) {
+        return;
+    }
+    b_Done = true;
+    p_DeltaRevisioner->disconnect(this);
+    p_Done->release();
+    return;
+}
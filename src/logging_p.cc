@@ -0,0 +1,181 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : logging_p.cc
+ * @description : This is where the logging categories and the log ring
+ * buffer are implemented.
+*/
+#include <QAtomicInteger>
+#include <QDateTime>
+#include <cstring>
+
+#include "../include/logging_p.hpp"
+
+namespace AppImageUpdaterBridge
+{
+Q_LOGGING_CATEGORY(lcUpdateInformation, "appimageupdaterbridge.updateinformation")
+Q_LOGGING_CATEGORY(lcControlFileParser, "appimageupdaterbridge.controlfileparser")
+Q_LOGGING_CATEGORY(lcDeltaWriter, "appimageupdaterbridge.deltawriter")
+}
+
+using namespace AppImageUpdaterBridge;
+
+/* Number of messages kept , older ones are overwritten. */
+static constexpr quint64 LogRingSlots = 1024;
+
+/* Longer messages are truncated. */
+static constexpr int LogRingMessageWords = 30;
+static constexpr int LogRingMessageSize = LogRingMessageWords * sizeof(quint64);
+
+namespace
+{
+/*
+ * The sequence of a slot is odd while it is written , and 2 * (ticket + 1)
+ * once the message of the given ticket is complete.
+ * A reader may copy a slot while it is written again , So everything in it
+ * is atomic. The payload is stored with release and loaded with acquire ,
+ * So a reader which saw any new payload also sees the new sequence.
+*/
+struct LogRingSlot {
+    QAtomicInteger<quint64> n_Sequence;
+    QAtomicInteger<qint64> n_Time;
+    QAtomicInt m_Type,
+               n_Size;
+    QAtomicInteger<quint64> p_Message[LogRingMessageWords];
+};
+
+struct LogRing {
+    QAtomicInt n_Enabled;
+    QAtomicInteger<quint64> n_Head;
+    LogRingSlot m_Slots[LogRingSlots];
+};
+}
+
+Q_GLOBAL_STATIC(LogRing, logRing)
+
+/*
+ * LogRingBufferPrivate keeps the last few log messages of all updaters in the
+ * process , without any signal or lock , So logs can be captured in production
+ * and looked at only when something went wrong.
+ *
+ * Writers take a ticket with a single atomic add and write their own slot ,
+ * Readers only take messages whose slot sequence did not change while they
+ * copied it , the slots are all atomic so the copy itself is never a race.
+ * A message is lost only if the ring wraps around while it is written , i.e
+ * more than LogRingSlots messages are logged meanwhile.
+ *
+ * Example:
+ * 	LogRingBufferPrivate::setEnabled(true);
+ * 	...
+ * 	for(auto message : LogRingBufferPrivate::messages()) {
+ * 		qDebug() << message;
+ * 	}
+*/
+void LogRingBufferPrivate::setEnabled(bool enabled)
+{
+    logRing()->n_Enabled.storeRelease(enabled ? 1 : 0);
+    return;
+}
+
+bool LogRingBufferPrivate::isEnabled(void)
+{
+    return logRing()->n_Enabled.loadAcquire() != 0;
+}
+
+void LogRingBufferPrivate::append(QtMsgType type, const QString &loggerName, const QString &message)
+{
+    if(!isEnabled()) {
+        return;
+    }
+    auto ring = logRing();
+    QByteArray text = (loggerName + QString::fromUtf8("::") + message).toUtf8();
+    quint64 ticket = ring->n_Head.fetchAndAddOrdered(1);
+    LogRingSlot &slot = ring->m_Slots[ticket % LogRingSlots];
+
+    int size = qMin(text.size(), LogRingMessageSize);
+    quint64 words[LogRingMessageWords] = { 0 };
+    memcpy(words, text.constData(), size);
+
+    slot.n_Sequence.storeRelease(2 * ticket + 1);
+    slot.n_Time.storeRelease(QDateTime::currentMSecsSinceEpoch());
+    slot.m_Type.storeRelease(type);
+    slot.n_Size.storeRelease(size);
+    for(int i = 0; i < (size + 7) / 8; ++i) {
+        slot.p_Message[i].storeRelease(words[i]);
+    }
+    slot.n_Sequence.storeRelease(2 * (ticket + 1));
+    return;
+}
+
+/* The captured messages , oldest first. */
+QStringList LogRingBufferPrivate::messages(void)
+{
+    auto ring = logRing();
+    QStringList result;
+    quint64 head = ring->n_Head.loadAcquire();
+    quint64 ticket = head > LogRingSlots ? head - LogRingSlots : 0;
+    for(; ticket < head; ++ticket) {
+        const LogRingSlot &slot = ring->m_Slots[ticket % LogRingSlots];
+        quint64 sequence = slot.n_Sequence.loadAcquire();
+        if(sequence != 2 * (ticket + 1)) {
+            continue; /* Still written or already overwritten. */
+        }
+        qint64 time = slot.n_Time.loadAcquire();
+        QtMsgType type = static_cast<QtMsgType>(slot.m_Type.loadAcquire());
+        int size = qBound(0, slot.n_Size.loadAcquire(), LogRingMessageSize);
+        quint64 words[LogRingMessageWords];
+        for(int i = 0; i < (size + 7) / 8; ++i) {
+            words[i] = slot.p_Message[i].loadAcquire();
+        }
+        if(slot.n_Sequence.loadAcquire() != sequence) {
+            continue;
+        }
+        QByteArray text(reinterpret_cast<const char*>(words), size);
+
+        const char *level = (type == QtWarningMsg) ? "WARNING" :
+                            (type == QtCriticalMsg || type == QtFatalMsg) ? "FATAL" : "INFO";
+        result << QString::fromUtf8("[%1] %2: %3")
+               .arg(QDateTime::fromMSecsSinceEpoch(time).toString(Qt::ISODate))
+               .arg(QString::fromLatin1(level))
+               .arg(QString::fromUtf8(text));
+    }
+    return result;
+}
+
+/* Drops all captured messages. */
+void LogRingBufferPrivate::clear(void)
+{
+    auto ring = logRing();
+    for(quint64 i = 0; i < LogRingSlots; ++i) {
+        ring->m_Slots[i].n_Sequence.storeRelease(0);
+    }
+    return;
+}
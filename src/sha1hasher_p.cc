@@ -0,0 +1,442 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : sha1hasher_p.cc
+ * @description : This is where the SHA-1 hasher is implemented.
+*/
+#include <cstring>
+#include <fcntl.h>
+
+#include "../include/sha1hasher_p.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA1_HASHER_X86_SHA
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#include <arm_neon.h>
+#define SHA1_HASHER_ARM_CRYPTO
+#endif
+
+using namespace AppImageUpdaterBridge;
+
+typedef void (*Sha1CompressFunction)(quint32*, const unsigned char*, qint64);
+
+#define ROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+/*
+ * Portable SHA-1 compression function , Processes the given number
+ * of 64 byte blocks.
+*/
+static void sha1CompressPortable(quint32 *state, const unsigned char *data, qint64 blocks)
+{
+    while(blocks-- > 0) {
+        quint32 w[80];
+        for(int i = 0; i < 16; ++i) {
+            w[i] = ((quint32)data[4 * i] << 24) | ((quint32)data[4 * i + 1] << 16) |
+                   ((quint32)data[4 * i + 2] << 8) | ((quint32)data[4 * i + 3]);
+        }
+        for(int i = 16; i < 80; ++i) {
+            w[i] = ROL32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        quint32 a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for(int i = 0; i < 80; ++i) {
+            quint32 f, k;
+            if(i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if(i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if(i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            quint32 t = ROL32(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = ROL32(b, 30);
+            b = a;
+            a = t;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        data += 64;
+    }
+    return;
+}
+
+#ifdef SHA1_HASHER_X86_SHA
+/*
+ * Four rounds of SHA-1 with the SHA extensions , W is the message group used by
+ * this rounds and W1 , W2 , W3 are the next three message groups in order which
+ * are scheduled on the way.
+*/
+#define SHA1_X86_ROUNDS(ECUR, EOTH, F, W, W1, W2, W3) \
+    ECUR = _mm_sha1nexte_epu32(ECUR, W); \
+    EOTH = ABCD; \
+    W1 = _mm_sha1msg2_epu32(W1, W); \
+    ABCD = _mm_sha1rnds4_epu32(ABCD, ECUR, F); \
+    W3 = _mm_sha1msg1_epu32(W3, W); \
+    W2 = _mm_xor_si128(W2, W);
+
+__attribute__((target("sha,ssse3,sse4.1")))
+static void sha1CompressX86(quint32 *state, const unsigned char *data, qint64 blocks)
+{
+    __m128i ABCD, ABCD_SAVE, E0, E0_SAVE, E1;
+    __m128i MSG0, MSG1, MSG2, MSG3;
+    const __m128i MASK = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+
+    ABCD = _mm_loadu_si128((const __m128i*)state);
+    E0 = _mm_set_epi32(state[4], 0, 0, 0);
+    ABCD = _mm_shuffle_epi32(ABCD, 0x1B);
+
+    while(blocks-- > 0) {
+        ABCD_SAVE = ABCD;
+        E0_SAVE = E0;
+
+        /* Rounds 0-3 */
+        MSG0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 0)), MASK);
+        E0 = _mm_add_epi32(E0, MSG0);
+        E1 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+
+        /* Rounds 4-7 */
+        MSG1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 16)), MASK);
+        E1 = _mm_sha1nexte_epu32(E1, MSG1);
+        E0 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 0);
+        MSG0 = _mm_sha1msg1_epu32(MSG0, MSG1);
+
+        /* Rounds 8-11 */
+        MSG2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 32)), MASK);
+        E0 = _mm_sha1nexte_epu32(E0, MSG2);
+        E1 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 0);
+        MSG1 = _mm_sha1msg1_epu32(MSG1, MSG2);
+        MSG0 = _mm_xor_si128(MSG0, MSG2);
+
+        /* Rounds 12-15 */
+        MSG3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + 48)), MASK);
+        SHA1_X86_ROUNDS(E1, E0, 0, MSG3, MSG0, MSG1, MSG2);
+
+        /* Rounds 16-59 */
+        SHA1_X86_ROUNDS(E0, E1, 0, MSG0, MSG1, MSG2, MSG3);
+        SHA1_X86_ROUNDS(E1, E0, 1, MSG1, MSG2, MSG3, MSG0);
+        SHA1_X86_ROUNDS(E0, E1, 1, MSG2, MSG3, MSG0, MSG1);
+        SHA1_X86_ROUNDS(E1, E0, 1, MSG3, MSG0, MSG1, MSG2);
+        SHA1_X86_ROUNDS(E0, E1, 1, MSG0, MSG1, MSG2, MSG3);
+        SHA1_X86_ROUNDS(E1, E0, 1, MSG1, MSG2, MSG3, MSG0);
+        SHA1_X86_ROUNDS(E0, E1, 2, MSG2, MSG3, MSG0, MSG1);
+        SHA1_X86_ROUNDS(E1, E0, 2, MSG3, MSG0, MSG1, MSG2);
+        SHA1_X86_ROUNDS(E0, E1, 2, MSG0, MSG1, MSG2, MSG3);
+        SHA1_X86_ROUNDS(E1, E0, 2, MSG1, MSG2, MSG3, MSG0);
+        SHA1_X86_ROUNDS(E0, E1, 2, MSG2, MSG3, MSG0, MSG1);
+        SHA1_X86_ROUNDS(E1, E0, 3, MSG3, MSG0, MSG1, MSG2);
+
+        /* Rounds 64-67 */
+        E0 = _mm_sha1nexte_epu32(E0, MSG0);
+        E1 = ABCD;
+        MSG1 = _mm_sha1msg2_epu32(MSG1, MSG0);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 3);
+        MSG3 = _mm_sha1msg1_epu32(MSG3, MSG0);
+        MSG2 = _mm_xor_si128(MSG2, MSG0);
+
+        /* Rounds 68-71 */
+        E1 = _mm_sha1nexte_epu32(E1, MSG1);
+        E0 = ABCD;
+        MSG2 = _mm_sha1msg2_epu32(MSG2, MSG1);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+        MSG3 = _mm_xor_si128(MSG3, MSG1);
+
+        /* Rounds 72-75 */
+        E0 = _mm_sha1nexte_epu32(E0, MSG2);
+        E1 = ABCD;
+        MSG3 = _mm_sha1msg2_epu32(MSG3, MSG2);
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E0, 3);
+
+        /* Rounds 76-79 */
+        E1 = _mm_sha1nexte_epu32(E1, MSG3);
+        E0 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32(ABCD, E1, 3);
+
+        /* Combine state */
+        E0 = _mm_sha1nexte_epu32(E0, E0_SAVE);
+        ABCD = _mm_add_epi32(ABCD, ABCD_SAVE);
+        data += 64;
+    }
+
+    ABCD = _mm_shuffle_epi32(ABCD, 0x1B);
+    _mm_storeu_si128((__m128i*)state, ABCD);
+    state[4] = _mm_extract_epi32(E0, 3);
+    return;
+}
+
+static bool cpuHasShaExtensions(void)
+{
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    const bool hasSsse3 = (ecx & (1u << 9)),
+               hasSse41 = (ecx & (1u << 19));
+    if(__get_cpuid_max(0, nullptr) < 7) {
+        return false;
+    }
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return hasSsse3 && hasSse41 && (ebx & (1u << 29));
+}
+#endif // SHA1_HASHER_X86_SHA
+
+#ifdef SHA1_HASHER_ARM_CRYPTO
+/*
+ * SHA-1 compression with the ARMv8 crypto extensions , Only compiled when the
+ * target of the build already has the crypto extensions.
+*/
+static void sha1CompressArm(quint32 *state, const unsigned char *data, qint64 blocks)
+{
+    static const quint32 K[4] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
+    uint32x4_t ABCD = vld1q_u32(&state[0]);
+    quint32 E0 = state[4];
+
+    while(blocks-- > 0) {
+        const uint32x4_t ABCD_SAVE = ABCD;
+        const quint32 E0_SAVE = E0;
+        uint32x4_t MSG[4], TMP[2];
+        quint32 E[2] = { E0, 0 };
+
+        for(int i = 0; i < 4; ++i) {
+            MSG[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+        }
+        TMP[0] = vaddq_u32(MSG[0], vdupq_n_u32(K[0]));
+        TMP[1] = vaddq_u32(MSG[1], vdupq_n_u32(K[0]));
+
+        for(int g = 0; g < 20; ++g) {
+            const int cur = g & 1;
+            E[cur ^ 1] = vsha1h_u32(vgetq_lane_u32(ABCD, 0));
+            if(g < 5) {
+                ABCD = vsha1cq_u32(ABCD, E[cur], TMP[cur]);
+            } else if(g < 10 || g >= 15) {
+                ABCD = vsha1pq_u32(ABCD, E[cur], TMP[cur]);
+            } else {
+                ABCD = vsha1mq_u32(ABCD, E[cur], TMP[cur]);
+            }
+            if(g + 2 < 20) {
+                TMP[cur] = vaddq_u32(MSG[(g + 2) & 3], vdupq_n_u32(K[(g + 2) / 5]));
+            }
+            if(g >= 1 && g <= 16) {
+                MSG[(g + 3) & 3] = vsha1su1q_u32(MSG[(g + 3) & 3], MSG[(g + 2) & 3]);
+            }
+            if(g <= 15) {
+                MSG[g & 3] = vsha1su0q_u32(MSG[g & 3], MSG[(g + 1) & 3], MSG[(g + 2) & 3]);
+            }
+        }
+
+        E0 = E[0] + E0_SAVE;
+        ABCD = vaddq_u32(ABCD_SAVE, ABCD);
+        data += 64;
+    }
+
+    vst1q_u32(&state[0], ABCD);
+    state[4] = E0;
+    return;
+}
+#endif // SHA1_HASHER_ARM_CRYPTO
+
+/* Picks the fastest compression function available on this machine , once. */
+static Sha1CompressFunction sha1CompressFunction(void)
+{
+    static const Sha1CompressFunction function = []() -> Sha1CompressFunction {
+#if defined(SHA1_HASHER_X86_SHA)
+        if(cpuHasShaExtensions())
+        {
+            return sha1CompressX86;
+        }
+#elif defined(SHA1_HASHER_ARM_CRYPTO)
+        return sha1CompressArm;
+#endif
+        return sha1CompressPortable;
+    }();
+    return function;
+}
+
+/*
+ * Sha1HasherPrivate is a drop in replacement for QCryptographicHash(Sha1) which
+ * is hardware accelerated when possible and hashes QFile(s) through a fixed
+ * buffer allocated only once.
+ *
+ * Example:
+ * 	Sha1HasherPrivate hasher;
+ * 	hasher.addData(&file);
+ * 	QString hash = QString(hasher.result().toHex().toUpper());
+*/
+Sha1HasherPrivate::Sha1HasherPrivate(qint64 bufferSize)
+    : n_BufferSize(bufferSize < 64 ? 64 : bufferSize)
+{
+    reset();
+    return;
+}
+
+Sha1HasherPrivate::~Sha1HasherPrivate()
+{
+    return;
+}
+
+/* Returns true if the SHA-1 hashing is done by the processor's crypto extensions. */
+bool Sha1HasherPrivate::isHardwareAccelerated(void)
+{
+    return sha1CompressFunction() != sha1CompressPortable;
+}
+
+void Sha1HasherPrivate::reset(void)
+{
+    p_State[0] = 0x67452301;
+    p_State[1] = 0xEFCDAB89;
+    p_State[2] = 0x98BADCFE;
+    p_State[3] = 0x10325476;
+    p_State[4] = 0xC3D2E1F0;
+    n_Length = 0;
+    n_PendingBytes = 0;
+    return;
+}
+
+void Sha1HasherPrivate::processBlocks(const unsigned char *data, qint64 blocks)
+{
+    sha1CompressFunction()(p_State, data, blocks);
+    return;
+}
+
+void Sha1HasherPrivate::addData(const char *data, qint64 len)
+{
+    const unsigned char *p = (const unsigned char*)data;
+    if(len <= 0) {
+        return;
+    }
+    n_Length += (quint64)len;
+
+    /* Finish the pending block first. */
+    if(n_PendingBytes) {
+        qint64 needed = 64 - n_PendingBytes;
+        qint64 n = qMin(needed, len);
+        memcpy(p_Pending + n_PendingBytes, p, (size_t)n);
+        n_PendingBytes += (int)n;
+        p += n;
+        len -= n;
+        if(n_PendingBytes < 64) {
+            return;
+        }
+        processBlocks(p_Pending, 1);
+        n_PendingBytes = 0;
+    }
+
+    /* Hash all the complete blocks in place. */
+    if(len >= 64) {
+        processBlocks(p, len / 64);
+        p += len & ~(qint64)63;
+        len &= 63;
+    }
+
+    if(len) {
+        memcpy(p_Pending, p, (size_t)len);
+        n_PendingBytes = (int)len;
+    }
+    return;
+}
+
+/*
+ * Hashes at most maxSize bytes from the current position of the given QFile
+ * through the internal fixed buffer , A negative maxSize hashes everything
+ * till the end of the file.
+ * Returns false if the file could not be read.
+*/
+bool Sha1HasherPrivate::addData(QFile *file, qint64 maxSize)
+{
+    if(!file || !file->isReadable()) {
+        return false;
+    }
+
+    if(p_Buffer.isNull()) {
+        p_Buffer.reset(new char[n_BufferSize]);
+#ifdef POSIX_FADV_SEQUENTIAL
+        if(file->handle() >= 0) {
+            (void)posix_fadvise(file->handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+#endif // POSIX_FADV_SEQUENTIAL
+    }
+
+    qint64 n = 0;
+    while(maxSize) {
+        qint64 toRead = (maxSize < 0) ? n_BufferSize : qMin(maxSize, n_BufferSize);
+        if((n = file->read(p_Buffer.data(), toRead)) <= 0) {
+            break;
+        }
+        addData(p_Buffer.data(), n);
+        if(maxSize > 0) {
+            maxSize -= n;
+        }
+    }
+    return n >= 0;
+}
+
+/* Returns the SHA-1 hash of all the data added so far , The hasher can be used further. */
+QByteArray Sha1HasherPrivate::result(void)
+{
+    quint32 state[5];
+    unsigned char tail[128];
+    memcpy(state, p_State, sizeof(state));
+    memcpy(tail, p_Pending, (size_t)n_PendingBytes);
+
+    /* Append the bit 1 , pad with zeros and append the length in bits as big endian. */
+    int tailLength = (n_PendingBytes < 56) ? 64 : 128;
+    memset(tail + n_PendingBytes, 0, (size_t)(tailLength - n_PendingBytes));
+    tail[n_PendingBytes] = 0x80;
+    const quint64 bits = n_Length * 8;
+    for(int i = 0; i < 8; ++i) {
+        tail[tailLength - 1 - i] = (unsigned char)(bits >> (8 * i));
+    }
+    sha1CompressFunction()(state, tail, tailLength / 64);
+
+    QByteArray ret(20, 0);
+    for(int i = 0; i < 5; ++i) {
+        ret[4 * i] = (char)(state[i] >> 24);
+        ret[4 * i + 1] = (char)(state[i] >> 16);
+        ret[4 * i + 2] = (char)(state[i] >> 8);
+        ret[4 * i + 3] = (char)(state[i]);
+    }
+    return ret;
+}
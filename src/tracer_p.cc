@@ -0,0 +1,258 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : tracer_p.cc
+ * @description : This is where the phase tracer is implemented.
+*/
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+
+#include "../include/tracer_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+/* Events beyond this are dropped , a update has a few thousand at most. */
+static constexpr int MaxTraceEvents = 1 << 20;
+
+namespace
+{
+struct TraceEvent {
+    const char *p_Name = nullptr;
+    char c_Phase = 'X';
+    qint64 n_Timestamp = 0, /* in microseconds. */
+           n_Duration = 0;
+    quintptr n_ThreadId = 0,
+             n_Id = 0; /* only for async events. */
+    QJsonObject j_Arguments;
+};
+
+struct TraceBuffer {
+    QAtomicInt n_Users;
+    QMutex m_Mutex;
+    QElapsedTimer m_Clock;
+    QVector<TraceEvent> m_Events;
+};
+}
+
+Q_GLOBAL_STATIC(TraceBuffer, traceBuffer)
+
+static void record(TraceEvent event)
+{
+    auto buffer = traceBuffer();
+    event.n_ThreadId = reinterpret_cast<quintptr>(QThread::currentThreadId());
+    QMutexLocker locker(&buffer->m_Mutex);
+    if(buffer->m_Events.size() >= MaxTraceEvents) {
+        return;
+    }
+    buffer->m_Events.append(event);
+    return;
+}
+
+/*
+ * TracerPrivate records the start and the end of each phase of the update
+ * from all the threads of the process. Only a few events are recorded per
+ * phase , So a single mutex is good enough.
+ * Recording is enabled as long as at least one user has acquired the tracer.
+ *
+ * Example:
+ * 	TracerPrivate::acquire();
+ * 	{
+ * 		TraceScope scope("BuildHash");
+ * 		buildHash();
+ * 	}
+ * 	TracerPrivate::save("update.trace.json"); // load it in Perfetto or chrome://tracing.
+ * 	TracerPrivate::release();
+*/
+void TracerPrivate::acquire(void)
+{
+    auto buffer = traceBuffer();
+    QMutexLocker locker(&buffer->m_Mutex);
+    if(!buffer->m_Clock.isValid()) {
+        buffer->m_Clock.start();
+    }
+    buffer->n_Users.ref();
+    return;
+}
+
+/* Stops recording and drops all events once the last user is gone. */
+void TracerPrivate::release(void)
+{
+    auto buffer = traceBuffer();
+    QMutexLocker locker(&buffer->m_Mutex);
+    if(buffer->n_Users.loadAcquire() <= 0) {
+        return;
+    }
+    if(!buffer->n_Users.deref()) {
+        buffer->m_Events.clear();
+        buffer->m_Events.squeeze();
+    }
+    return;
+}
+
+bool TracerPrivate::isEnabled(void)
+{
+    return traceBuffer()->n_Users.loadAcquire() > 0;
+}
+
+/* Microseconds since the tracer was first acquired. */
+qint64 TracerPrivate::now(void)
+{
+    return traceBuffer()->m_Clock.nsecsElapsed() / 1000;
+}
+
+void TracerPrivate::complete(const char *name, qint64 start, const QJsonObject &args)
+{
+    if(!isEnabled()) {
+        return;
+    }
+    TraceEvent event;
+    event.p_Name = name;
+    event.c_Phase = 'X';
+    event.n_Timestamp = start;
+    event.n_Duration = now() - start;
+    event.j_Arguments = args;
+    record(event);
+    return;
+}
+
+/*
+ * Async events are for phases which start and end in different slots ,
+ * like a network request. The id pairs the begin with the end.
+*/
+void TracerPrivate::asyncBegin(const char *name, const void *id, const QJsonObject &args)
+{
+    if(!isEnabled()) {
+        return;
+    }
+    TraceEvent event;
+    event.p_Name = name;
+    event.c_Phase = 'b';
+    event.n_Timestamp = now();
+    event.n_Id = reinterpret_cast<quintptr>(id);
+    event.j_Arguments = args;
+    record(event);
+    return;
+}
+
+void TracerPrivate::asyncEnd(const char *name, const void *id)
+{
+    if(!isEnabled()) {
+        return;
+    }
+    TraceEvent event;
+    event.p_Name = name;
+    event.c_Phase = 'e';
+    event.n_Timestamp = now();
+    event.n_Id = reinterpret_cast<quintptr>(id);
+    record(event);
+    return;
+}
+
+/*
+ * Writes all the events recorded so far in the Chrome trace event format ,
+ * Returns false if the file cannot be written.
+*/
+bool TracerPrivate::save(const QString &path)
+{
+    auto buffer = traceBuffer();
+    QVector<TraceEvent> events;
+    {
+        QMutexLocker locker(&buffer->m_Mutex);
+        events = buffer->m_Events;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray traceEvents;
+    traceEvents.append(QJsonObject {
+        { "name", "process_name" },
+        { "ph", "M" },
+        { "pid", static_cast<double>(pid) },
+        { "args", QJsonObject { { "name", "AppImageUpdaterBridge" } } }
+    });
+    for(auto iter = events.constBegin(), end = events.constEnd(); iter != end; ++iter) {
+        QJsonObject event {
+            { "name", QString::fromUtf8((*iter).p_Name) },
+            { "cat", "AppImageUpdaterBridge" },
+            { "ph", QString(QChar((*iter).c_Phase)) },
+            { "ts", static_cast<double>((*iter).n_Timestamp) },
+            { "pid", static_cast<double>(pid) },
+            { "tid", static_cast<double>((*iter).n_ThreadId) }
+        };
+        if((*iter).c_Phase == 'X') {
+            event.insert("dur", static_cast<double>((*iter).n_Duration));
+        } else {
+            event.insert("id", QString::fromLatin1("0x") + QString::number((*iter).n_Id, 16));
+        }
+        if(!(*iter).j_Arguments.isEmpty()) {
+            event.insert("args", (*iter).j_Arguments);
+        }
+        traceEvents.append(event);
+    }
+
+    QJsonObject trace {
+        { "traceEvents", traceEvents },
+        { "displayTimeUnit", "ms" }
+    };
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+TraceScope::TraceScope(const char *name, const QJsonObject &args)
+{
+    if(!TracerPrivate::isEnabled()) {
+        return;
+    }
+    p_Name = name;
+    j_Arguments = args;
+    n_Start = TracerPrivate::now();
+    return;
+}
+
+TraceScope::~TraceScope()
+{
+    if(n_Start < 0) {
+        return;
+    }
+    TracerPrivate::complete(p_Name, n_Start, j_Arguments);
+    return;
+}
@@ -31,48 +31,158 @@
  *
  * @filename    : zsyncblockrangedownloader_p.cc
  * @description : This the main class which manages all block requests and reply
- * also emits the progress overall , This is where the class is implemented.
+ * also counts the progress overall , This is where the class is implemented.
 */
 #include "../include/zsyncblockrangedownloader_p.hpp"
 #include "../include/zsyncblockrangereply_p.hpp"
 #include "../include/zsyncremotecontrolfileparser_p.hpp"
+#include "../include/zsyncrequestlimiter_p.hpp"
 #include "../include/zsyncwriter_p.hpp"
 
+#ifndef QT_NO_SSL
+#include <QSslConfiguration>
+#endif // QT_NO_SSL
+
 using namespace AppImageUpdaterBridge;
 
+/* Upper bound of block range bytes requested but not yet written. */
+static const qint64 MaxPendingWriteBytes = 33554432; /* 32 MiB. */
+
+/*
+ * Connections opened to the target host while the writer scans its seed files ,
+ * QNetworkAccessManager uses at most six connections per host.
+*/
+static const int PreConnectCount = 4;
+
+/* Size of a block range as accounted for the pending write bytes. */
+static inline qint64 blockRangeBytes(qint32 fromRange, qint32 toRange)
+{
+    return static_cast<qint64>(toRange) - static_cast<qint64>(fromRange);
+}
+
 /*
  * This is the main class which manages the block downloads for ZsyncWriterPrivate ,
- * This class provides progress overall and also gives the control to cancel the download
+ * This class counts the progress overall and also gives the control to cancel the download
  * anytime without any kind of data races.
+ *
+ * An optional ZsyncRequestLimiterPrivate can be given which is shared with other
+ * downloaders , in that case block ranges are queued and only sent when the limiter
+ * hands a free slot to us.
+ *
+ * The writer may publish ranges while it still scans seed files , So every
+ * range is checked against the known blocks of the writer right before it is
+ * requested and the download is only finished after endOfBlockRanges.
 */
-ZsyncBlockRangeDownloaderPrivate::ZsyncBlockRangeDownloaderPrivate(ZsyncWriterPrivate *w, QNetworkAccessManager *nm)
+ZsyncBlockRangeDownloaderPrivate::ZsyncBlockRangeDownloaderPrivate(ZsyncWriterPrivate *w, QNetworkAccessManager *nm,
+        ZsyncRequestLimiterPrivate *limiter)
     : QObject(),
       p_Manager(nm),
-      p_Writer(w)
+      p_Writer(w),
+      p_Limiter(limiter)
 {
+    n_MaxPendingWriteBytes = MaxPendingWriteBytes;
+    p_KnownBlocks = p_Writer->knownBlocks();
 
     connect(p_Writer, SIGNAL(download(qint64, qint64, QUrl)),
             this, SLOT(initDownloader(qint64, qint64, QUrl)), Qt::QueuedConnection);
+    connect(p_Writer, SIGNAL(seedScanStarted(QUrl)),
+            this, SLOT(preConnect(QUrl)), Qt::QueuedConnection);
     connect(p_Writer, SIGNAL(blockRange(qint32, qint32)),
             this, SLOT(handleBlockRange(qint32, qint32)),Qt::QueuedConnection);
+    connect(p_Writer, SIGNAL(endOfBlockRanges()),
+            this, SLOT(handleEndOfBlockRanges()), Qt::QueuedConnection);
     connect(this, SIGNAL(blockRangesRequested()),
             p_Writer, SLOT(getBlockRanges()), Qt::QueuedConnection);
+    connect(p_Writer, SIGNAL(blockRangeWritten(qint32, qint32)),
+            this, SLOT(handleBlockRangeWritten(qint32, qint32)), Qt::QueuedConnection);
     return;
 }
 
 ZsyncBlockRangeDownloaderPrivate::~ZsyncBlockRangeDownloaderPrivate()
 {
+    if(p_Limiter) {
+        p_Limiter->removeWaiter(this);
+    }
+    return;
+}
+
+/* The received bytes of all replies are added to the given aggregator. */
+void ZsyncBlockRangeDownloaderPrivate::setProgressAggregator(QSharedPointer<ZsyncProgressAggregatorPrivate> aggregator)
+{
+    p_Progress = aggregator;
+    return;
+}
+
+/*
+ * Sets how many bytes may be requested but not yet written by the writer ,
+ * A single range larger than this is still requested when nothing is pending.
+*/
+void ZsyncBlockRangeDownloaderPrivate::setMaxPendingWriteBytes(qint64 bytes)
+{
+    n_MaxPendingWriteBytes = bytes > 0 ? bytes : MaxPendingWriteBytes;
     return;
 }
 
 /* Cancels all ZsyncBlockRangeReplyPrivate QObjects. */
 void ZsyncBlockRangeDownloaderPrivate::cancel(void)
 {
+    bool idle = (n_BlockReply <= 0 && b_Active);
+    m_PendingRanges.clear();
+    if(p_Limiter) {
+        p_Limiter->removeWaiter(this);
+    }
     b_CancelRequested = true;
+
+    /* Nothing is in flight , so no reply will ever report the cancel. */
+    if(idle) {
+        b_CancelRequested = b_Active = false;
+        connect(p_Writer, SIGNAL(download(qint64, qint64, QUrl)),
+                this, SLOT(initDownloader(qint64, qint64, QUrl)), (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
+        emit canceled();
+        return;
+    }
     emit cancelAllReply();
     return;
 }
 
+/*
+ * Opens connections to the target host while the writer still scans its seed
+ * files , so that the first range requests do not wait for the TCP and TLS
+ * handshakes. The QNetworkAccessManager keeps them and hands them to the
+ * requests for the same host , scheme and port.
+ *
+ * Https connections are not warmed with Qt 5.10 to 5.12 , These versions
+ * cannot offer HTTP/2 with ALPN here , so the HTTP/2 allowed range requests
+ * would not reuse them and the handshakes would be wasted.
+*/
+void ZsyncBlockRangeDownloaderPrivate::preConnect(QUrl targetFileUrl)
+{
+    if(b_Active || !p_Manager || targetFileUrl.host().isEmpty()) {
+        return;
+    }
+
+    auto scheme = targetFileUrl.scheme().toLower();
+    for(int i = 0; i < PreConnectCount; ++i) {
+        if(scheme == "https") {
+#ifndef QT_NO_SSL
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+            /* Offer HTTP/2 too , else the range requests could not reuse this connection. */
+            auto sslConfiguration = QSslConfiguration::defaultConfiguration();
+            sslConfiguration.setAllowedNextProtocols(QList<QByteArray>()
+                    << QSslConfiguration::ALPNProtocolHTTP2
+                    << QSslConfiguration::NextProtocolHttp1_1);
+            p_Manager->connectToHostEncrypted(targetFileUrl.host(), targetFileUrl.port(443), sslConfiguration);
+#elif QT_VERSION < QT_VERSION_CHECK(5, 10, 0)
+            p_Manager->connectToHostEncrypted(targetFileUrl.host(), targetFileUrl.port(443));
+#endif // QT_VERSION >= 5.13
+#endif // QT_NO_SSL
+        } else if(scheme == "http") {
+            p_Manager->connectToHost(targetFileUrl.host(), targetFileUrl.port(80));
+        }
+    }
+    return;
+}
+
 /* Starts the download of all the required blocks. */
 void ZsyncBlockRangeDownloaderPrivate::initDownloader(qint64 bytesReceived, qint64 bytesTotal, QUrl targetFileUrl)
 {
@@ -80,11 +190,16 @@ void ZsyncBlockRangeDownloaderPrivate::initDownloader(qint64 bytesReceived, qint
                this, SLOT(initDownloader(qint64, qint64, QUrl)));
 
     u_TargetFileUrl = targetFileUrl;
-    n_BytesTotal = bytesTotal;
-    n_BytesReceived = bytesReceived;
+    if(p_Progress) {
+        p_Progress->begin(bytesReceived, bytesTotal);
+    }
     b_Errored = false;
     b_CancelRequested = false;
+    b_Active = true;
+    b_EndOfRanges = false;
     n_BlockReply = 0;
+    n_PendingWriteBytes = 0;
+    m_PendingRanges.clear();
 
     /*
      * Start the download , if the host cannot accept range requests then
@@ -95,10 +210,92 @@ void ZsyncBlockRangeDownloaderPrivate::initDownloader(qint64 bytesReceived, qint
     return;
 }
 
-/* This is connected to the blockRange signal of ZsyncWriterPrivate and starts the
- * download of a new block range.
+/* This is connected to the blockRange signal of ZsyncWriterPrivate and queues
+ * the download of a new block range.
 */
 void ZsyncBlockRangeDownloaderPrivate::handleBlockRange(qint32 fromRange, qint32 toRange)
+{
+    if(b_CancelRequested || b_Errored) {
+        return;
+    }
+    m_PendingRanges.append(qMakePair(fromRange, toRange));
+    requestPendingRanges();
+    return;
+}
+
+/* The writer has published every range , the download finishes once they are done. */
+void ZsyncBlockRangeDownloaderPrivate::handleEndOfBlockRanges(void)
+{
+    if(!b_Active) {
+        return;
+    }
+    b_EndOfRanges = true;
+    finishIfDone();
+    return;
+}
+
+/* Sends as many queued block ranges as the limiter and the pending write bytes
+ * allow. When the writer falls behind , no new ranges are requested until it
+ * catches up , at least one range is always allowed so that a single range
+ * larger than the bound still gets downloaded.
+*/
+/*
+ * Called by the limiter when it handed a free slot to us , the slot is given
+ * back if we have nothing to send anymore.
+*/
+void ZsyncBlockRangeDownloaderPrivate::handleRequestSlot(void)
+{
+    requestPendingRanges();
+    p_Limiter->releaseUnclaimed(this);
+    return;
+}
+
+void ZsyncBlockRangeDownloaderPrivate::requestPendingRanges(void)
+{
+    while(!m_PendingRanges.isEmpty() && !b_CancelRequested && !b_Errored) {
+        auto range = m_PendingRanges.first();
+
+        /* Blocks found by the seed scan since the range was published. */
+        if(p_KnownBlocks && !p_KnownBlocks->trim(&range.first, &range.second)) {
+            m_PendingRanges.removeFirst();
+            continue;
+        }
+        qint64 bytes = blockRangeBytes(range.first, range.second);
+        if(n_PendingWriteBytes > 0 && n_PendingWriteBytes + bytes > n_MaxPendingWriteBytes) {
+            break;
+        }
+        if(p_Limiter && !p_Limiter->tryAcquire(this, "handleRequestSlot")) {
+            break;
+        }
+        m_PendingRanges.removeFirst();
+        n_PendingWriteBytes += bytes;
+        requestBlockRange(range.first, range.second);
+    }
+    finishIfDone();
+    return;
+}
+
+/* The writer is done with a range , so more ranges can be requested. */
+void ZsyncBlockRangeDownloaderPrivate::handleBlockRangeWritten(qint32 fromRange, qint32 toRange)
+{
+    n_PendingWriteBytes -= blockRangeBytes(fromRange, toRange);
+    if(n_PendingWriteBytes < 0) {
+        n_PendingWriteBytes = 0;
+    }
+    requestPendingRanges();
+    return;
+}
+
+/* Gives back the request slot of a reply which is done. */
+void ZsyncBlockRangeDownloaderPrivate::releaseRequestSlot(void)
+{
+    if(p_Limiter) {
+        p_Limiter->release();
+    }
+    return;
+}
+
+void ZsyncBlockRangeDownloaderPrivate::requestBlockRange(qint32 fromRange, qint32 toRange)
 {
     QNetworkRequest request;
     request.setUrl(u_TargetFileUrl);
@@ -109,10 +306,17 @@ void ZsyncBlockRangeDownloaderPrivate::handleBlockRange(qint32 fromRange, qint32
     }
     request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
     request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    /*
+     * Multiplexes all range requests over a single connection if the server
+     * negotiates HTTP/2 , otherwise the pipelined HTTP/1.1 connections are used.
+    */
+    request.setAttribute(QNetworkRequest::HTTP2AllowedAttribute, true);
+#endif // QT_VERSION >= 5.10
 
     ++n_BlockReply;
 
-    auto blockReply = new ZsyncBlockRangeReplyPrivate(p_Writer, p_Manager->get(request), fromRange, toRange);
+    auto blockReply = new ZsyncBlockRangeReplyPrivate(p_Writer, p_Manager->get(request), fromRange, toRange, p_Progress);
     connect(this, &ZsyncBlockRangeDownloaderPrivate::cancelAllReply,
             blockReply, &ZsyncBlockRangeReplyPrivate::cancel);
     connect(blockReply, &ZsyncBlockRangeReplyPrivate::canceled,
@@ -124,28 +328,6 @@ void ZsyncBlockRangeDownloaderPrivate::handleBlockRange(qint32 fromRange, qint32
     connect(blockReply, &ZsyncBlockRangeReplyPrivate::error,
             this, &ZsyncBlockRangeDownloaderPrivate::handleBlockReplyError,
             Qt::QueuedConnection);
-    if(!(fromRange || toRange)) {
-        connect(blockReply, &ZsyncBlockRangeReplyPrivate::seqProgress,
-                this, &ZsyncBlockRangeDownloaderPrivate::progress, Qt::DirectConnection);
-    } else {
-        connect(blockReply, &ZsyncBlockRangeReplyPrivate::progress,
-                this, &ZsyncBlockRangeDownloaderPrivate::handleBlockReplyProgress,
-                Qt::QueuedConnection);
-    }
-    return;
-}
-
-/* Calculates the overall progress and also emits it when done. */
-void ZsyncBlockRangeDownloaderPrivate::handleBlockReplyProgress(qint64 bytesReceived, double speed, QString units)
-{
-    n_BytesReceived += bytesReceived;
-    int nPercentage = static_cast<int>(
-                          (static_cast<float>
-                           (n_BytesReceived) * 100.0
-                          ) / static_cast<float>
-                          (n_BytesTotal)
-                      );
-    emit progress(nPercentage, n_BytesReceived, n_BytesTotal, speed, units);
     return;
 }
 
@@ -153,28 +335,40 @@ void ZsyncBlockRangeDownloaderPrivate::handleBlockReplyProgress(qint64 bytesRece
 void ZsyncBlockRangeDownloaderPrivate::handleBlockReplyFinished(void)
 {
     --n_BlockReply;
+    releaseRequestSlot();
+    finishIfDone();
+    return;
+}
 
-    if(n_BlockReply <= 0) {
-        if(b_CancelRequested == true) {
-            b_CancelRequested = false;
-            connect(p_Writer, SIGNAL(download(qint64, qint64, QUrl)),
-                    this, SLOT(initDownloader(qint64, qint64, QUrl)), (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
-            emit canceled();
-        } else {
-            connect(p_Writer, SIGNAL(download(qint64, qint64, QUrl)),
-                    this, SLOT(initDownloader(qint64, qint64, QUrl)), (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
-            emit finished();
-        }
+/* Finishes the download if nothing is in flight or queued and no more ranges will come. */
+void ZsyncBlockRangeDownloaderPrivate::finishIfDone(void)
+{
+    if(!b_Active || n_BlockReply > 0 || !m_PendingRanges.isEmpty()) {
+        return;
+    }
+    if(b_CancelRequested == true) {
+        b_CancelRequested = b_Active = false;
+        connect(p_Writer, SIGNAL(download(qint64, qint64, QUrl)),
+                this, SLOT(initDownloader(qint64, qint64, QUrl)), (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
+        emit canceled();
+    } else if(b_EndOfRanges) {
+        b_Active = false;
+        connect(p_Writer, SIGNAL(download(qint64, qint64, QUrl)),
+                this, SLOT(initDownloader(qint64, qint64, QUrl)), (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
+        emit finished();
     }
     return;
 }
 
 void ZsyncBlockRangeDownloaderPrivate::handleBlockReplyError(QNetworkReply::NetworkError errorCode)
 {
+    releaseRequestSlot();
     if(b_Errored == true) {
         return;
     }
     b_Errored = true;
+    b_Active = false;
+    m_PendingRanges.clear();
     short e = 0;
     if(errorCode > 0 && errorCode < 101) {
         e = ConnectionRefusedError + ((short)errorCode - 1);
@@ -212,9 +406,10 @@ void ZsyncBlockRangeDownloaderPrivate::handleBlockReplyCancel(void)
     blockReply->deleteLater();
 
     --n_BlockReply;
+    releaseRequestSlot();
 
     if(n_BlockReply <= 0) {
-        b_CancelRequested = false;
+        b_CancelRequested = b_Active = false;
         connect(p_Writer, SIGNAL(download(qint64, qint64, QUrl)),
                 this, SLOT(initDownloader(qint64, qint64, QUrl)), (Qt::ConnectionType)(Qt::QueuedConnection | Qt::UniqueConnection));
         emit canceled();
@@ -38,18 +38,26 @@
 */
 #include "../include/zsyncblockrangereply_p.hpp"
 #include "../include/zsyncwriter_p.hpp"
+#include "../include/tracer_p.hpp"
 
 using namespace AppImageUpdaterBridge;
 
 ZsyncBlockRangeReplyPrivate::ZsyncBlockRangeReplyPrivate(ZsyncWriterPrivate *deltaWriter,
         QNetworkReply *reply,
         qint32 rangeFrom,
-        qint32 rangeTo)
+        qint32 rangeTo,
+        QSharedPointer<ZsyncProgressAggregatorPrivate> progress)
     : QObject(reply),
+      p_Progress(progress),
       n_RangeFrom(rangeFrom),
       n_RangeTo(rangeTo)
 {
-    downloadSpeed.start();
+    TracerPrivate::asyncBegin("RangeRequest", this, QJsonObject {
+        { "From", n_RangeFrom },
+        { "To", n_RangeTo }
+    });
+    /* Time until the first byte , shows whether the request waited for a handshake. */
+    TracerPrivate::asyncBegin("FirstByte", this);
     p_RawData.reset(new QByteArray);
     connect(reply, SIGNAL(error(QNetworkReply::NetworkError)),
             this, SLOT(handleError(QNetworkReply::NetworkError)));
@@ -77,6 +85,10 @@ ZsyncBlockRangeReplyPrivate::ZsyncBlockRangeReplyPrivate(ZsyncWriterPrivate *del
 
 ZsyncBlockRangeReplyPrivate::~ZsyncBlockRangeReplyPrivate()
 {
+    if(!b_FirstByteReceived) {
+        TracerPrivate::asyncEnd("FirstByte", this);
+    }
+    TracerPrivate::asyncEnd("RangeRequest", this);
     return;
 }
 
@@ -118,7 +130,12 @@ void ZsyncBlockRangeReplyPrivate::handleError(QNetworkReply::NetworkError ecode)
 
 void ZsyncBlockRangeReplyPrivate::handleSeqProgress(qint64 bytesReceived, qint64 bytesTotal)
 {
+    Q_UNUSED(bytesTotal);
     auto reply = (QNetworkReply*)QObject::sender();
+    if(!b_FirstByteReceived && bytesReceived > 0) {
+        b_FirstByteReceived = true;
+        TracerPrivate::asyncEnd("FirstByte", this);
+    }
 
     if(!reply->isReadable()) {
         return;
@@ -131,25 +148,9 @@ void ZsyncBlockRangeReplyPrivate::handleSeqProgress(qint64 bytesReceived, qint64
     */
     emit sendData(data);
 
-    int nPercentage = static_cast<int>(
-                          (static_cast<float>
-                           (bytesReceived) * 100.0
-                          ) / static_cast<float>
-                          (bytesTotal)
-                      );
-
-    QString sUnit;
-    double nSpeed =  bytesReceived * 1000.0 / downloadSpeed.elapsed();
-    if (nSpeed < 1024) {
-        sUnit = "bytes/sec";
-    } else if (nSpeed < 1024 * 1024) {
-        nSpeed /= 1024;
-        sUnit = "kB/s";
-    } else {
-        nSpeed /= 1024 * 1024;
-        sUnit = "MB/s";
+    if(p_Progress) {
+        p_Progress->setBytes(bytesReceived);
     }
-    emit seqProgress(nPercentage, bytesReceived, bytesTotal, nSpeed, sUnit);
     return;
 }
 
@@ -157,6 +158,10 @@ void ZsyncBlockRangeReplyPrivate::handleProgress(qint64 bytesReceived, qint64 by
 {
     Q_UNUSED(bytesTotal);
     auto reply = (QNetworkReply*)QObject::sender();
+    if(!b_FirstByteReceived && bytesReceived > 0) {
+        b_FirstByteReceived = true;
+        TracerPrivate::asyncEnd("FirstByte", this);
+    }
     if(!reply->isReadable()) {
         return;
     }
@@ -166,18 +171,8 @@ void ZsyncBlockRangeReplyPrivate::handleProgress(qint64 bytesReceived, qint64 by
 
     p_RawData->append(reply->readAll());
 
-    QString sUnit;
-    double nSpeed =  bytesReceived * 1000.0 / downloadSpeed.elapsed();
-    if (nSpeed < 1024) {
-        sUnit = "bytes/sec";
-    } else if (nSpeed < 1024 * 1024) {
-        nSpeed /= 1024;
-        sUnit = "kB/s";
-    } else {
-        nSpeed /= 1024 * 1024;
-        sUnit = "MB/s";
+    if(p_Progress) {
+        p_Progress->addBytes(nowReceived);
     }
-    emit progress(nowReceived, nSpeed, sUnit);
     return;
 }
-
@@ -0,0 +1,463 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncblockstore_p.cc
+ * @description : This is where the local block store is implemented.
+*/
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QWeakPointer>
+#include <cstring>
+
+#include "../include/zsyncblockstore_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+static constexpr quint32 BlockStoreMagic = 0x41494253; /* "AIBS" */
+static constexpr quint32 BlockStoreVersion = 2;
+static constexpr int BlockStoreLockTimeout = 10000; /* In milliseconds. */
+
+/* Only the most recently written files of a cache directory are kept. */
+static constexpr int MaxCacheDirectoryFiles = 64;
+
+/*
+ * ZsyncBlockStorePrivate keeps verified blocks of completed updates in a few
+ * pack files , one per block size , and indexes them by their rsum and MD4
+ * checksum. Many AppImages bundle the same libraries , So a delta writer can
+ * take blocks from here instead of downloading them again.
+ *
+ * The pack files never grow beyond the given size , When the store is full
+ * the least recently used block of the same block size is replaced.
+ * A store is shared by everyone who opens the same directory , even in other
+ * processes. lookup() and insert() must be called while the store is locked ,
+ * which serializes them across threads and processes.
+ *
+ * Example:
+ * 	auto store = ZsyncBlockStorePrivate::open(QDir::homePath() + "/.cache/blocks", 256 * 1024 * 1024);
+ * 	QByteArray block;
+ * 	ZsyncBlockStoreLocker locker(store.data());
+ * 	if(locker.isLocked() && store->lookup(blockSize, r, mask, checksum, checksumBytes, &block)) {
+ * 		// use the block.
+ * 	}
+*/
+QSharedPointer<ZsyncBlockStorePrivate> ZsyncBlockStorePrivate::open(const QString &directory, qint64 maxSize)
+{
+    static QMutex storesMutex;
+    static QHash<QString, QWeakPointer<ZsyncBlockStorePrivate>> stores;
+
+    if(directory.isEmpty() || maxSize <= 0) {
+        return QSharedPointer<ZsyncBlockStorePrivate>();
+    }
+    QString path = QFileInfo(directory).absoluteFilePath();
+    if(!QDir().mkpath(path) || !QFileInfo(path).isWritable()) {
+        return QSharedPointer<ZsyncBlockStorePrivate>();
+    }
+
+    QMutexLocker locker(&storesMutex);
+    QSharedPointer<ZsyncBlockStorePrivate> store = stores.value(path).toStrongRef();
+    if(store.isNull()) {
+        store = QSharedPointer<ZsyncBlockStorePrivate>(new ZsyncBlockStorePrivate(path, maxSize));
+        stores.insert(path, store.toWeakRef());
+    } else {
+        store->setMaxSize(maxSize);
+    }
+    return store;
+}
+
+ZsyncBlockStorePrivate::ZsyncBlockStorePrivate(const QString &directory, qint64 maxSize)
+    : m_LockFile(directory + "/blocks.lock"),
+      s_Directory(directory),
+      n_MaxSize(maxSize)
+{
+    return;
+}
+
+ZsyncBlockStorePrivate::~ZsyncBlockStorePrivate()
+{
+    return;
+}
+
+QString ZsyncBlockStorePrivate::directory(void) const
+{
+    return s_Directory;
+}
+
+/*
+ * Removes all but the most recently written files matching the given filter
+ * from the given cache directory , Seeds and versions which are long gone
+ * leave their files behind.
+ *
+ * Example:
+ * 	ZsyncBlockStorePrivate::pruneDirectory(store->directory() + "/seedindex", "*.index");
+*/
+void ZsyncBlockStorePrivate::pruneDirectory(const QString &directory, const QString &filter)
+{
+    auto files = QDir(directory).entryInfoList(QStringList() << filter, QDir::Files, QDir::Time);
+    for(int i = MaxCacheDirectoryFiles; i < files.size(); ++i) {
+        QFile::remove(files.at(i).absoluteFilePath());
+    }
+    return;
+}
+
+void ZsyncBlockStorePrivate::setMaxSize(qint64 maxSize)
+{
+    QMutexLocker locker(&m_Mutex);
+    n_MaxSize = maxSize;
+    return;
+}
+
+/*
+ * Locks the store for this thread and every other process , The index is
+ * loaded again if another process wrote it since the last lock.
+ * Returns false if the lock could not be taken in time.
+*/
+bool ZsyncBlockStorePrivate::lock(void)
+{
+    m_Mutex.lock();
+    if(!m_LockFile.tryLock(BlockStoreLockTimeout)) {
+        m_Mutex.unlock();
+        return false;
+    }
+    if(storedGeneration() != n_Generation) {
+        load();
+    }
+    return true;
+}
+
+/*
+ * Writes the index if anything was inserted or replaced and flushes the pack
+ * files , So the next process to lock the store sees every change.
+*/
+void ZsyncBlockStorePrivate::unlock(void)
+{
+    sync();
+    m_LockFile.unlock();
+    m_Mutex.unlock();
+    return;
+}
+
+/*
+ * Finds a block with the given checksums , The weak checksum and the
+ * strong checksum prefix are compared the same way as in the zsync control
+ * file , So the caller should still verify the block. The store must be
+ * locked.
+ * Returns true and fills block if found.
+*/
+bool ZsyncBlockStorePrivate::lookup(qint32 blockSize, rsum weakCheckSum, unsigned short weakCheckSumMask,
+                                    const unsigned char *strongCheckSum, qint32 strongCheckSumBytes, QByteArray *block)
+{
+    if(!block || !strongCheckSum || strongCheckSumBytes > CHECKSUM_SIZE) {
+        return false;
+    }
+
+    auto key = indexKey(blockSize, weakCheckSum.b);
+    for(auto iter = m_Index.find(key); iter != m_Index.end() && iter.key() == key; ++iter) {
+        const Entry &entry = m_Entries[iter.value()];
+        if(entry.n_BlockSize != blockSize ||
+           (entry.m_WeakCheckSum.a & weakCheckSumMask) != weakCheckSum.a ||
+           memcmp(entry.p_StrongCheckSum, strongCheckSum, strongCheckSumBytes) != 0) {
+            continue;
+        }
+
+        QFile *pack = packFile(blockSize);
+        if(!pack || !pack->seek(entry.n_Slot * blockSize)) {
+            return false;
+        }
+        *block = pack->read(blockSize);
+        if(block->size() != blockSize) {
+            block->clear();
+            return false;
+        }
+        touch(iter.value());
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Adds a verified block , strongCheckSum has to be the complete MD4
+ * checksum of the block. Nothing is done if the block is already known
+ * or if there is no room for it. The store must be locked.
+*/
+void ZsyncBlockStorePrivate::insert(qint32 blockSize, rsum weakCheckSum, const unsigned char *strongCheckSum,
+                                    const char *block)
+{
+    if(!block || !strongCheckSum || blockSize <= 0) {
+        return;
+    }
+
+    auto key = indexKey(blockSize, weakCheckSum.b);
+    for(auto iter = m_Index.find(key); iter != m_Index.end() && iter.key() == key; ++iter) {
+        const Entry &entry = m_Entries[iter.value()];
+        if(entry.n_BlockSize == blockSize &&
+           entry.m_WeakCheckSum.a == weakCheckSum.a &&
+           memcmp(entry.p_StrongCheckSum, strongCheckSum, CHECKSUM_SIZE) == 0) {
+            touch(iter.value());
+            return;
+        }
+    }
+
+    QFile *pack = packFile(blockSize);
+    qint64 slot = 0;
+    if(!pack || !takeSlot(blockSize, &slot)) {
+        return;
+    }
+    if(!pack->seek(slot * blockSize) || pack->write(block, blockSize) != blockSize) {
+        m_FreeSlots[blockSize].append(slot);
+        return;
+    }
+
+    Entry entry;
+    entry.n_BlockSize = blockSize;
+    entry.m_WeakCheckSum = weakCheckSum;
+    memcpy(entry.p_StrongCheckSum, strongCheckSum, CHECKSUM_SIZE);
+    entry.n_Slot = slot;
+
+    auto id = n_NextId++;
+    m_Entries.insert(id, entry);
+    m_Index.insert(key, id);
+    touch(id);
+    b_Dirty = true;
+    return;
+}
+
+/* Writes the index with the next generation , called with the store locked. */
+void ZsyncBlockStorePrivate::sync(void)
+{
+    if(!b_Dirty) {
+        return;
+    }
+    for(auto iter = m_PackFiles.constBegin(), end = m_PackFiles.constEnd(); iter != end; ++iter) {
+        (*iter)->flush();
+    }
+
+    QSaveFile index(s_Directory + "/blocks.index");
+    if(!index.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&index);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << BlockStoreMagic << BlockStoreVersion << (n_Generation + 1);
+    stream << static_cast<quint32>(m_SlotCount.size());
+    for(auto iter = m_SlotCount.constBegin(), end = m_SlotCount.constEnd(); iter != end; ++iter) {
+        stream << iter.key() << iter.value();
+    }
+    stream << static_cast<quint32>(m_Entries.size());
+    for(auto iter = m_Entries.constBegin(), end = m_Entries.constEnd(); iter != end; ++iter) {
+        const Entry &entry = iter.value();
+        stream << entry.n_BlockSize
+               << static_cast<quint16>(entry.m_WeakCheckSum.a)
+               << static_cast<quint16>(entry.m_WeakCheckSum.b)
+               << entry.n_Slot
+               << entry.n_LastUse;
+        stream.writeRawData(reinterpret_cast<const char*>(entry.p_StrongCheckSum), CHECKSUM_SIZE);
+    }
+    if(stream.status() == QDataStream::Ok && index.commit()) {
+        ++n_Generation;
+        b_Dirty = false;
+    }
+    return;
+}
+
+/* Reads the generation of the index on the disk , 0 if there is none. */
+quint64 ZsyncBlockStorePrivate::storedGeneration(void) const
+{
+    QFile index(s_Directory + "/blocks.index");
+    if(!index.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    QDataStream stream(&index);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0, version = 0;
+    quint64 generation = 0;
+    stream >> magic >> version >> generation;
+    if(stream.status() != QDataStream::Ok || magic != BlockStoreMagic || version != BlockStoreVersion) {
+        return 0;
+    }
+    return generation;
+}
+
+/*
+ * Reads the index written by sync , Whatever was loaded before is dropped.
+ * A broken index just starts a empty store.
+*/
+void ZsyncBlockStorePrivate::load(void)
+{
+    n_PackSize = 0;
+    n_NextId = n_UseCounter = n_Generation = 0;
+    b_Dirty = false;
+    m_Entries.clear();
+    m_Index.clear();
+    m_LeastRecentlyUsed.clear();
+    m_SlotCount.clear();
+    m_FreeSlots.clear();
+
+    QFile index(s_Directory + "/blocks.index");
+    if(!index.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&index);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0, version = 0, count = 0;
+    quint64 generation = 0;
+    stream >> magic >> version >> generation;
+    if(magic != BlockStoreMagic || version != BlockStoreVersion) {
+        return;
+    }
+    n_Generation = generation;
+
+    stream >> count;
+    for(quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        qint32 blockSize = 0;
+        qint64 slots = 0;
+        stream >> blockSize >> slots;
+        if(blockSize > 0 && slots > 0) {
+            m_SlotCount.insert(blockSize, slots);
+            n_PackSize += blockSize * slots;
+        }
+    }
+
+    QHash<qint32, QVector<bool>> usedSlots;
+    stream >> count;
+    for(quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        Entry entry;
+        quint16 a = 0, b = 0; /* rsum is packed , can't read into it directly. */
+        stream >> entry.n_BlockSize
+               >> a
+               >> b
+               >> entry.n_Slot
+               >> entry.n_LastUse;
+        entry.m_WeakCheckSum.a = a;
+        entry.m_WeakCheckSum.b = b;
+        if(stream.readRawData(reinterpret_cast<char*>(entry.p_StrongCheckSum), CHECKSUM_SIZE) != CHECKSUM_SIZE) {
+            break;
+        }
+        auto slots = m_SlotCount.value(entry.n_BlockSize);
+        auto &used = usedSlots[entry.n_BlockSize];
+        used.resize(slots);
+        if(entry.n_Slot < 0 || entry.n_Slot >= slots || used[entry.n_Slot]) {
+            continue;
+        }
+        used[entry.n_Slot] = true;
+
+        auto id = n_NextId++;
+        m_Entries.insert(id, entry);
+        m_Index.insert(indexKey(entry.n_BlockSize, entry.m_WeakCheckSum.b), id);
+        m_LeastRecentlyUsed.insert(entry.n_LastUse, id);
+        n_UseCounter = qMax(n_UseCounter, entry.n_LastUse);
+    }
+
+    for(auto iter = m_SlotCount.constBegin(), end = m_SlotCount.constEnd(); iter != end; ++iter) {
+        auto used = usedSlots.value(iter.key());
+        used.resize(iter.value());
+        for(qint64 slot = 0; slot < iter.value(); ++slot) {
+            if(!used[slot]) {
+                m_FreeSlots[iter.key()].append(slot);
+            }
+        }
+    }
+    return;
+}
+
+quint64 ZsyncBlockStorePrivate::indexKey(qint32 blockSize, unsigned short b)
+{
+    return (static_cast<quint64>(blockSize) << 16) | b;
+}
+
+QFile *ZsyncBlockStorePrivate::packFile(qint32 blockSize)
+{
+    auto pack = m_PackFiles.value(blockSize);
+    if(pack.isNull()) {
+        pack = QSharedPointer<QFile>(new QFile(s_Directory + "/blocks-" + QString::number(blockSize) + ".pack"));
+        /* Unbuffered , Other processes write to the same pack file. */
+        if(!pack->open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+            return nullptr;
+        }
+        m_PackFiles.insert(blockSize, pack);
+    }
+    return pack.data();
+}
+
+/*
+ * Gives a free slot in the pack file of the given block size , the pack
+ * file grows until the maximum size is reached , after that the least
+ * recently used block of the same size is replaced.
+*/
+bool ZsyncBlockStorePrivate::takeSlot(qint32 blockSize, qint64 *slot)
+{
+    auto &freeSlots = m_FreeSlots[blockSize];
+    if(!freeSlots.isEmpty()) {
+        *slot = freeSlots.takeLast();
+        return true;
+    }
+    if(n_PackSize + blockSize <= n_MaxSize) {
+        *slot = m_SlotCount[blockSize]++;
+        n_PackSize += blockSize;
+        return true;
+    }
+
+    for(auto iter = m_LeastRecentlyUsed.constBegin(), end = m_LeastRecentlyUsed.constEnd(); iter != end; ++iter) {
+        if(m_Entries[iter.value()].n_BlockSize == blockSize) {
+            remove(iter.value());
+            *slot = m_FreeSlots[blockSize].takeLast();
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Only the order in memory is changed , It is written along with the next
+ * insert so lookups alone never write the index.
+*/
+void ZsyncBlockStorePrivate::touch(quint64 id)
+{
+    Entry &entry = m_Entries[id];
+    if(entry.n_LastUse) {
+        m_LeastRecentlyUsed.remove(entry.n_LastUse);
+    }
+    entry.n_LastUse = ++n_UseCounter;
+    m_LeastRecentlyUsed.insert(entry.n_LastUse, id);
+    return;
+}
+
+void ZsyncBlockStorePrivate::remove(quint64 id)
+{
+    Entry entry = m_Entries.take(id);
+    m_Index.remove(indexKey(entry.n_BlockSize, entry.m_WeakCheckSum.b), id);
+    m_LeastRecentlyUsed.remove(entry.n_LastUse);
+    m_FreeSlots[entry.n_BlockSize].append(entry.n_Slot);
+    b_Dirty = true;
+    return;
+}
@@ -0,0 +1,109 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncknownblocks_p.cc
+ * @description : This is where the known blocks bitmap is implemented.
+*/
+#include "../include/zsyncknownblocks_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+/*
+ * ZsyncKnownBlocksPrivate is set by the delta writer whenever it has a
+ * target block , while the block range downloader checks it right before
+ * a range is requested. So ranges found by a seed scan which still runs
+ * are not downloaded.
+ *
+ * Only set and contains may be called from different threads , reset is
+ * only called while nothing is downloaded.
+*/
+void ZsyncKnownBlocksPrivate::reset(qint32 blocks, qint32 blockSize, qint64 targetFileLength)
+{
+    n_Blocks = qMax(0, blocks);
+    n_BlockSize = blockSize;
+    n_TargetFileLength = targetFileLength;
+    p_Words.reset(new QAtomicInt[(n_Blocks + 31) / 32]);
+    return;
+}
+
+void ZsyncKnownBlocksPrivate::set(zs_blockid id)
+{
+    if(id < 0 || id >= n_Blocks) {
+        return;
+    }
+    p_Words[id / 32].fetchAndOrOrdered(1 << (id % 32));
+    return;
+}
+
+bool ZsyncKnownBlocksPrivate::contains(zs_blockid id) const
+{
+    if(id < 0 || id >= n_Blocks) {
+        return false;
+    }
+    return p_Words[id / 32].loadAcquire() & (1 << (id % 32));
+}
+
+/*
+ * Drops the known blocks from both ends of the given byte range , which is
+ * a block range as emitted by the delta writer. Returns false if every block
+ * of the range is known.
+ *
+ * Example:
+ * 	qint32 from = 0, to = 4096;
+ * 	if(!knownBlocks->trim(&from, &to)) {
+ * 		// Nothing to download.
+ * 	}
+*/
+bool ZsyncKnownBlocksPrivate::trim(qint32 *from, qint32 *to) const
+{
+    /* The entire file is downloaded sequentially. */
+    if(!n_Blocks || n_BlockSize <= 0 || (!*from && !*to)) {
+        return true;
+    }
+
+    bool toEnd = (*to >= n_TargetFileLength);
+    zs_blockid first = *from / n_BlockSize,
+               last = toEnd ? n_Blocks - 1 : (*to - n_BlockSize) / n_BlockSize;
+    while(first <= last && contains(first)) {
+        ++first;
+    }
+    while(last >= first && contains(last)) {
+        --last;
+        toEnd = false;
+    }
+    if(first > last) {
+        return false;
+    }
+
+    *from = first * n_BlockSize;
+    *to = toEnd ? static_cast<qint32>(n_TargetFileLength) : last * n_BlockSize + n_BlockSize;
+    return true;
+}
@@ -0,0 +1,205 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncmatchcache_p.cc
+ * @description : This is where the match cache is implemented.
+*/
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "../include/zsyncblockstore_p.hpp"
+#include "../include/zsyncmatchcache_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+static constexpr quint32 MatchCacheMagic = 0x41494d43; /* "AIMC" */
+static constexpr quint32 MatchCacheVersion = 1;
+
+/* Bytes of one extent in a cache file , see write(). */
+static constexpr qint64 MatchCacheExtentSize = sizeof(qint64) + sizeof(qint32) + sizeof(qint32);
+
+/*
+ * ZsyncMatchCachePrivate keeps the result of a seed scan , i.e which target
+ * blocks were found at which offsets of the seed. The same seed always gives
+ * the same matches for the same target , So a cache keyed by the SHA1 hash of
+ * both lets every other host which updates the same version to the same new
+ * version skip the rolling scan and only place the extents.
+ *
+ * A cache file is self contained , it can be exported , shipped to other
+ * hosts and imported there. The delta writer verifies every block it takes
+ * from a cache , So a stale or broken cache only costs the scan.
+ *
+ * Example:
+ * 	QVector<ZsyncMatchCachePrivate::Extent> extents;
+ * 	if(ZsyncMatchCachePrivate::load(directory, seedSHA1, targetSHA1, blockSize, blocks, &extents)) {
+ * 		// Place the extents.
+ * 	}
+*/
+bool ZsyncMatchCachePrivate::load(const QString &directory, const QString &seedSHA1, const QString &targetSHA1,
+                                  qint32 blockSize, qint32 blocks, QVector<Extent> *extents)
+{
+    if(directory.isEmpty() || !isSha1(seedSHA1) || !isSha1(targetSHA1)) {
+        return false;
+    }
+    QFile file(cachePath(directory, seedSHA1, targetSHA1));
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    Header header;
+    if(!read(&file, &header, extents) ||
+       header.s_SeedSHA1 != seedSHA1.toUpper() || header.s_TargetSHA1 != targetSHA1.toUpper() ||
+       header.n_BlockSize != blockSize || header.n_Blocks != blocks) {
+        extents->clear();
+        return false;
+    }
+    return true;
+}
+
+void ZsyncMatchCachePrivate::save(const QString &directory, const QString &seedSHA1, const QString &targetSHA1,
+                                  qint32 blockSize, qint32 blocks, const QVector<Extent> &extents)
+{
+    if(directory.isEmpty() || !isSha1(seedSHA1) || !isSha1(targetSHA1) || !QDir().mkpath(directory)) {
+        return;
+    }
+    Header header;
+    header.s_SeedSHA1 = seedSHA1.toUpper();
+    header.s_TargetSHA1 = targetSHA1.toUpper();
+    header.n_BlockSize = blockSize;
+    header.n_Blocks = blocks;
+
+    QSaveFile file(cachePath(directory, seedSHA1, targetSHA1));
+    if(file.open(QIODevice::WriteOnly) && write(&file, header, extents)) {
+        file.commit();
+    }
+    ZsyncBlockStorePrivate::pruneDirectory(directory, QString("*.matches"));
+    return;
+}
+
+/* Copies a cache file made on another host into the given directory. */
+bool ZsyncMatchCachePrivate::importFile(const QString &path, const QString &directory)
+{
+    QFile file(path);
+    if(directory.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    Header header;
+    QVector<Extent> extents;
+    if(!read(&file, &header, &extents) || !isSha1(header.s_SeedSHA1) || !isSha1(header.s_TargetSHA1)) {
+        return false;
+    }
+    save(directory, header.s_SeedSHA1, header.s_TargetSHA1, header.n_BlockSize, header.n_Blocks, extents);
+    return QFileInfo::exists(cachePath(directory, header.s_SeedSHA1, header.s_TargetSHA1));
+}
+
+/* Writes the cache of the given version pair to the given file. */
+bool ZsyncMatchCachePrivate::exportFile(const QString &directory, const QString &seedSHA1, const QString &targetSHA1,
+                                        const QString &path)
+{
+    if(directory.isEmpty() || !isSha1(seedSHA1) || !isSha1(targetSHA1)) {
+        return false;
+    }
+    QFile file(cachePath(directory, seedSHA1, targetSHA1));
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    Header header;
+    QVector<Extent> extents;
+    if(!read(&file, &header, &extents)) {
+        return false;
+    }
+
+    QSaveFile exported(path);
+    return exported.open(QIODevice::WriteOnly) && write(&exported, header, extents) && exported.commit();
+}
+
+/* The SHA1 hashes become a file name , So nothing but 40 hex digits is accepted. */
+bool ZsyncMatchCachePrivate::isSha1(const QString &sha1)
+{
+    if(sha1.size() != 40) {
+        return false;
+    }
+    for(auto c : sha1) {
+        if(!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString ZsyncMatchCachePrivate::cachePath(const QString &directory, const QString &seedSHA1, const QString &targetSHA1)
+{
+    return directory + "/" + seedSHA1.toUpper() + "-" + targetSHA1.toUpper() + ".matches";
+}
+
+/* A cache which is broken or of a different version is ignored. */
+bool ZsyncMatchCachePrivate::read(QIODevice *device, Header *header, QVector<Extent> *extents)
+{
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0, version = 0;
+    qint32 count = 0;
+    stream >> magic >> version >> header->s_SeedSHA1 >> header->s_TargetSHA1
+           >> header->n_BlockSize >> header->n_Blocks >> count;
+    /* A cache can't have more extents than its bytes hold , however large count claims. */
+    if(stream.status() != QDataStream::Ok || magic != MatchCacheMagic || version != MatchCacheVersion ||
+       header->n_BlockSize <= 0 || header->n_Blocks <= 0 || count < 0 || count > header->n_Blocks ||
+       count > device->bytesAvailable() / MatchCacheExtentSize) {
+        return false;
+    }
+
+    extents->clear();
+    for(qint32 i = 0; i < count; ++i) {
+        Extent extent;
+        stream >> extent.seedOffset >> extent.firstBlock >> extent.blockCount;
+        if(stream.status() != QDataStream::Ok || extent.seedOffset < 0 || extent.firstBlock < 0 ||
+           extent.blockCount <= 0 || extent.blockCount > header->n_Blocks - extent.firstBlock) {
+            extents->clear();
+            return false;
+        }
+        extents->append(extent);
+    }
+    return true;
+}
+
+bool ZsyncMatchCachePrivate::write(QIODevice *device, const Header &header, const QVector<Extent> &extents)
+{
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << MatchCacheMagic << MatchCacheVersion << header.s_SeedSHA1 << header.s_TargetSHA1
+           << header.n_BlockSize << header.n_Blocks << static_cast<qint32>(extents.size());
+    for(auto iter = extents.constBegin(), end = extents.constEnd(); iter != end; ++iter) {
+        stream << (*iter).seedOffset << (*iter).firstBlock << (*iter).blockCount;
+    }
+    return stream.status() == QDataStream::Ok;
+}
@@ -0,0 +1,176 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncprogressaggregator_p.cc
+ * @description : This is where the progress aggregator is implemented.
+*/
+#include <cmath>
+
+#include "../include/zsyncprogressaggregator_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+/* Default publish interval , i.e 10 times per second. */
+static constexpr int DefaultPublishInterval = 100;
+
+/* Time constant of the speed estimate in milliseconds. */
+static constexpr double SpeedTimeConstant = 3000.0;
+
+/*
+ * The delta writer and every block range reply used to emit a progress signal
+ * for each buffer they handled , each with its own speed string and each one
+ * crossing threads. ZsyncProgressAggregatorPrivate takes over that job , the
+ * producers only store or add their bytes to a atomic counter and the
+ * aggregator publishes the progress from its own thread with a timer.
+ *
+ * The speed is a exponentially weighted moving average of the bytes per
+ * second between two publishes , So it follows changes of the network speed
+ * quickly but does not jump around. The remaining time is estimated from it.
+ *
+ * Example:
+ * 	ZsyncProgressAggregatorPrivate aggregator;
+ * 	connect(&aggregator, &ZsyncProgressAggregatorPrivate::progress, ...);
+ * 	// In any thread.
+ * 	aggregator.begin(0, targetFileLength);
+ * 	aggregator.addBytes(received);
+*/
+ZsyncProgressAggregatorPrivate::ZsyncProgressAggregatorPrivate(QObject *parent)
+    : QObject(parent),
+      m_Timer(this)
+{
+    m_Timer.setInterval(DefaultPublishInterval);
+    connect(&m_Timer, &QTimer::timeout, this, &ZsyncProgressAggregatorPrivate::publish);
+    return;
+}
+
+ZsyncProgressAggregatorPrivate::~ZsyncProgressAggregatorPrivate()
+{
+    return;
+}
+
+/*
+ * Starts a new phase , e.g scanning a seed file or downloading the
+ * missing blocks. Starts the timer in the aggregator's thread.
+*/
+void ZsyncProgressAggregatorPrivate::begin(qint64 bytesDone, qint64 bytesTotal)
+{
+    n_BytesTotal.storeRelease(bytesTotal);
+    n_BytesDone.storeRelease(bytesDone);
+    n_Phase.ref();
+    QMetaObject::invokeMethod(this, "startPublishing", Qt::QueuedConnection);
+    return;
+}
+
+void ZsyncProgressAggregatorPrivate::setBytes(qint64 bytesDone)
+{
+    n_BytesDone.storeRelease(bytesDone);
+    return;
+}
+
+void ZsyncProgressAggregatorPrivate::addBytes(qint64 bytes)
+{
+    n_BytesDone.fetchAndAddRelaxed(bytes);
+    return;
+}
+
+/* Sets the time between two publishes in milliseconds. */
+void ZsyncProgressAggregatorPrivate::setInterval(int msecs)
+{
+    if(msecs <= 0) {
+        return;
+    }
+    m_Timer.setInterval(msecs);
+    return;
+}
+
+/*
+ * Stops publishing until the next phase begins , Nothing is published
+ * after the operation has ended.
+*/
+void ZsyncProgressAggregatorPrivate::stop(void)
+{
+    m_Timer.stop();
+    return;
+}
+
+void ZsyncProgressAggregatorPrivate::startPublishing(void)
+{
+    if(!m_Clock.isValid()) {
+        m_Clock.start();
+    }
+    if(!m_Timer.isActive()) {
+        m_Timer.start();
+    }
+    return;
+}
+
+void ZsyncProgressAggregatorPrivate::publish(void)
+{
+    int phase = n_Phase.loadAcquire();
+    qint64 bytesDone = n_BytesDone.loadAcquire(),
+           bytesTotal = n_BytesTotal.loadAcquire(),
+           now = m_Clock.elapsed();
+
+    if(phase != n_PublishedPhase) {
+        /* A new phase , the old speed says nothing about it. */
+        n_PublishedPhase = phase;
+        n_PublishedBytes = bytesDone;
+        n_PublishedTime = now;
+        n_Speed = 0.0;
+    } else if(bytesDone == n_PublishedBytes) {
+        return;
+    } else if(now > n_PublishedTime) {
+        double elapsed = static_cast<double>(now - n_PublishedTime);
+        double speed = (bytesDone - n_PublishedBytes) * 1000.0 / elapsed;
+        double alpha = 1.0 - std::exp(-elapsed / SpeedTimeConstant);
+        n_Speed = (n_Speed > 0.0) ? n_Speed + alpha * (speed - n_Speed) : speed;
+        n_PublishedBytes = bytesDone;
+        n_PublishedTime = now;
+    }
+
+    int nPercentage = bytesTotal > 0 ? static_cast<int>(bytesDone * 100 / bytesTotal) : 0;
+    double nSpeed = n_Speed;
+    QString sUnit;
+    if (nSpeed < 1024) {
+        sUnit = "bytes/sec";
+    } else if (nSpeed < 1024 * 1024) {
+        nSpeed /= 1024;
+        sUnit = "kB/s";
+    } else {
+        nSpeed /= 1024 * 1024;
+        sUnit = "MB/s";
+    }
+    emit progress(nPercentage, bytesDone, bytesTotal, nSpeed, sUnit);
+    emit remainingTime(n_Speed > 0.0 ?
+                       static_cast<qint64>(std::ceil(qMax<qint64>(bytesTotal - bytesDone, 0) / n_Speed)) :
+                       -1);
+    return;
+}
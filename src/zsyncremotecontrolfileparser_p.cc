@@ -36,6 +36,8 @@
  * This also produces information for ZsyncWriterPrivate.
 */
 #include "../include/zsyncremotecontrolfileparser_p.hpp"
+#include "../include/tracer_p.hpp"
+#include "../include/logging_p.hpp"
 
 using namespace AppImageUpdaterBridge;
 
@@ -45,24 +47,22 @@ using namespace AppImageUpdaterBridge;
  * 	Hard coded to work only in this source file.
 */
 #ifndef LOGGING_DISABLED
-#define LOGS *(p_Logger.data()) LOGR
+#define LOGS(type) { if(isLogEnabled(type)) { *(p_Logger.data()) <<
 #define LOGR <<
-#define LOGE ; \
-             emit(logger(s_LogBuffer , s_AppImagePath)); \
-             s_LogBuffer.clear();
+#define LOGE(type) ; flushLog(type); } }
 #else
-#define LOGS (void)
+#define LOGS(type) { if(false) { (void)
 #define LOGR ;(void)
-#define LOGE ;
+#define LOGE(type) ; } }
 #endif // LOGGING_DISABLED
-#define INFO_START LOGS "   INFO: "
-#define INFO_END LOGE
+#define INFO_START LOGS(QtInfoMsg) "   INFO: "
+#define INFO_END LOGE(QtInfoMsg)
 
-#define WARNING_START LOGS "WARNING: "
-#define WARNING_END LOGE
+#define WARNING_START LOGS(QtWarningMsg) "WARNING: "
+#define WARNING_END LOGE(QtWarningMsg)
 
-#define FATAL_START LOGS "  FATAL: "
-#define FATAL_END LOGE
+#define FATAL_START LOGS(QtCriticalMsg) "  FATAL: "
+#define FATAL_END LOGE(QtCriticalMsg)
 
 
 /*
@@ -139,6 +139,7 @@ void ZsyncRemoteControlFileParserPrivate::setLoggerName(const QString &name)
 void ZsyncRemoteControlFileParserPrivate::setShowLog(bool choose)
 {
 #ifndef LOGGING_DISABLED
+    b_ShowLog = choose;
     if(choose) {
         connect(this, SIGNAL(logger(QString, QString)),
                 this, SLOT(handleLogMessage(QString, QString)), Qt::UniqueConnection);
@@ -152,6 +153,45 @@ void ZsyncRemoteControlFileParserPrivate::setShowLog(bool choose)
     return;
 }
 
+/*
+ * Tells if anyone is connected to the logger signal , only then the log
+ * messages are formatted and emitted.
+*/
+void ZsyncRemoteControlFileParserPrivate::setLoggerConnected(bool connected)
+{
+#ifndef LOGGING_DISABLED
+    b_LoggerConnected = connected;
+#else
+    (void)connected;
+#endif
+    return;
+}
+
+#ifndef LOGGING_DISABLED
+/*
+ * Returns true if a log message of the given type would be seen by anyone ,
+ * the message is not even formatted otherwise.
+*/
+bool ZsyncRemoteControlFileParserPrivate::isLogEnabled(QtMsgType type) const
+{
+    if(!b_ShowLog && !b_LoggerConnected && !LogRingBufferPrivate::isEnabled()) {
+        return false;
+    }
+    return lcControlFileParser().isEnabled(type);
+}
+
+/* Hands the formatted message to the ring buffer and the logger signal. */
+void ZsyncRemoteControlFileParserPrivate::flushLog(QtMsgType type)
+{
+    LogRingBufferPrivate::append(type, s_LoggerName, s_LogBuffer);
+    if(b_ShowLog || b_LoggerConnected) {
+        emit(logger(s_LogBuffer, s_AppImagePath));
+    }
+    s_LogBuffer.clear();
+    return;
+}
+#endif // LOGGING_DISABLED
+
 /* This public method safely sets the zsync control file url. */
 void ZsyncRemoteControlFileParserPrivate::setControlFileUrl(const QUrl &controlFileUrl)
 {
@@ -214,6 +254,7 @@ void ZsyncRemoteControlFileParserPrivate::setControlFileUrl(QJsonObject informat
 
         emit statusChanged(RequestingGithubApi);
         auto reply = p_NManager->get(request);
+        watchReply(reply);
 
         connect(reply, SIGNAL(error(QNetworkReply::NetworkError)),
                 this, SLOT(handleNetworkError(QNetworkReply::NetworkError)), Qt::UniqueConnection);
@@ -239,6 +280,7 @@ void ZsyncRemoteControlFileParserPrivate::setControlFileUrl(QJsonObject informat
 
         emit statusChanged(RequestingBintray);
         QNetworkReply *reply = p_NManager->head(request);
+        watchReply(reply);
 
         connect(reply, SIGNAL(error(QNetworkReply::NetworkError)),
                 this, SLOT(handleNetworkError(QNetworkReply::NetworkError)), Qt::UniqueConnection);
@@ -270,6 +312,30 @@ void ZsyncRemoteControlFileParserPrivate::clear(void)
     return;
 }
 
+/*
+ * Aborts every request in flight without any signal , The same update
+ * information is fetched again next time since it may be incomplete.
+*/
+void ZsyncRemoteControlFileParserPrivate::cancel(void)
+{
+    INFO_START " cancel : aborting all requests." INFO_END;
+    j_UpdateInformation = QJsonObject();
+    emit cancelAllReply();
+    emit statusChanged(Idle);
+    return;
+}
+
+/* Lets cancel abort the given reply , Its results are not handled anymore then. */
+void ZsyncRemoteControlFileParserPrivate::watchReply(QNetworkReply *reply)
+{
+    connect(this, &ZsyncRemoteControlFileParserPrivate::cancelAllReply, reply, [this, reply]() {
+        disconnect(reply, nullptr, this, nullptr);
+        reply->abort();
+        reply->deleteLater();
+    });
+    return;
+}
+
 /* Starts an async request to the given zsync control file. */
 void ZsyncRemoteControlFileParserPrivate::getControlFile(void)
 {
@@ -287,6 +353,8 @@ void ZsyncRemoteControlFileParserPrivate::getControlFile(void)
 
     emit statusChanged(RequestingZsyncControlFile);
     auto reply = p_NManager->get(request);
+    watchReply(reply);
+    TracerPrivate::asyncBegin("FetchControlFile", reply, QJsonObject { { "Url", u_ControlFileUrl.toString() } });
 
     connect(reply, SIGNAL(error(QNetworkReply::NetworkError)),
             this, SLOT(handleNetworkError(QNetworkReply::NetworkError)));
@@ -461,6 +529,8 @@ void ZsyncRemoteControlFileParserPrivate::handleControlFile(void)
     INFO_START LOGR " handleControlFile : starting to parse zsync control file." INFO_END;
     emit statusChanged(ParsingZsyncControlFile);
     QNetworkReply *senderReply = (QNetworkReply*)QObject::sender();
+    TracerPrivate::asyncEnd("FetchControlFile", senderReply);
+    TraceScope traceScope("ParseControlFile");
     int responseCode = senderReply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     INFO_START LOGR " handleControlFile : http response code(" LOGR responseCode LOGR ")." INFO_END;
     if(responseCode > 400) {
@@ -652,8 +722,14 @@ void ZsyncRemoteControlFileParserPrivate::handleControlFile(void)
         request.setUrl(urlToRequest);
         request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
         request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+        /* Same as the range requests , so that they can reuse this connection. */
+        request.setAttribute(QNetworkRequest::HTTP2AllowedAttribute, true);
+#endif // QT_VERSION >= 5.10
         request.setRawHeader("Range", rangeHeaderValue);
         auto reply = p_NManager->get(request);
+        watchReply(reply);
+        TracerPrivate::asyncBegin("ProbeTargetFile", reply, QJsonObject { { "Url", urlToRequest.toString() } });
         connect(reply, &QNetworkReply::downloadProgress,
                 this, &ZsyncRemoteControlFileParserPrivate::checkHeadTargetFileUrl);
         connect(reply, SIGNAL(error(QNetworkReply::NetworkError)),
@@ -681,6 +757,7 @@ void ZsyncRemoteControlFileParserPrivate::checkHeadTargetFileUrl(qint64 bytesRec
     auto reply = (QNetworkReply*)QObject::sender();
     disconnect(reply, &QNetworkReply::downloadProgress,
                this, &ZsyncRemoteControlFileParserPrivate::checkHeadTargetFileUrl);
+    TracerPrivate::asyncEnd("ProbeTargetFile", reply);
     auto replyCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
     if(replyCode >= 400) {
         emit error(UnknownNetworkError);
@@ -693,7 +770,22 @@ void ZsyncRemoteControlFileParserPrivate::checkHeadTargetFileUrl(qint64 bytesRec
         WARNING_START
         " handleControlFile : its confirmed that the remote server does not support range requests." WARNING_END;
     }
-    reply->abort();
+
+    /*
+     * Aborting closes the connection , which the block range downloader would have
+     * to open again with a new TCP and TLS handshake. A range reply is only a few
+     * bytes , so let it finish and the QNetworkAccessManager keeps the connection
+     * alive for the first range requests. A server without range support sends
+     * the whole file , that reply is still aborted.
+    */
+    disconnect(reply, SIGNAL(error(QNetworkReply::NetworkError)),
+               this, SLOT(handleNetworkError(QNetworkReply::NetworkError)));
+    if(replyCode == 206 && !reply->isFinished()) {
+        connect(reply, &QNetworkReply::finished, reply, &QObject::deleteLater);
+    } else {
+        reply->abort();
+        reply->deleteLater();
+    }
     u_TargetFileUrl = reply->url();
     emit statusChanged(FinalizingParsingZsyncControlFile);
     emit receiveControlFile();
@@ -752,7 +844,7 @@ void ZsyncRemoteControlFileParserPrivate::handleNetworkError(QNetworkReply::Netw
 void ZsyncRemoteControlFileParserPrivate::handleErrorSignal(short errorCode)
 {
     emit statusChanged(Idle);
-    FATAL_START LOGR " error : " LOGR errorCodeToString(errorCode) LOGR " occured.";
+    FATAL_START LOGR " error : " LOGR errorCodeToString(errorCode) LOGR " occured." FATAL_END;
     clear(); // clear all data to prevent later corrupted data collisions.
     return;
 }
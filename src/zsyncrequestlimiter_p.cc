@@ -0,0 +1,171 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncrequestlimiter_p.cc
+ * @description : This is where the request limiter is implemented.
+*/
+#include "../include/zsyncrequestlimiter_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+/*
+ * ZsyncRequestLimiterPrivate is shared by all ZsyncBlockRangeDownloaderPrivate
+ * objects of a AppImageUpdateManager , every downloader has to acquire a slot
+ * before it sends a block range request and gives it back when the reply is
+ * done. The writers of a manager share another one for their seed scans.
+ *
+ * Whoever cannot get a slot is queued as a waiter , release hands the slot to
+ * the first waiter only and invokes the given member of it with a queued
+ * connection , The waiter takes the slot with the next tryAcquire. So a
+ * released slot wakes a single waiter instead of all of them.
+ *
+ * Example:
+ * 	ZsyncRequestLimiterPrivate limiter(16);
+ * 	if(limiter.tryAcquire(this, "requestPendingRanges")) {
+ * 		// send the request.
+ * 	}
+*/
+ZsyncRequestLimiterPrivate::ZsyncRequestLimiterPrivate(int maxInFlightRequests, QObject *parent)
+    : QObject(parent),
+      n_Available(maxInFlightRequests < 1 ? 1 : maxInFlightRequests),
+      n_MaxInFlightRequests(maxInFlightRequests < 1 ? 1 : maxInFlightRequests)
+{
+    return;
+}
+
+ZsyncRequestLimiterPrivate::~ZsyncRequestLimiterPrivate()
+{
+    return;
+}
+
+/* Takes one slot , returns false if all slots are in use. */
+bool ZsyncRequestLimiterPrivate::tryAcquire(void)
+{
+    QMutexLocker locker(&m_Mutex);
+    if(n_Available <= 0) {
+        return false;
+    }
+    --n_Available;
+    return true;
+}
+
+/*
+ * Takes the slot handed to the given waiter or a free slot , else queues the
+ * waiter once and returns false. The given member of the waiter is invoked
+ * with a queued connection when a slot is handed to it.
+*/
+bool ZsyncRequestLimiterPrivate::tryAcquire(QObject *waiter, const char *member)
+{
+    QMutexLocker locker(&m_Mutex);
+    if(m_Granted.removeOne(waiter)) {
+        return true;
+    }
+    /* Do not overtake the waiters in the queue. */
+    if(n_Available > 0 && m_Waiters.isEmpty()) {
+        --n_Available;
+        return true;
+    }
+    if(!hasWaiter(waiter)) {
+        m_Waiters.append(Waiter { QPointer<QObject>(waiter), QByteArray(member) });
+    }
+    return false;
+}
+
+/* Gives back a slot , it goes to the first waiter which still exists. */
+void ZsyncRequestLimiterPrivate::release(void)
+{
+    QMutexLocker locker(&m_Mutex);
+    while(!m_Waiters.isEmpty()) {
+        auto waiter = m_Waiters.takeFirst();
+        if(waiter.p_Object.isNull()) {
+            continue;
+        }
+        m_Granted.append(waiter.p_Object.data());
+        QMetaObject::invokeMethod(waiter.p_Object.data(), waiter.s_Member.constData(), Qt::QueuedConnection);
+        return;
+    }
+    ++n_Available;
+    return;
+}
+
+/*
+ * Gives back the slot handed to the given waiter if it did not take it , Every
+ * waiter calls this after it was woken up and had nothing to do with the slot.
+*/
+void ZsyncRequestLimiterPrivate::releaseUnclaimed(QObject *waiter)
+{
+    {
+        QMutexLocker locker(&m_Mutex);
+        if(!m_Granted.removeOne(waiter)) {
+            return;
+        }
+    }
+    release();
+    return;
+}
+
+/* Forgets the given waiter , must be called before the waiter is destructed. */
+void ZsyncRequestLimiterPrivate::removeWaiter(QObject *waiter)
+{
+    {
+        QMutexLocker locker(&m_Mutex);
+        for(auto iter = m_Waiters.begin(); iter != m_Waiters.end();) {
+            if((*iter).p_Object.data() == waiter) {
+                iter = m_Waiters.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+    releaseUnclaimed(waiter);
+    return;
+}
+
+int ZsyncRequestLimiterPrivate::maxInFlightRequests(void) const
+{
+    return n_MaxInFlightRequests;
+}
+
+int ZsyncRequestLimiterPrivate::available(void) const
+{
+    QMutexLocker locker(&m_Mutex);
+    return n_Available;
+}
+
+bool ZsyncRequestLimiterPrivate::hasWaiter(QObject *waiter) const
+{
+    for(auto iter = m_Waiters.constBegin(), end = m_Waiters.constEnd(); iter != end; ++iter) {
+        if((*iter).p_Object.data() == waiter) {
+            return true;
+        }
+    }
+    return false;
+}
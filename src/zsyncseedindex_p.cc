@@ -0,0 +1,236 @@
+/*
+ * BSD 3-Clause License
+ *
+ * Copyright (c) 2018-2019, Antony jr
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of the copyright holder nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @filename    : zsyncseedindex_p.cc
+ * @description : This is where the persistent seed index is implemented.
+*/
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <cstring>
+#include <sys/stat.h>
+
+#include "../include/zsyncblockstore_p.hpp"
+#include "../include/zsyncseedindex_p.hpp"
+#include "../include/zsyncwriter_p.hpp"
+
+using namespace AppImageUpdaterBridge;
+
+static constexpr quint32 SeedIndexMagic = 0x41495349; /* "AISI" */
+static constexpr quint32 SeedIndexVersion = 1;
+
+namespace
+{
+/* Same as calc_rsum_block of the delta writer. */
+rsum blockRsum(const unsigned char *data, size_t len)
+{
+    unsigned short a = 0;
+    unsigned short b = 0;
+
+    while (len) {
+        unsigned char c = *data++;
+        a += c;
+        b += len * c;
+        len--;
+    }
+    rsum r = { a, b };
+    return r;
+}
+
+/* Hashes a slice of the aligned blocks , the slices are hashed in parallel. */
+class BlockHasher : public QRunnable
+{
+public:
+    BlockHasher(const uchar *data, qint32 blockSize, qint32 checksumBytes, qint64 from, qint64 to,
+                ZsyncSeedIndexPrivate::Block *blocks, QSemaphore *done)
+        : p_Data(data),
+          n_BlockSize(blockSize),
+          n_ChecksumBytes(checksumBytes),
+          n_From(from),
+          n_To(to),
+          p_Blocks(blocks),
+          p_Done(done)
+    {
+        return;
+    }
+
+    void run() override
+    {
+        /* One context per slice , the checksum goes straight into the block. */
+        QCryptographicHash md4(QCryptographicHash::Md4);
+        for(qint64 i = n_From; i < n_To; ++i) {
+            const uchar *block = p_Data + i * n_BlockSize;
+            p_Blocks[i].r = blockRsum(block, n_BlockSize);
+            ZsyncWriterPrivate::calcMd4Checksum(&md4, p_Blocks[i].checksum, block, n_BlockSize, n_ChecksumBytes);
+        }
+        p_Done->release();
+        return;
+    }
+private:
+    const uchar *p_Data = nullptr;
+    qint32 n_BlockSize = 0,
+           n_ChecksumBytes = 0;
+    qint64 n_From = 0,
+           n_To = 0;
+    ZsyncSeedIndexPrivate::Block *p_Blocks = nullptr;
+    QSemaphore *p_Done = nullptr;
+};
+}
+
+/*
+ * ZsyncSeedIndexPrivate hashes every block of a seed file which starts at a
+ * multiple of the block size. Most AppImage updates keep large regions at
+ * the same offsets , So the delta writer matches these blocks directly and
+ * only rolls over the rest.
+ *
+ * The index is written to the given directory keyed by the identity of the
+ * seed , i.e its device , inode , size and modification time , So the next
+ * update which uses the same seed does not hash it again. Without a directory
+ * the blocks are only hashed.
+ *
+ * Only full blocks are indexed , the zero padded last block is left to the
+ * rolling scan.
+ *
+ * Example:
+ * 	auto blocks = ZsyncSeedIndexPrivate::get(blockStoreDirectory + "/seedindex",
+ * 						 &seed, map, blockSize, strongChecksumBytes, pool);
+*/
+QVector<ZsyncSeedIndexPrivate::Block> ZsyncSeedIndexPrivate::get(const QString &directory, QFile *seed,
+        const uchar *data, qint32 blockSize, qint32 checksumBytes, QThreadPool *pool)
+{
+    qint64 count = seed->size() / blockSize;
+    QVector<Block> blocks;
+    QByteArray identity;
+    QString path = directory.isEmpty() ? QString() :
+                   indexPath(directory, seed, blockSize, checksumBytes, &identity);
+    if(!path.isEmpty() && load(path, identity, count, &blocks)) {
+        return blocks;
+    }
+
+    blocks = build(data, seed->size(), blockSize, checksumBytes, pool);
+    if(!path.isEmpty() && QDir().mkpath(directory)) {
+        save(path, identity, blocks);
+        ZsyncBlockStorePrivate::pruneDirectory(directory, QString("*.index"));
+    }
+    return blocks;
+}
+
+/*
+ * Hashes the aligned full blocks of the given data in the given pool , Which
+ * is shared with other updates , So only our own slices are waited for.
+ * The MD4 checksums are truncated to the given strong checksum length.
+*/
+QVector<ZsyncSeedIndexPrivate::Block> ZsyncSeedIndexPrivate::build(const uchar *data, qint64 size, qint32 blockSize,
+        qint32 checksumBytes, QThreadPool *pool)
+{
+    qint64 count = blockSize > 0 ? size / blockSize : 0;
+    QVector<Block> blocks(static_cast<int>(count));
+    if(!count) {
+        return blocks;
+    }
+
+    QSemaphore done;
+    int started = 0;
+    qint64 slices = qMin(count, static_cast<qint64>(qMax(1, pool->maxThreadCount())) * 4),
+           perSlice = (count + slices - 1) / slices;
+    for(qint64 from = 0; from < count; from += perSlice) {
+        pool->start(new BlockHasher(data, blockSize, checksumBytes, from, qMin(count, from + perSlice),
+                                    blocks.data(), &done));
+        ++started;
+    }
+    done.acquire(started);
+    return blocks;
+}
+
+/* The index file of the given seed , its identity is stored in the file too. */
+QString ZsyncSeedIndexPrivate::indexPath(const QString &directory, QFile *seed, qint32 blockSize, qint32 checksumBytes,
+                                         QByteArray *identity)
+{
+    struct stat seedStat;
+    if(fstat(seed->handle(), &seedStat) != 0) {
+        return QString();
+    }
+    QDataStream stream(identity, QIODevice::WriteOnly);
+    stream << static_cast<quint64>(seedStat.st_dev)
+           << static_cast<quint64>(seedStat.st_ino)
+           << static_cast<qint64>(seedStat.st_size)
+           << static_cast<qint64>(seedStat.st_mtim.tv_sec)
+           << static_cast<qint64>(seedStat.st_mtim.tv_nsec)
+           << blockSize
+           << checksumBytes;
+    return directory + "/" + QCryptographicHash::hash(*identity, QCryptographicHash::Sha1).toHex() + ".index";
+}
+
+/* A index which is broken or belongs to a different file is ignored. */
+bool ZsyncSeedIndexPrivate::load(const QString &path, const QByteArray &identity, qint64 count, QVector<Block> *blocks)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0, version = 0;
+    QByteArray storedIdentity;
+    qint64 storedCount = 0;
+    stream >> magic >> version >> storedIdentity >> storedCount;
+    if(stream.status() != QDataStream::Ok || magic != SeedIndexMagic || version != SeedIndexVersion ||
+       storedIdentity != identity || storedCount != count) {
+        return false;
+    }
+    blocks->resize(static_cast<int>(count));
+    int bytes = static_cast<int>(count * sizeof(Block));
+    if(stream.readRawData(reinterpret_cast<char*>(blocks->data()), bytes) != bytes) {
+        blocks->clear();
+        return false;
+    }
+    return true;
+}
+
+void ZsyncSeedIndexPrivate::save(const QString &path, const QByteArray &identity, const QVector<Block> &blocks)
+{
+    QSaveFile file(path);
+    if(!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << SeedIndexMagic << SeedIndexVersion << identity << static_cast<qint64>(blocks.size());
+    stream.writeRawData(reinterpret_cast<const char*>(blocks.constData()), static_cast<int>(blocks.size() * sizeof(Block)));
+    if(stream.status() == QDataStream::Ok) {
+        file.commit();
+    }
+    return;
+}
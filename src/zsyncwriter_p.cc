@@ -33,6 +33,26 @@
  * @description : This is where the main zsync algorithm is implemented.
 */
 #include "../include/zsyncwriter_p.hpp"
+#include "../include/sha1hasher_p.hpp"
+#include "../include/appimageupdateinformation_p.hpp"
+#include "../include/tracer_p.hpp"
+#include "../include/logging_p.hpp"
+#include "../include/zsyncseedindex_p.hpp"
+#include "../include/zsyncmatchcache_p.hpp"
+#include "../include/zsyncrequestlimiter_p.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifdef Q_OS_LINUX
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif // Q_OS_LINUX
 
 /*
  * An efficient logging system specially tailored
@@ -44,25 +64,41 @@
  *
 */
 #ifndef LOGGING_DISABLED
-#define LOGS *(p_Logger.data()) <<
+#define LOGS(type) { if(isLogEnabled(type)) { *(p_Logger.data()) <<
 #define LOGR <<
-#define LOGE ; \
-	     emit(logger(s_LogBuffer , s_SourceFilePath)); \
-	     s_LogBuffer.clear();
+#define LOGE(type) ; flushLog(type); } }
 #else
-#define LOGS (void)
+#define LOGS(type) { if(false) { (void)
 #define LOGR ;(void)
-#define LOGE ;
+#define LOGE(type) ; } }
 #endif // LOGGING_DISABLED
 
-#define INFO_START LOGS "   INFO: " LOGR
-#define INFO_END LOGE
+#define INFO_START LOGS(QtInfoMsg) "   INFO: " LOGR
+#define INFO_END LOGE(QtInfoMsg)
 
-#define WARNING_START LOGS "WARNING: " LOGR
-#define WARNING_END LOGE
+#define WARNING_START LOGS(QtWarningMsg) "WARNING: " LOGR
+#define WARNING_END LOGE(QtWarningMsg)
 
-#define FATAL_START LOGS "  FATAL: " LOGR
-#define FATAL_END LOGE
+#define FATAL_START LOGS(QtCriticalMsg) "  FATAL: " LOGR
+#define FATAL_END LOGE(QtCriticalMsg)
+
+/*
+ * Counts a event of the block matcher , compiled out with STATISTICS_DISABLED.
+ * STATISTICS_ADD counts in the counters of the current thread and is used by
+ * the scan kernel , they are moved to the writer by flushStatistics before
+ * the kernel returns or processes events. WRITER_STATISTICS_ADD counts
+ * directly in the writer and is used outside of the kernel.
+*/
+#ifndef STATISTICS_DISABLED
+#define STATISTICS_ADD(counter, n) (m_ThreadStatistics.counter += (n))
+#define WRITER_STATISTICS_ADD(counter, n) (m_Statistics.counter += (n))
+#else
+#define STATISTICS_ADD(counter, n) do { } while(0)
+#define WRITER_STATISTICS_ADD(counter, n) do { } while(0)
+#endif // STATISTICS_DISABLED
+
+/* Counters of the scan kernel in the current thread , See STATISTICS_ADD. */
+static thread_local ZsyncWriterStatistics m_ThreadStatistics;
 
 /* Update a already calculated block ,
  * This is why a rolling checksum is needed. */
@@ -74,6 +110,56 @@
 
 using namespace AppImageUpdaterBridge;
 
+/* Bytes of a mapped seed file given to the scan kernel at once. */
+static const qint64 MappedScanChunkSize = 16 * 1024 * 1024;
+
+/* Size of the read buffer for seed files which cannot be mapped. */
+static const qint32 BufferedScanSize = 256 * 1024;
+
+/*
+ * Identical target blocks are only grouped if the checksums have enough
+ * bits to tell different blocks apart , otherwise the final SHA1 check
+ * would fail too often.
+*/
+static const qint32 MinGroupingCheckSumBits = 56;
+
+/* Number of windows sampled from a extra seed file to rank it. */
+static const qint32 SeedSampleCount = 64;
+
+/*
+ * The ranges are only published before the extra seed files are scanned if
+ * the seed files are estimated to hold less than 1/EarlyPublishCoverage of
+ * the missing blocks , otherwise most of the early requests would be dropped.
+*/
+static const qint32 EarlyPublishCoverage = 8;
+
+/* Blocks taken from the block store under one lock. */
+static const qint32 BlockStoreLookupBatch = 256;
+
+namespace
+{
+/* Gives back a seed scan slot on every return path of start(). */
+class SeedScanSlotGuard
+{
+public:
+    explicit SeedScanSlotGuard(ZsyncRequestLimiterPrivate *limiter)
+        : p_Limiter(limiter)
+    {
+        return;
+    }
+
+    ~SeedScanSlotGuard()
+    {
+        if(p_Limiter) {
+            p_Limiter->release();
+        }
+        return;
+    }
+private:
+    ZsyncRequestLimiterPrivate *p_Limiter = nullptr;
+};
+}
+
 /*
  * Zsync uses the same modified version of the Adler32 checksum
  * as in rsync as the rolling checksum , here after denoted by rsum.
@@ -109,6 +195,7 @@ ZsyncWriterPrivate::ZsyncWriterPrivate()
 {
     emit statusChanged(Initializing);
     p_Md4Ctx.reset(new QCryptographicHash(QCryptographicHash::Md4));
+    p_KnownBlocks.reset(new ZsyncKnownBlocksPrivate);
 #ifndef LOGGING_DISABLED
     p_Logger.reset(new QDebug(&s_LogBuffer));
 #endif // LOGGING_DISABLED	
@@ -116,8 +203,41 @@ ZsyncWriterPrivate::ZsyncWriterPrivate()
     return;
 }
 
+void ZsyncWriterPrivate::setSeedScanLimiter(ZsyncRequestLimiterPrivate *limiter)
+{
+    p_SeedScanLimiter = limiter;
+    return;
+}
+
+/* The seed indexes are hashed in the given pool , the global thread pool if null. */
+void ZsyncWriterPrivate::setWorkerPool(QThreadPool *pool)
+{
+    p_WorkerPool = pool ? pool : QThreadPool::globalInstance();
+    return;
+}
+
+/*
+ * The blocks this writer has , The block range downloader checks them from
+ * its own thread before it requests a range.
+*/
+QSharedPointer<ZsyncKnownBlocksPrivate> ZsyncWriterPrivate::knownBlocks(void) const
+{
+    return p_KnownBlocks;
+}
+
+/* The seed scan progress is stored in the given aggregator , which publishes it. */
+void ZsyncWriterPrivate::setProgressAggregator(QSharedPointer<ZsyncProgressAggregatorPrivate> aggregator)
+{
+    p_Progress = aggregator;
+    return;
+}
+
 ZsyncWriterPrivate::~ZsyncWriterPrivate()
 {
+    if(p_SeedScanLimiter) {
+        p_SeedScanLimiter->removeWaiter(this);
+    }
+    discardDeferredBlockRanges();
     /* Free all c allocator allocated memory */
     if(p_RsumHash)
         free(p_RsumHash);
@@ -139,6 +259,122 @@ void ZsyncWriterPrivate::setOutputDirectory(const QString &dir)
     return;
 }
 
+/*
+ * In a dry run only the seed files are scanned against the control file ,
+ * no target file is created and nothing is written , Instead of starting
+ * the download the writer emits the plan signal.
+*/
+void ZsyncWriterPrivate::setDryRun(bool dryRun)
+{
+    if(b_Started)
+        return;
+    b_DryRun = dryRun;
+    return;
+}
+
+/*
+ * Adds a extra seed file , Seed files are scanned for blocks of the target
+ * file after the default seeds , the best matching ones first.
+*/
+void ZsyncWriterPrivate::addSeedFile(const QString &path)
+{
+    if(b_Started || path.isEmpty())
+        return;
+    m_SeedFiles << QFileInfo(path).absoluteFilePath();
+    m_SeedFiles.removeDuplicates();
+    return;
+}
+
+/*
+ * Adds a directory which is searched for seed files , Only files which embed
+ * the same update information as the source file are used. Useful when older
+ * versions or sibling builds of the same AppImage are kept around.
+*/
+void ZsyncWriterPrivate::addSeedDirectory(const QString &path)
+{
+    if(b_Started || path.isEmpty())
+        return;
+    m_SeedDirectories << QFileInfo(path).absoluteFilePath();
+    m_SeedDirectories.removeDuplicates();
+    return;
+}
+
+void ZsyncWriterPrivate::clearSeedFiles(void)
+{
+    if(b_Started)
+        return;
+    m_SeedFiles.clear();
+    m_SeedDirectories.clear();
+    return;
+}
+
+/*
+ * Uses the local block store in the given directory , Blocks missing after
+ * the seed scan are taken from the store before they are downloaded , and
+ * every verified target file is added to the store.
+ * An empty directory disables the block store.
+*/
+void ZsyncWriterPrivate::setBlockStore(const QString &directory, qint64 maxSize)
+{
+    if(b_Started)
+        return;
+    p_BlockStore = ZsyncBlockStorePrivate::open(directory, maxSize);
+    return;
+}
+
+/*
+ * Keeps the matches of the source file in the given directory , see
+ * ZsyncMatchCachePrivate. By default they are kept next to the block store ,
+ * without one nothing is cached.
+*/
+void ZsyncWriterPrivate::setMatchCache(const QString &directory)
+{
+    if(b_Started)
+        return;
+    s_MatchCacheDirectory = directory;
+    return;
+}
+
+/* The SHA1 hash of the source file , Without it the match cache is not used. */
+void ZsyncWriterPrivate::setSourceFileSHA1(const QString &sha1)
+{
+    if(b_Started)
+        return;
+    s_SourceFileSHA1 = sha1.toUpper();
+    return;
+}
+
+/*
+ * Emits the statistics signal with the counters of the block matcher since
+ * the last configuration , Useful to find out why a seed file scans slowly ,
+ * e.g many weak hits which are not confirmed by the strong checksum or long
+ * hash chains. Emits a empty object if built with STATISTICS_DISABLED.
+*/
+void ZsyncWriterPrivate::getStatistics(void)
+{
+#ifndef STATISTICS_DISABLED
+    QJsonObject result {
+        { "BitHashProbes", static_cast<double>(m_Statistics.n_BitHashProbes) },
+        { "BucketHits", static_cast<double>(m_Statistics.n_BucketHits) },
+        { "ChainEntries", static_cast<double>(m_Statistics.n_ChainEntries) },
+        { "WeakHits", static_cast<double>(m_Statistics.n_WeakHits) },
+        { "FalseWeakHits", static_cast<double>(m_Statistics.n_WeakHits - qMin(m_Statistics.n_WeakHits, m_Statistics.n_StrongHits)) },
+        { "Md4Computations", static_cast<double>(m_Statistics.n_Md4Computations) },
+        { "StrongHits", static_cast<double>(m_Statistics.n_StrongHits) },
+        { "BytesRolled", static_cast<double>(m_Statistics.n_BytesRolled) },
+        { "BlocksWritten", static_cast<double>(m_Statistics.n_BlocksWritten) },
+        { "AlignedMatches", static_cast<double>(m_Statistics.n_AlignedMatches) },
+        { "BytesCloned", static_cast<double>(m_Statistics.n_BytesCloned) },
+        { "BytesCopiedInKernel", static_cast<double>(m_Statistics.n_BytesCopiedInKernel) },
+        { "BytesCopiedInUserspace", static_cast<double>(m_Statistics.n_BytesCopiedInUserspace) }
+    };
+    emit statistics(result);
+#else
+    emit statistics(QJsonObject());
+#endif // STATISTICS_DISABLED
+    return;
+}
+
 /* Sets the logger name. */
 void ZsyncWriterPrivate::setLoggerName(const QString &name)
 {
@@ -156,6 +392,7 @@ void ZsyncWriterPrivate::setLoggerName(const QString &name)
 void ZsyncWriterPrivate::setShowLog(bool logNeeded)
 {
 #ifndef LOGGING_DISABLED
+    b_ShowLog = logNeeded;
     if(logNeeded) {
         connect(this, SIGNAL(logger(QString, QString)),
                 this, SLOT(handleLogMessage(QString, QString)),
@@ -170,6 +407,45 @@ void ZsyncWriterPrivate::setShowLog(bool logNeeded)
     return;
 }
 
+/*
+ * Tells if anyone is connected to the logger signal , only then the log
+ * messages are formatted and emitted.
+*/
+void ZsyncWriterPrivate::setLoggerConnected(bool connected)
+{
+#ifndef LOGGING_DISABLED
+    b_LoggerConnected = connected;
+#else
+    (void)connected;
+#endif
+    return;
+}
+
+#ifndef LOGGING_DISABLED
+/*
+ * Returns true if a log message of the given type would be seen by anyone ,
+ * the message is not even formatted otherwise.
+*/
+bool ZsyncWriterPrivate::isLogEnabled(QtMsgType type) const
+{
+    if(!b_ShowLog && !b_LoggerConnected && !LogRingBufferPrivate::isEnabled()) {
+        return false;
+    }
+    return lcDeltaWriter().isEnabled(type);
+}
+
+/* Hands the formatted message to the ring buffer and the logger signal. */
+void ZsyncWriterPrivate::flushLog(QtMsgType type)
+{
+    LogRingBufferPrivate::append(type, s_LoggerName, s_LogBuffer);
+    if(b_ShowLog || b_LoggerConnected) {
+        emit(logger(s_LogBuffer, s_SourceFilePath));
+    }
+    s_LogBuffer.clear();
+    return;
+}
+#endif // LOGGING_DISABLED
+
 #ifndef LOGGING_DISABLED
 void ZsyncWriterPrivate::handleLogMessage(QString msg, QString path)
 {
@@ -208,56 +484,285 @@ void ZsyncWriterPrivate::getBlockRanges(void)
     INFO_START " getBlockRanges : emitting required block ranges." INFO_END;
     emit statusChanged(EmittingRequiredBlockRanges);
 
+    b_DownloadRequested = false;
+    emitRequiredRanges();
+    emit statusChanged(Idle);
+
+    /* The seed scan which ran meanwhile may have found everything. */
+    pruneRequiredRanges();
+    if(b_Started && b_AllRangesPublished && p_RequiredRanges.isEmpty() && m_DeferredBlockRanges.isEmpty()) {
+        verifyAndConstructTargetFile();
+        return;
+    }
+    INFO_START " getBlockRanges : emitted required block ranges." INFO_END;
+    return;
+}
+
+/*
+ * Computes the block ranges which are not found in any seed file and not
+ * published yet , i.e the ranges which has to be downloaded to finish the
+ * target file. Only the first missing block of a group of identical blocks
+ * is requested , the rest are copied from it when it is written. Only
+ * adjacent missing blocks are requested as one range , So nothing a seed file
+ * gave is downloaded again.
+ *
+ * Every range is a pair of the first and the last block (inclusive) ,
+ * the last block of the target file is given as n_Blocks.
+ * The new ranges are added to p_RequiredRanges and returned.
+*/
+QVector<QPair<qint32, qint32>> ZsyncWriterPrivate::computeRequiredRanges(void)
+{
+    QVector<QPair<qint32, qint32>> ranges;
+    QVector<bool> requested(p_IdenticalBlocks.size(), false);
+    p_PublishedBlocks.resize(n_Blocks);
+    for(zs_blockid id = 0; id < n_Blocks; ++id) {
+        qint32 group = p_BlockGroups.value(id, -1);
+        if(group >= 0 && p_PublishedBlocks.at(id) && !alreadyGotBlock(id)) {
+            requested[group] = true;
+        }
+    }
 
-    if(p_RequiredRanges.isEmpty()) {
-        zs_blockid from = 0, to = n_Blocks;
-        p_RequiredRanges.append(qMakePair(from, to));
-        p_RequiredRanges.append(qMakePair(0, 0));
+    for(zs_blockid id = 0; id < n_Blocks; ++id) {
+        if(alreadyGotBlock(id) || p_PublishedBlocks.at(id)) {
+            continue;
+        }
+        qint32 group = p_BlockGroups.value(id, -1);
+        if(group >= 0 && requested.at(group)) {
+            continue;
+        }
+        if(group >= 0) {
+            requested[group] = true;
+        }
 
-        for(qint32 i = 0, n = 1; i < n_Ranges ; ++i) {
-            p_RequiredRanges.append(qMakePair(0, 0));
-            if (p_Ranges[2 * i] > p_RequiredRanges.at(n - 1).second)
-                continue;
-            if (p_Ranges[2 * i + 1] < from)
-                continue;
+        if(!ranges.isEmpty() && ranges.last().second == id - 1) {
+            ranges.last().second = id;
+        } else {
+            ranges.append(qMakePair(id, id));
+        }
+    }
 
-            /* Okay, they intersect */
-            if (n == 1 && p_Ranges[2 * i] <= from) {       /* Overlaps the start of our window */
-                p_RequiredRanges[0].first = p_Ranges[2 * i + 1] + 1;
-            } else {
-                /* If the last block that we still (which is the last window end -1, due
-                 * to half-openness) then this range just cuts the end of our window */
-                if (p_Ranges[2 * i + 1] >= p_RequiredRanges.at(n - 1).second - 1) {
-                    p_RequiredRanges[n - 1].second = p_Ranges[2 * i];
-                } else {
-                    /* In the middle of our range, split it */
-                    p_RequiredRanges[n].first = p_Ranges[2 * i + 1] + 1;
-                    p_RequiredRanges[n].second = p_RequiredRanges.at(n-1).second;
-                    p_RequiredRanges[n-1].second = p_Ranges[2 * i];
-                    n++;
-                }
-            }
-            QCoreApplication::processEvents();
+    /* Missing blocks which are not published are replicated. */
+    qint64 deduplicated = 0;
+    for(auto iter = ranges.constBegin(), end = ranges.constEnd(); iter != end; ++iter) {
+        for(zs_blockid id = (*iter).first; id <= (*iter).second; ++id) {
+            p_PublishedBlocks[id] = true;
         }
-        if (p_RequiredRanges.at(0).first >= p_RequiredRanges.at(0).second)
-            p_RequiredRanges.clear();
+    }
+    for(zs_blockid id = 0; id < n_Blocks; ++id) {
+        deduplicated += (!p_PublishedBlocks.at(id) && !alreadyGotBlock(id));
+    }
+    n_BytesDeduplicated = deduplicated << n_BlockShift;
 
-        p_RequiredRanges.removeAll(qMakePair(0, 0));
+    if(!ranges.isEmpty() && ranges.last().second == n_Blocks - 1) {
+        ranges.last().second = n_Blocks;
     }
+    p_RequiredRanges += ranges;
+    return ranges;
+}
+
+/*
+ * Gives the byte range emitted for the given block range , This is what the
+ * block downloader sends as is in the Range header , So the end is the start
+ * of the next block.
+*/
+void ZsyncWriterPrivate::requiredRangeBytes(const QPair<qint32, qint32> &range, qint32 *from, qint32 *to) const
+{
+    *from = range.first << n_BlockShift;
+    *to = (range.second >= n_Blocks) ? n_TargetFileLength :
+          (range.second << n_BlockShift) + n_BlockSize;
+    return;
+}
 
-    for(auto iter = p_RequiredRanges.constBegin(), end  = p_RequiredRanges.constEnd(); iter != end; ++iter) {
-        auto to = ((*iter).second >= n_Blocks) ? n_TargetFileLength :
-                  ((*iter).second << n_BlockShift) + n_BlockSize;
-        auto from = (*iter).first << n_BlockShift;
+/*
+ * Emits the required ranges which were not published yet , The end of
+ * the ranges is only emitted once the seed files are scanned.
+*/
+void ZsyncWriterPrivate::emitRequiredRanges(void)
+{
+    auto ranges = computeRequiredRanges();
+    for(auto iter = ranges.constBegin(), end  = ranges.constEnd(); iter != end; ++iter) {
+        qint32 from = 0,
+               to = 0;
+        requiredRangeBytes(*iter, &from, &to);
 
-        INFO_START " getBlockRanges : (" LOGR from LOGR " , " LOGR to LOGR ")." INFO_END;
+        INFO_START " emitRequiredRanges : (" LOGR from LOGR " , " LOGR to LOGR ")." INFO_END;
 
         emit blockRange(from, to);
         QCoreApplication::processEvents();
     }
-    emit endOfBlockRanges();
+    if(!b_Scanning) {
+        b_AllRangesPublished = true;
+        emit endOfBlockRanges();
+    }
+    return;
+}
+
+/*
+ * Lets the downloader start with the ranges still missing while the extra
+ * seed files are scanned , This is only done if the given estimate of blocks
+ * the extra seed files hold is below EarlyPublishCoverage of the missing
+ * blocks , So the ranges published are mostly ones no seed file can cover.
+ * Ranges found by the scan before they are requested are dropped by the
+ * downloader , see ZsyncKnownBlocksPrivate.
+*/
+void ZsyncWriterPrivate::publishRangesEarly(qint64 seedBlocks)
+{
+    if(b_DryRun || !b_AcceptRange || !p_Ranges || !n_Ranges || b_RangesPublished ||
+       n_BytesWritten >= n_TargetFileLength) {
+        return;
+    }
+    qint64 missingBlocks = (n_TargetFileLength - n_BytesWritten + n_BlockSize - 1) >> n_BlockShift;
+    if(seedBlocks * EarlyPublishCoverage >= missingBlocks) {
+        INFO_START " publishRangesEarly : extra seed files may hold " LOGR seedBlocks LOGR " of "
+                   LOGR missingBlocks LOGR " missing blocks , scanning first." INFO_END;
+        return;
+    }
+    INFO_START " publishRangesEarly : downloading while the extra seed files are scanned." INFO_END;
+    b_RangesPublished = b_Scanning = b_DownloadRequested = true;
+    emit download(n_BytesWritten, n_TargetFileLength, u_TargetFileUrl);
+    return;
+}
+
+/*
+ * Called once every seed file is scanned after the ranges were published
+ * early , Publishes the rest of the ranges and writes the ranges which were
+ * downloaded meanwhile.
+*/
+void ZsyncWriterPrivate::finishEarlyDownload(void)
+{
+    b_Scanning = false;
+
+    /* If getBlockRanges did not run yet , it publishes every range itself. */
+    if(!b_DownloadRequested) {
+        emitRequiredRanges();
+    }
+
+    auto deferred = m_DeferredBlockRanges;
+    m_DeferredBlockRanges.clear();
+    for(auto iter = deferred.constBegin(), end = deferred.constEnd(); iter != end; ++iter) {
+        writeBlockRanges((*iter).n_From, (*iter).n_To, (*iter).p_Data);
+    }
+
+    pruneRequiredRanges();
+    if(deferred.isEmpty() && b_AllRangesPublished && p_RequiredRanges.isEmpty()) {
+        verifyAndConstructTargetFile();
+    }
+    return;
+}
+
+/* Drops the deferred ranges , the downloader is told that their memory is free again. */
+void ZsyncWriterPrivate::discardDeferredBlockRanges(void)
+{
+    for(auto iter = m_DeferredBlockRanges.constBegin(), end = m_DeferredBlockRanges.constEnd(); iter != end; ++iter) {
+        delete (*iter).p_Data;
+        emit blockRangeWritten((*iter).n_From, (*iter).n_To);
+    }
+    m_DeferredBlockRanges.clear();
+    b_Scanning = false;
+    return;
+}
+
+/* Removes the required ranges which are known by now , by any means. */
+void ZsyncWriterPrivate::pruneRequiredRanges(void)
+{
+    for(int i = p_RequiredRanges.size() - 1; i >= 0; --i) {
+        if(isRangeKnown(p_RequiredRanges.at(i).first, p_RequiredRanges.at(i).second)) {
+            p_RequiredRanges.remove(i);
+        }
+    }
+    return;
+}
+
+/* Removes the required ranges which overlap the given blocks. */
+void ZsyncWriterPrivate::removeRequiredRanges(zs_blockid from, zs_blockid to)
+{
+    for(int i = p_RequiredRanges.size() - 1; i >= 0; --i) {
+        if(p_RequiredRanges.at(i).first <= to && p_RequiredRanges.at(i).second >= from) {
+            p_RequiredRanges.remove(i);
+        }
+    }
+    return;
+}
+
+/* Returns true if every block from the given block to the given block (inclusive) is known. */
+bool ZsyncWriterPrivate::isRangeKnown(zs_blockid from, zs_blockid to)
+{
+    to = qMin(to, n_Blocks - 1);
+
+    /* The known ranges are merged , so the one holding from has to hold the whole range. */
+    qint32 min = 0, max = n_Ranges - 1;
+    while(min <= max) {
+        qint32 r = (max + min) / 2;
+        if (from > p_Ranges[2 * r + 1]) min = r + 1;
+        else if (from < p_Ranges[2 * r]) max = r - 1;
+        else return p_Ranges[2 * r + 1] >= to;
+    }
+    return false;
+}
+
+/*
+ * Emits the delta plan of a dry run , which tells how much of the target file
+ * can be taken from the seed files and what is left to download , before
+ * anything is written to the disk.
+ *
+ * Example:
+ * 	{
+ * 	   "TargetFileName" : "AppImageUpdaterBridge-x86_64.AppImage",
+ * 	   "TargetFileLength" : 31457280,
+ * 	   "BytesAvailable" : 29360128,
+ * 	   "BytesToDownload" : 2099200,
+ * 	   "BytesDeduplicated" : 8192,
+ * 	   "BytesSynthesized" : 65536,
+ * 	   "RequestCount" : 3,
+ * 	   "RequiredRanges" : [ { "From" : 0 , "To" : 4096 } , ... ],
+ * 	   "SeedFiles" : [ { "AbsolutePath" : "..." , "MatchedBytes" : 29360128 , "MatchRatio" : 0.93 } ]
+ * 	}
+*/
+void ZsyncWriterPrivate::emitPlan(void)
+{
+    QJsonArray requiredRanges;
+    qint64 bytesToDownload = 0;
+
+    if(!p_Ranges || !n_Ranges || b_AcceptRange == false) {
+        /* The entire file has to be downloaded sequentially. */
+        requiredRanges.append(QJsonObject {
+            { "From", 0 },
+            { "To", n_TargetFileLength - 1 }
+        });
+        bytesToDownload = n_TargetFileLength;
+    } else {
+        computeRequiredRanges();
+        for(auto iter = p_RequiredRanges.constBegin(), end  = p_RequiredRanges.constEnd(); iter != end; ++iter) {
+            /* Same ranges as the ones requested by the block downloader. */
+            qint32 from = 0,
+                   to = 0;
+            requiredRangeBytes(*iter, &from, &to);
+
+            requiredRanges.append(QJsonObject {
+                { "From", from },
+                { "To", to }
+            });
+            /* The Range header is inclusive , The server stops at the end of the file. */
+            bytesToDownload += qMin(to, n_TargetFileLength - 1) - from + 1;
+        }
+    }
+
+    QJsonObject deltaPlan {
+        { "TargetFileName", s_TargetFileName },
+        { "TargetFileLength", n_TargetFileLength },
+        { "BytesAvailable", qMin(n_BytesWritten, static_cast<qint64>(n_TargetFileLength)) },
+        { "BytesToDownload", bytesToDownload },
+        { "BytesDeduplicated", n_BytesDeduplicated },
+        { "BytesSynthesized", n_BytesSynthesized },
+        { "RequestCount", requiredRanges.size() },
+        { "RequiredRanges", requiredRanges },
+        { "SeedFiles", j_SeedMatches }
+    };
+    INFO_START " emitPlan : " LOGR bytesToDownload LOGR " bytes to download in " LOGR requiredRanges.size() LOGR " requests." INFO_END;
+    INFO_START " emitPlan : " LOGR n_BytesDeduplicated LOGR " bytes deduplicated , " LOGR n_BytesSynthesized LOGR " bytes of zero blocks." INFO_END;
+    b_Started = false;
     emit statusChanged(Idle);
-    INFO_START " getBlockRanges : emitted required block ranges." INFO_END;
+    emit plan(deltaPlan);
     return;
 }
 
@@ -293,22 +798,31 @@ void ZsyncWriterPrivate::writeSeqRaw(QByteArray *downloadedData)
 */
 void ZsyncWriterPrivate::writeBlockRanges(qint32 fromRange, qint32 toRange, QByteArray *downloadedData)
 {
+    /* The scan is still running , this range is written once it is done. */
+    if(b_Scanning) {
+        DeferredBlockRange deferred = { fromRange, toRange, downloadedData };
+        m_DeferredBlockRanges.append(deferred);
+        return;
+    }
 
+    /* The target file was finished by the scan , ranges requested before are of no use. */
+    if(!b_Started) {
+        delete downloadedData;
+        emit blockRangeWritten(fromRange, toRange);
+        return;
+    }
 
     unsigned char md4sum[CHECKSUM_SIZE];
     /* Build checksum hash tables if we don't have them yet */
     if (!p_RsumHash) {
         if (!buildHash()) {
+            delete downloadedData;
+            emit blockRangeWritten(fromRange, toRange);
             emit error(CannotConstructHashTable);
             return;
         }
     }
 
-    /* Check if transfer speed time already started , if not start it. */
-    if(p_TransferSpeed->isNull()) {
-        p_TransferSpeed->start();
-    }
-
     bool Md4ChecksumsMatched = true;
     QScopedPointer<QByteArray> downloaded(downloadedData);
     QScopedPointer<QBuffer> buffer(new QBuffer(downloadedData));
@@ -350,8 +864,7 @@ void ZsyncWriterPrivate::writeBlockRanges(qint32 fromRange, qint32 toRange, QByt
                      * If integrity check failed , When we request required again
                      * , The p_RequiredRanges vector gets filled with needed blocks.
                      */
-                    if(!p_RequiredRanges.isEmpty())
-                        p_RequiredRanges.removeAll(qMakePair(bfrom, bto));
+                    removeRequiredRanges(bfrom, bto);
 
                 }
                 break;
@@ -365,34 +878,16 @@ void ZsyncWriterPrivate::writeBlockRanges(qint32 fromRange, qint32 toRange, QByt
         writeBlocks((const unsigned char*)downloadedData->constData(), bfrom, bto );
 
         /* Remove the blocks we written successfully. */
-        if(!p_RequiredRanges.isEmpty())
-            p_RequiredRanges.removeAll(qMakePair(bfrom, bto));
+        removeRequiredRanges(bfrom, bto);
     }
     INFO_START " writeBlockRanges : wrote block(" LOGR fromRange LOGR "," LOGR toRange LOGR ")." INFO_END; 
 
-    /* Calculate our progress. */
-    {
-        qint64 bytesReceived = n_BytesWritten, bytesTotal = n_TargetFileLength;
-        QString sUnit;
-        int nPercentage = static_cast<int>(
-                              (static_cast<float>
-                               (bytesReceived) * 100.0
-                              ) / static_cast<float>
-                              (bytesTotal)
-                          );
-        double nSpeed =  bytesReceived * 1000.0 / p_TransferSpeed->elapsed();
-        if (nSpeed < 1024) {
-            sUnit = "bytes/sec";
-        } else if (nSpeed < 1024 * 1024) {
-            nSpeed /= 1024;
-            sUnit = "kB/s";
-        } else {
-            nSpeed /= 1024 * 1024;
-            sUnit = "MB/s";
-        }
-        emit progress(nPercentage, bytesReceived, bytesTotal, nSpeed, sUnit);
-    }
-    if(p_RequiredRanges.isEmpty()){
+    /* Let the downloader know that the memory of this range is free again. */
+    emit blockRangeWritten(fromRange, toRange);
+
+    /* A range may also be known by a identical block or by a seed file. */
+    pruneRequiredRanges();
+    if(b_AllRangesPublished && p_RequiredRanges.isEmpty()){
 	    verifyAndConstructTargetFile();
     }
     emit statusChanged(Idle);
@@ -427,6 +922,7 @@ void ZsyncWriterPrivate::setConfiguration(qint32 blocksize,
     p_WeakCheckSumMask = n_WeakCheckSumBytes < 3 ? 0 : n_WeakCheckSumBytes == 3 ? 0xff : 0xffff;
     n_StrongCheckSumBytes = strongChecksumBytes;
     n_SeqMatches = seqMatches;
+    p_ScanKernel = selectScanKernel(n_SeqMatches, n_WeakCheckSumBytes, n_BlockShift);
     n_TargetFileLength = targetFileLength;
     p_TargetFileCheckSumBlocks.reset(targetFileCheckSumBlocks);
     n_Skip = n_NextKnown =p_HashMask = p_BitHashMask = 0;
@@ -445,7 +941,10 @@ void ZsyncWriterPrivate::setConfiguration(qint32 blocksize,
         n_Ranges = 0;
     }
     p_RequiredRanges.clear();
+    p_PublishedBlocks.fill(false, n_Blocks);
+    p_KnownBlocks->reset(n_Blocks, n_BlockSize, n_TargetFileLength);
     p_Md4Ctx->reset();
+    m_Statistics = ZsyncWriterStatistics();
 
     s_SourceFilePath = sourceFilePath;
     s_TargetFileName = targetFileName;
@@ -458,9 +957,19 @@ void ZsyncWriterPrivate::setConfiguration(qint32 blocksize,
     }
 
 
-    INFO_START " setConfiguration : creating temporary file." INFO_END;
     auto path = (s_OutputDirectory.isEmpty()) ? QFileInfo(s_SourceFilePath).path() : s_OutputDirectory;
     path = (path == "." ) ? QDir::currentPath() : path;
+    s_TargetFileDirectory = path;
+    j_SeedMatches = QJsonArray();
+
+    if(b_DryRun) {
+        /* Nothing is written in a dry run , so no temporary file is needed. */
+        p_TargetFile.reset();
+        emit finishedConfiguring();
+        return;
+    }
+
+    INFO_START " setConfiguration : creating temporary file." INFO_END;
     auto targetFilePath = path + "/" + s_TargetFileName + ".XXXXXXXXXX.part";
 
     QFileInfo perm(path);
@@ -487,19 +996,67 @@ void ZsyncWriterPrivate::setConfiguration(qint32 blocksize,
 /* cancels the started process. */
 void ZsyncWriterPrivate::cancel(void)
 {
+    if(b_WaitingForSeedScanSlot) {
+        b_WaitingForSeedScanSlot = false;
+        p_SeedScanLimiter->removeWaiter(this);
+        INFO_START " cancel : canceled while waiting for a seed scan slot." INFO_END;
+        emit canceled();
+        return;
+    }
     b_CancelRequested = b_Started;
     INFO_START " cancel : cancel requested " LOGR b_CancelRequested LOGR "." INFO_END;
     return;
 }
 
+/*
+ * Called by the seed scan limiter when it handed a free slot to us , the slot
+ * is given back if we were canceled meanwhile.
+*/
+void ZsyncWriterPrivate::handleSeedScanSlot(void)
+{
+    if(b_WaitingForSeedScanSlot) {
+        start();
+    }
+    p_SeedScanLimiter->releaseUnclaimed(this);
+    return;
+}
+
 /* start the zsync algorithm. */
 void ZsyncWriterPrivate::start(void)
 {
     if(b_Started)
         return;
-    b_CancelRequested = false;
+
+    /*
+     * When a seed scan limiter is shared with other writers , only a limited
+     * number of them can scan their seed files at the same time. The rest
+     * wait in its queue without blocking their thread , handleSeedScanSlot
+     * is called once a slot is handed to us.
+    */
+    if(p_SeedScanLimiter && !p_SeedScanLimiter->tryAcquire(this, "handleSeedScanSlot")) {
+        if(!b_WaitingForSeedScanSlot) {
+            INFO_START " start : waiting for a free seed scan slot." INFO_END;
+        }
+        b_WaitingForSeedScanSlot = true;
+        return;
+    }
+    b_WaitingForSeedScanSlot = false;
+    SeedScanSlotGuard seedScanSlotGuard(p_SeedScanLimiter);
+
+    b_CancelRequested = false;
     b_Started = true;
-    emit started();
+    b_RangesPublished = b_AllRangesPublished = b_DownloadRequested = false;
+    discardDeferredBlockRanges();
+    p_RequiredRanges.clear();
+    p_PublishedBlocks.fill(false, n_Blocks);
+    if(!b_DryRun) {
+        emit started();
+
+        /* Lets the downloader open its connections while we scan. */
+        if(b_AcceptRange && !u_TargetFileUrl.isEmpty()) {
+            emit seedScanStarted(u_TargetFileUrl);
+        }
+    }
 
     INFO_START " start : starting delta writer." INFO_END;
     short errorCode = 0;
@@ -513,7 +1070,7 @@ void ZsyncWriterPrivate::start(void)
         QStringList filters;
         filters << s_TargetFileName + ".*.part";
 
-        QDir dir(QFileInfo(p_TargetFile->fileName()).path());
+        QDir dir(s_TargetFileDirectory);
         auto foundGarbageFilesInfo = dir.entryInfoList(filters);
         QDir seedFileDir(QFileInfo(s_SourceFilePath).path());
         foundGarbageFilesInfo << seedFileDir.entryInfoList(filters);
@@ -527,7 +1084,9 @@ void ZsyncWriterPrivate::start(void)
             foundGarbageFiles << (*iter).absoluteFilePath();
             QCoreApplication::processEvents();
         }
-        foundGarbageFiles.removeAll(QFileInfo(p_TargetFile->fileName()).absoluteFilePath());
+        if(!p_TargetFile.isNull()) {
+            foundGarbageFiles.removeAll(QFileInfo(p_TargetFile->fileName()).absoluteFilePath());
+        }
         foundGarbageFiles.removeDuplicates();
     }
 
@@ -537,17 +1096,19 @@ void ZsyncWriterPrivate::start(void)
          * in the output of the target file directory.
         */
         {
-            QString alreadyDownloadedTargetFile = QFileInfo(p_TargetFile->fileName()).path() + "/" + s_TargetFileName;
+            QString alreadyDownloadedTargetFile = s_TargetFileDirectory + "/" + s_TargetFileName;
             QFileInfo info(alreadyDownloadedTargetFile);
             if(info.exists() && info.isReadable()) {
                 QFile *targetFile = nullptr;
                 if((errorCode = tryOpenSourceFile(alreadyDownloadedTargetFile, &targetFile)) > 0) {
+                    discardDeferredBlockRanges();
                     emit error(errorCode);
                     return;
                 }
 
                 if(submitSourceFile(targetFile) < 0) {
                     delete targetFile;
+                    discardDeferredBlockRanges();
                     b_Started = b_CancelRequested = false;
                     return;
                 }
@@ -561,39 +1122,75 @@ void ZsyncWriterPrivate::start(void)
                 ++iter) {
             QFile *sourceFile = nullptr;
             if((errorCode = tryOpenSourceFile(*iter, &sourceFile)) > 0) {
+                discardDeferredBlockRanges();
                 emit error(errorCode);
                 return;
             }
 
-            if(submitSourceFile(sourceFile) < 0) {
+            b_TransientSeed = true;
+            qint32 scanError = submitSourceFile(sourceFile);
+            b_TransientSeed = false;
+            if(scanError < 0) {
                 delete sourceFile;
+                discardDeferredBlockRanges();
                 b_Started = b_CancelRequested = false;
                 return;
             }
             delete sourceFile;
-            QFile::remove((*iter));
+            if(!b_DryRun) {
+                QFile::remove((*iter));
+            }
         }
 
 
         if(n_BytesWritten < n_TargetFileLength) {
             QFile *sourceFile = nullptr;
             if((errorCode = tryOpenSourceFile(s_SourceFilePath, &sourceFile)) > 0) {
+                discardDeferredBlockRanges();
                 emit error(errorCode);
                 return;
             }
 
-            if(submitSourceFile(sourceFile) < 0) {
+            /* Matches are only cached if nothing came from a earlier part file. */
+            b_MatchCacheSeed = (n_BytesWritten == 0);
+            qint32 scanError = submitSourceFile(sourceFile);
+            b_MatchCacheSeed = false;
+            if(scanError < 0) {
                 delete sourceFile;
+                discardDeferredBlockRanges();
                 b_Started = b_CancelRequested = false;
                 return;
             }
             delete sourceFile;
         }
+
+        /*
+         * The block store and the zero blocks are local and cheap , So they go
+         * before the extra seed files , which may publish the ranges still missing.
+        */
+        if(n_BytesWritten < n_TargetFileLength) {
+            submitBlockStore();
+        }
+
+        if(n_BytesWritten < n_TargetFileLength) {
+            submitZeroBlocks();
+        }
+
+        if(n_BytesWritten < n_TargetFileLength && submitExtraSeedFiles() < 0) {
+            discardDeferredBlockRanges();
+            b_Started = b_CancelRequested = false;
+            return;
+        }
     }
 
-    if(n_BytesWritten >= n_TargetFileLength) {
+    if(b_DryRun) {
+        emitPlan();
+    } else if(b_RangesPublished) {
+        finishEarlyDownload();
+    } else if(n_BytesWritten >= n_TargetFileLength) {
         verifyAndConstructTargetFile();
     } else {
+        b_DownloadRequested = true;
         emit download(n_BytesWritten, n_TargetFileLength, u_TargetFileUrl);
     }
     return;
@@ -670,9 +1267,69 @@ short ZsyncWriterPrivate::parseTargetFileCheckSumBlocks(void)
         free(p_BitHash);
         p_BitHash = NULL;
     }
+    groupIdenticalBlocks();
     return 0;
 }
 
+/*
+ * Groups the target blocks which have the same rsum and strong checksum ,
+ * like the zero padding of squashfs or resources bundled twice. Only one
+ * block of every group is downloaded , the data is copied to the others as
+ * soon as any of them is written , see replicateBlock.
+ *
+ * The group of the all zero block is remembered , Those blocks are never
+ * downloaded since the target file reads zero where nothing was written.
+*/
+void ZsyncWriterPrivate::groupIdenticalBlocks(void)
+{
+    p_BlockGroups.fill(-1, n_Blocks);
+    p_IdenticalBlocks.clear();
+    n_ZeroBlockGroup = -1;
+    n_BytesDeduplicated = n_BytesSynthesized = 0;
+    if((n_WeakCheckSumBytes + n_StrongCheckSumBytes) * 8 < MinGroupingCheckSumBits) {
+        return;
+    }
+
+    auto compare = [this](zs_blockid x, zs_blockid y) -> int {
+        int result = memcmp(&p_BlockHashes[x].r, &p_BlockHashes[y].r, sizeof(rsum));
+        return result ? result : memcmp(p_BlockHashes[x].checksum, p_BlockHashes[y].checksum, n_StrongCheckSumBytes);
+    };
+    QVector<zs_blockid> order(n_Blocks);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&compare](zs_blockid x, zs_blockid y) {
+        return compare(x, y) < 0 || (!compare(x, y) && x < y);
+    });
+
+    /* The checksums of a all zero block , the weak one is zero. */
+    hash_entry zero;
+    memset(&zero, 0, sizeof(zero));
+    {
+        QByteArray zeros(n_BlockSize, 0);
+        calcMd4Checksum(zero.checksum, reinterpret_cast<const unsigned char*>(zeros.constData()), n_BlockSize);
+    }
+
+    for(qint32 from = 0, to = 0; from < n_Blocks; from = to) {
+        to = from + 1;
+        while(to < n_Blocks && !compare(order.at(from), order.at(to))) {
+            ++to;
+        }
+        const hash_entry &e = p_BlockHashes[order.at(from)];
+        bool isZero = !memcmp(&e.r, &zero.r, sizeof(rsum)) && !memcmp(e.checksum, zero.checksum, n_StrongCheckSumBytes);
+        if(to - from < 2 && !isZero) {
+            continue;
+        }
+        qint32 group = p_IdenticalBlocks.size();
+        p_IdenticalBlocks.append(order.mid(from, to - from));
+        for(auto id : p_IdenticalBlocks.last()) {
+            p_BlockGroups[id] = group;
+        }
+        if(isZero) {
+            n_ZeroBlockGroup = group;
+        }
+    }
+    return;
+}
+
 /*
  * This is a private method which tries to open the given seed file
  * in the given path.
@@ -730,8 +1387,7 @@ bool ZsyncWriterPrivate::verifyAndConstructTargetFile(void)
 
     bool constructed = false;
     QString UnderConstructionFileSHA1;
-    qint64 bufferSize = 0;
-    QScopedPointer<QCryptographicHash> SHA1Hasher(new QCryptographicHash(QCryptographicHash::Sha1));
+    Sha1HasherPrivate SHA1Hasher;
 
     /*
      * Truncate and Seek.
@@ -741,21 +1397,24 @@ bool ZsyncWriterPrivate::verifyAndConstructTargetFile(void)
 
     INFO_START " verifyAndConstructTargetFile : calculating sha1 hash on temporary target file. " INFO_END;
     emit statusChanged(CalculatingTargetFileSha1Hash);
-    if(n_TargetFileLength >= 1073741824) { // 1 GiB and more.
-        bufferSize = 104857600; // copy per 100 MiB.
-    } else if(n_TargetFileLength >= 1048576 ) { // 1 MiB and more.
-        bufferSize = 1048576; // copy per 1 MiB.
-    } else if(n_TargetFileLength  >= 1024) { // 1 KiB and more.
-        bufferSize = 4096; // copy per 4 KiB.
-    } else { // less than 1 KiB
-        bufferSize = 1024; // copy per 1 KiB.
-    }
-
-    while(!p_TargetFile->atEnd()) {
-        SHA1Hasher->addData(p_TargetFile->read(bufferSize));
-        QCoreApplication::processEvents();
+    {
+        TraceScope traceScope("VerifyTargetFile");
+        /* Both powers of two , So every chunk but the last holds whole blocks. */
+        qint64 chunkSize = qMax(16777216, n_BlockSize); // hash per 16 MiB.
+        QByteArray chunk;
+        while(!p_TargetFile->atEnd()) {
+            chunk.resize(chunkSize);
+            qint64 bytesRead = p_TargetFile->read(chunk.data(), chunkSize);
+            if(bytesRead <= 0) {
+                break;
+            }
+            chunk.resize(bytesRead);
+            SHA1Hasher.addData(chunk.constData(), chunk.size());
+            collectBlocks(chunk);
+            QCoreApplication::processEvents();
+        }
+        UnderConstructionFileSHA1 = QString(SHA1Hasher.result().toHex().toUpper());
     }
-    UnderConstructionFileSHA1 = QString(SHA1Hasher->result().toHex().toUpper());
 
     INFO_START " verifyAndConstructTargetFile : comparing temporary target file sha1 hash(" LOGR UnderConstructionFileSHA1
     LOGR ") and remote target file sha1 hash(" LOGR s_TargetFileSHA1 INFO_END;
@@ -788,7 +1447,10 @@ bool ZsyncWriterPrivate::verifyAndConstructTargetFile(void)
                 newTargetFileName = s_TargetFileName;
             }
         }
-        p_TargetFile->rename(QFileInfo(p_TargetFile->fileName()).path() + "/" + newTargetFileName);
+        {
+            TraceScope traceScope("RenameTargetFile", QJsonObject { { "FileName", newTargetFileName } });
+            p_TargetFile->rename(QFileInfo(p_TargetFile->fileName()).path() + "/" + newTargetFileName);
+        }
 
         /*Set the same permission as the old version and close. */
         p_TargetFile->setPermissions(QFileInfo(s_SourceFilePath).permissions());
@@ -822,17 +1484,24 @@ bool ZsyncWriterPrivate::verifyAndConstructTargetFile(void)
  * block in the target file and update our state accordingly to indicate that
  * we have got that block successfully.
  *
+ * OnlyOne is true when we only check the single entry which follows a run of
+ * matches , see submitSourceData.
+ *
  * Return the number of blocks successfully obtained.
  */
-qint32 ZsyncWriterPrivate::checkCheckSumsOnHashChain(const struct hash_entry *e, const unsigned char *data,int onlyone)
+template <int SeqMatches, int WeakBytes, int BlockShift, bool OnlyOne>
+qint32 ZsyncWriterPrivate::checkHashChain(const struct hash_entry *e, const unsigned char *data)
 {
+    const unsigned short weakCheckSumMask = WeakBytes < 3 ? 0 : WeakBytes == 3 ? 0xff : 0xffff;
+    const qint32 bs = BlockShift ? (1 << BlockShift) : n_BlockSize;
     unsigned char md4sum[2][CHECKSUM_SIZE];
     signed int done_md4 = -1;
     qint32 got_blocks = 0;
+    quint64 chainEntries = 0; /* Counted once after the loop. */
     register rsum rs = p_CurrentWeakCheckSums.first;
 
     /* This is a hint to the caller that they should try matching the next
-     * block against a particular hash entry (because at least n_SeqMatches
+     * block against a particular hash entry (because at least SeqMatches
      * prior blocks to it matched in sequence). Clear it here and set it below
      * if and when we get such a set of matches. */
     p_NextMatch = NULL;
@@ -845,41 +1514,40 @@ qint32 ZsyncWriterPrivate::checkCheckSumsOnHashChain(const struct hash_entry *e,
         zs_blockid id;
 
         e = p_Rover;
-        p_Rover = onlyone ? NULL : e->next;
+        p_Rover = OnlyOne ? NULL : e->next;
 
         /* Check weak checksum first */
 
-        // HashHit++
-        if (e->r.a != (rs.a & p_WeakCheckSumMask) || e->r.b != rs.b) {
+        ++chainEntries;
+        if (e->r.a != (rs.a & weakCheckSumMask) || e->r.b != rs.b) {
             continue;
         }
 
         id = getHashEntryBlockId( e);
 
-        if (!onlyone && n_SeqMatches > 1
-                && (p_BlockHashes[id + 1].r.a != (p_CurrentWeakCheckSums.second.a & p_WeakCheckSumMask)
+        if (!OnlyOne && SeqMatches > 1
+                && (p_BlockHashes[id + 1].r.a != (p_CurrentWeakCheckSums.second.a & weakCheckSumMask)
                     || p_BlockHashes[id + 1].r.b != p_CurrentWeakCheckSums.second.b))
             continue;
 
-        // WeakHit++
+        STATISTICS_ADD(n_WeakHits, 1);
 
         {
             int ok = 1;
             signed int check_md4 = 0;
-            zs_blockid next_known = -1;
 
             /* This block at least must match; we must match at least
-             * n_SeqMatches-1 others, which could either be trailing stuff,
+             * SeqMatches-1 others, which could either be trailing stuff,
              * or these could be preceding blocks that we have verified
              * already. */
             do {
                 /* We only calculate the MD4 once we need it; but need not do so twice */
                 if (check_md4 > done_md4) {
                     calcMd4Checksum(&md4sum[check_md4][0],
-                                    data + n_BlockSize * check_md4,
-                                    n_BlockSize);
+                                    data + bs * check_md4,
+                                    bs);
                     done_md4 = check_md4;
-                    // Checksummed++
+                    STATISTICS_ADD(n_Md4Computations, 1);
                 }
 
                 /* Now check the strong checksum for this block */
@@ -887,11 +1555,9 @@ qint32 ZsyncWriterPrivate::checkCheckSumsOnHashChain(const struct hash_entry *e,
                            &p_BlockHashes[id + check_md4].checksum[0],
                            n_StrongCheckSumBytes)) {
                     ok = 0;
-                } else if (next_known == -1) {
                 }
                 check_md4++;
-                QCoreApplication::processEvents();
-            } while (ok && !onlyone && check_md4 < n_SeqMatches);
+            } while (ok && !OnlyOne && check_md4 < SeqMatches);
 
             if (ok) {
                 qint32 num_write_blocks;
@@ -899,16 +1565,16 @@ qint32 ZsyncWriterPrivate::checkCheckSumsOnHashChain(const struct hash_entry *e,
                 /* Find the next block that we already have data for. If this
                  * is part of a run of matches then we have this stored already
                  * as ->next_known. */
-                zs_blockid next_known = onlyone ? n_NextKnown : nextKnownBlock( id);
+                zs_blockid next_known = OnlyOne ? n_NextKnown : nextKnownBlock( id);
 
-                // stronghit++
+                STATISTICS_ADD(n_StrongHits, 1);
 
                 if (next_known > id + check_md4) {
                     num_write_blocks = check_md4;
 
                     /* Save state for this run of matches */
                     p_NextMatch = &(p_BlockHashes[id + check_md4]);
-                    if (!onlyone) n_NextKnown = next_known;
+                    if (!OnlyOne) n_NextKnown = next_known;
                 } else {
                     /* We've reached the EOF, or data we already know. Just
                      * write out the blocks we don't know, and that's the end
@@ -922,6 +1588,7 @@ qint32 ZsyncWriterPrivate::checkCheckSumsOnHashChain(const struct hash_entry *e,
             }
         }
     }
+    STATISTICS_ADD(n_ChainEntries, chainEntries);
     return got_blocks;
 }
 
@@ -941,16 +1608,30 @@ qint32 ZsyncWriterPrivate::checkCheckSumsOnHashChain(const struct hash_entry *e,
  *        e.g. because we've just matched a block and the forward jump takes
  *        us past the end of the buffer
  * p_CurrentWeakCheckSums.first - rolling checksum of the first blocksize bytes of the buffer
- * p_CurrentWeakCheckSums.second - rolling checksum of the next blocksize bytes of the buffer (if n_SeqMatches > 1)
+ * p_CurrentWeakCheckSums.second - rolling checksum of the next blocksize bytes of the buffer (if SeqMatches > 1)
+ *
+ * The kernel is instantiated for every seq_matches , weak checksum length and
+ * the common block sizes (BlockShift 0 is any other block size) , So the per
+ * byte loop has no branches on the configuration. setConfiguration selects
+ * the instance once per target file , see selectScanKernel.
  */
-qint32 ZsyncWriterPrivate::submitSourceData(unsigned char *data,size_t len, off_t offset)
+template <int SeqMatches, int WeakBytes, int BlockShift>
+qint32 ZsyncWriterPrivate::scanSourceData(unsigned char *data,size_t len, off_t offset)
 {
+    const unsigned short weakCheckSumMask = WeakBytes < 3 ? 0 : WeakBytes == 3 ? 0xff : 0xffff;
+    const qint32 bs = BlockShift ? (1 << BlockShift) : n_BlockSize;
+    const qint32 bshift = BlockShift ? BlockShift : n_BlockShift;
+    const size_t context = bs * SeqMatches;
+
     /* The window in data[] currently being considered is
      * [x, x+bs)
      */
     qint32 x = 0;
-    register qint32 bs = n_BlockSize;
     qint32 got_blocks = 0;
+    quint64 bitHashProbes = 0, /* Counted once after the loop. */
+            bytesRolled = 0;
+    rsum first = p_CurrentWeakCheckSums.first,
+         second = p_CurrentWeakCheckSums.second;
 
     if (offset) {
         x = n_Skip;
@@ -958,18 +1639,24 @@ qint32 ZsyncWriterPrivate::submitSourceData(unsigned char *data,size_t len, off_
         p_NextMatch = NULL;
     }
 
+    /* The skip goes past this buffer , i.e it is the short end of a range. */
+    if ((size_t)x + context > len) {
+        n_Skip = x + context - len;
+        return got_blocks;
+    }
+
     if (x || !offset) {
-        p_CurrentWeakCheckSums.first = calc_rsum_block(data + x, bs);
-        if (n_SeqMatches > 1)
-            p_CurrentWeakCheckSums.second = calc_rsum_block(data + x + bs, bs);
+        first = calc_rsum_block(data + x, bs);
+        if (SeqMatches > 1)
+            second = calc_rsum_block(data + x + bs, bs);
     }
     n_Skip = 0;
 
     /* Work through the block until the current blocksize bytes being
      * considered, starting at x, is at the end of the buffer */
     for (;;) {
-        if ((size_t)(x + n_Context) == len) {
-            return got_blocks;
+        if ((size_t)x + context == len) {
+            break;
         }
         {
             /* # of blocks of the output file we got from this data */
@@ -982,8 +1669,9 @@ qint32 ZsyncWriterPrivate::submitSourceData(unsigned char *data,size_t len, off_
             /* If the previous block was a match, but we're looking for
              * sequential matches, then test this block against the block in
              * the target immediately after our previous hit. */
-            if (p_NextMatch && n_SeqMatches > 1) {
-                if (0 != (thismatch = checkCheckSumsOnHashChain( p_NextMatch, data + x, 1))) {
+            if (SeqMatches > 1 && p_NextMatch) {
+                p_CurrentWeakCheckSums = qMakePair(first, second);
+                if (0 != (thismatch = checkHashChain<SeqMatches, WeakBytes, BlockShift, true>(p_NextMatch, data + x))) {
                     blocks_matched = 1;
                 }
             }
@@ -992,17 +1680,19 @@ qint32 ZsyncWriterPrivate::submitSourceData(unsigned char *data,size_t len, off_
 
                 /* Do a hash table lookup - first in the p_BitHash (fast negative
                  * check) and then in the rsum hash */
-                unsigned hash = p_CurrentWeakCheckSums.first.b;
-                hash ^= ((n_SeqMatches > 1) ? p_CurrentWeakCheckSums.second.b
-                         : p_CurrentWeakCheckSums.first.a & p_WeakCheckSumMask) << BITHASHBITS;
+                unsigned hash = first.b;
+                hash ^= ((SeqMatches > 1) ? second.b : first.a & weakCheckSumMask) << BITHASHBITS;
+                ++bitHashProbes;
                 if ((p_BitHash[(hash & p_BitHashMask) >> 3] & (1 << (hash & 7))) != 0
                         && (e = p_RsumHash[hash & p_HashMask]) != NULL) {
+                    STATISTICS_ADD(n_BucketHits, 1);
 
                     /* Okay, we have a hash hit. Follow the hash chain and
                      * check our block against all the entries. */
-                    thismatch = checkCheckSumsOnHashChain( e, data + x, 0);
+                    p_CurrentWeakCheckSums = qMakePair(first, second);
+                    thismatch = checkHashChain<SeqMatches, WeakBytes, BlockShift, false>(e, data + x);
                     if (thismatch)
-                        blocks_matched = n_SeqMatches;
+                        blocks_matched = SeqMatches;
                 }
             }
             got_blocks += thismatch;
@@ -1013,23 +1703,23 @@ qint32 ZsyncWriterPrivate::submitSourceData(unsigned char *data,size_t len, off_
             if (blocks_matched) {
                 x += bs + (blocks_matched > 1 ? bs : 0);
 
-                if ((size_t)(x + n_Context) > len) {
+                if ((size_t)x + context > len) {
                     /* can't calculate rsum for block after this one, because
                      * it's not in the buffer. So leave a hint for next time so
                      * we know we need to recalculate */
-                    n_Skip = x + n_Context - len;
-                    return got_blocks;
+                    n_Skip = x + context - len;
+                    break;
                 }
 
                 /* If we are moving forward just 1 block, we already have the
                  * following block rsum. If we are skipping both, then
                  * recalculate both */
-                if (n_SeqMatches > 1 && blocks_matched == 1)
-                    p_CurrentWeakCheckSums.first = p_CurrentWeakCheckSums.second;
+                if (SeqMatches > 1 && blocks_matched == 1)
+                    first = second;
                 else
-                    p_CurrentWeakCheckSums.first = calc_rsum_block(data + x, bs);
-                if (n_SeqMatches > 1)
-                    p_CurrentWeakCheckSums.second = calc_rsum_block(data + x + bs, bs);
+                    first = calc_rsum_block(data + x, bs);
+                if (SeqMatches > 1)
+                    second = calc_rsum_block(data + x + bs, bs);
                 continue;
             }
         }
@@ -1037,15 +1727,89 @@ qint32 ZsyncWriterPrivate::submitSourceData(unsigned char *data,size_t len, off_
         /* Else - advance the window by 1 byte - update the rolling checksum
          * and our offset in the buffer */
         {
-            unsigned char Nc = data[x + bs * 2];
             unsigned char nc = data[x + bs];
             unsigned char oc = data[x];
-            UPDATE_RSUM(p_CurrentWeakCheckSums.first.a, p_CurrentWeakCheckSums.first.b, oc, nc, n_BlockShift);
-            if (n_SeqMatches > 1)
-                UPDATE_RSUM(p_CurrentWeakCheckSums.second.a, p_CurrentWeakCheckSums.second.b, nc, Nc, n_BlockShift);
+            UPDATE_RSUM(first.a, first.b, oc, nc, bshift);
+            if (SeqMatches > 1) {
+                unsigned char Nc = data[x + bs * 2];
+                UPDATE_RSUM(second.a, second.b, nc, Nc, bshift);
+            }
         }
+        ++bytesRolled;
         x++;
     }
+    STATISTICS_ADD(n_BitHashProbes, bitHashProbes);
+    STATISTICS_ADD(n_BytesRolled, bytesRolled);
+    p_CurrentWeakCheckSums = qMakePair(first, second);
+    return got_blocks;
+}
+
+/* Instances of the scan kernel for one seq_matches and weak checksum length. */
+#define SCAN_KERNELS(seqMatches, weakBytes) \
+    { &ZsyncWriterPrivate::scanSourceData<seqMatches, weakBytes, 0>, \
+      &ZsyncWriterPrivate::scanSourceData<seqMatches, weakBytes, 10>, \
+      &ZsyncWriterPrivate::scanSourceData<seqMatches, weakBytes, 11>, \
+      &ZsyncWriterPrivate::scanSourceData<seqMatches, weakBytes, 12> }
+
+/*
+ * Returns the scan kernel for the given configuration. Block sizes of
+ * 1 , 2 and 4 KiB get their own instance , Every other block size uses
+ * the generic one.
+*/
+ZsyncWriterPrivate::ScanKernel ZsyncWriterPrivate::selectScanKernel(qint32 seqMatches, qint32 weakBytes, qint32 blockShift)
+{
+    static const ScanKernel kernels[2][3][4] = {
+        { SCAN_KERNELS(1, 2), SCAN_KERNELS(1, 3), SCAN_KERNELS(1, 4) },
+        { SCAN_KERNELS(2, 2), SCAN_KERNELS(2, 3), SCAN_KERNELS(2, 4) }
+    };
+    /* 1 and 2 bytes of weak checksum both mask out the first 16 bits. */
+    int seqIndex = seqMatches > 1 ? 1 : 0,
+        weakIndex = weakBytes <= 2 ? 0 : weakBytes == 3 ? 1 : 2,
+        shiftIndex = (blockShift >= 10 && blockShift <= 12) ? blockShift - 9 : 0;
+    return kernels[seqIndex][weakIndex][shiftIndex];
+}
+#undef SCAN_KERNELS
+
+/* Runs the scan kernel selected in setConfiguration over the given data. */
+qint32 ZsyncWriterPrivate::submitSourceData(unsigned char *data,size_t len, off_t offset)
+{
+    auto got = (this->*p_ScanKernel)(data, len, offset);
+    flushStatistics();
+    return got;
+}
+
+/*
+ * Runs only the scan kernel over the given data as if it was a whole seed
+ * file , without reading a file , the aligned pass or the match cache. Used
+ * by the benchmarks to time the kernel alone , the writer must be configured
+ * for a dry run.
+ * Returns the number of blocks found or -1.
+*/
+qint32 ZsyncWriterPrivate::scanSeedData(const QByteArray &data)
+{
+    if(!b_DryRun || (!p_RsumHash && !buildHash())) {
+        return -1;
+    }
+    /* The kernel stops n_Context bytes before the end , just like the mapped scan. */
+    QByteArray buffer(data);
+    buffer.append(QByteArray(n_Context, 0));
+    return submitSourceData(reinterpret_cast<unsigned char*>(buffer.data()), buffer.size(), 0);
+}
+
+/* Moves the counters of the current thread to this writer. */
+void ZsyncWriterPrivate::flushStatistics(void)
+{
+#ifndef STATISTICS_DISABLED
+    m_Statistics.n_BitHashProbes += m_ThreadStatistics.n_BitHashProbes;
+    m_Statistics.n_BucketHits += m_ThreadStatistics.n_BucketHits;
+    m_Statistics.n_ChainEntries += m_ThreadStatistics.n_ChainEntries;
+    m_Statistics.n_WeakHits += m_ThreadStatistics.n_WeakHits;
+    m_Statistics.n_Md4Computations += m_ThreadStatistics.n_Md4Computations;
+    m_Statistics.n_StrongHits += m_ThreadStatistics.n_StrongHits;
+    m_Statistics.n_BytesRolled += m_ThreadStatistics.n_BytesRolled;
+    m_ThreadStatistics = ZsyncWriterStatistics();
+#endif // STATISTICS_DISABLED
+    return;
 }
 
 /* Read the given stream, applying the rsync rolling checksum algorithm to
@@ -1058,28 +1822,348 @@ qint32 ZsyncWriterPrivate::submitSourceFile(QFile *file)
         return 0;
     }
 
+    TraceScope traceScope("SeedScan", QJsonObject { { "AbsolutePath", QFileInfo(file->fileName()).absoluteFilePath() } });
     qint32 error = 0;
-    off_t in = 0;
-    /* Allocate buffer of 16 blocks */
-    register qint32 bufsize = n_BlockSize * 16;
-    unsigned char *buf = (unsigned char*)malloc(bufsize + n_Context);
-    if (!buf)
-        return (error = -1);
 
     /* Build checksum hash tables ready to analyse the blocks we find */
     if (!p_RsumHash)
         if (!buildHash()) {
-            free(buf);
             return (error = -2);
         }
 
-    if(p_TransferSpeed.isNull()) {
-        p_TransferSpeed.reset(new QTime);
-    } else if(!p_TransferSpeed->isNull()) {
-        p_TransferSpeed.reset(new QTime);
+    if(p_Progress && !b_RangesPublished) {
+        p_Progress->begin(n_BytesWritten, n_TargetFileLength);
+    }
+    qint64 bytesWrittenBefore = n_BytesWritten;
+
+    /*
+     * Scan the seed right from the page cache if we can map it , Files which
+     * cannot be mapped(i.e pipes and some network filesystems) are read.
+    */
+    n_SeedHandle = file->handle();
+    n_SeedSize = file->size();
+    b_CloneSupported = b_CopyRangeSupported = true;
+    uchar *map = file->size() > 0 ? file->map(0, file->size()) : nullptr;
+    bool useMatchCache = b_MatchCacheSeed && !s_SourceFileSHA1.isEmpty() && !s_TargetFileSHA1.isEmpty(),
+         cached = false;
+    if(map && useMatchCache) {
+        error = submitCachedMatches(file, map, &cached);
+    }
+    if(!error && !cached) {
+        m_MatchExtents.clear();
+        b_RecordingMatches = useMatchCache;
+        if(map) {
+            error = submitMappedSourceFile(file, map);
+        } else {
+            error = submitBufferedSourceFile(file);
+        }
+        b_RecordingMatches = false;
+        if(!error && useMatchCache) {
+            ZsyncMatchCachePrivate::save(matchCacheDirectory(), s_SourceFileSHA1, s_TargetFileSHA1,
+                                         n_BlockSize, n_Blocks, m_MatchExtents);
+        }
+        m_MatchExtents.clear();
+    }
+    flushSeedExtent();
+    n_SeedHandle = -1;
+    p_ScanBase = nullptr;
+    if(map) {
+        file->unmap(map);
+    }
+
+    if(!error) {
+        qint64 matchedBytes = qMin(n_BytesWritten, static_cast<qint64>(n_TargetFileLength)) -
+                              qMin(bytesWrittenBefore, static_cast<qint64>(n_TargetFileLength));
+        j_SeedMatches.append(QJsonObject {
+            { "AbsolutePath", QFileInfo(file->fileName()).absoluteFilePath() },
+            { "MatchedBytes", matchedBytes },
+            { "MatchRatio", n_TargetFileLength ? static_cast<double>(matchedBytes) / n_TargetFileLength : 0.0 }
+        });
+    }
+    file->close();
+    return error;
+}
+
+/*
+ * Scans a mapped seed file , First its aligned blocks are matched with the
+ * help of the seed index and then the rolling scan goes over the regions
+ * which were not matched.
+*/
+qint32 ZsyncWriterPrivate::submitMappedSourceFile(QFile *file, uchar *map)
+{
+    const qint64 fileSize = file->size();
+    madvise(map, fileSize, MADV_SEQUENTIAL);
+
+    /* Blocks which kept their offset are matched without rolling over them. */
+    QVector<bool> matched;
+    qint32 error = submitAlignedBlocks(file, map, &matched);
+    if(error) {
+        return error;
+    }
+
+    /*
+     * Roll over every run of blocks the aligned pass did not match , starting
+     * n_Context bytes early so windows which overlap the run are tried too.
+     * The zero padded last block counts as not matched.
+    */
+    const qint64 count = (fileSize + n_BlockSize - 1) / n_BlockSize;
+    matched.resize(static_cast<int>(count));
+    for(qint64 i = 0; i < count;) {
+        if(matched.at(static_cast<int>(i))) {
+            ++i;
+            continue;
+        }
+        qint64 j = i;
+        while(j < count && !matched.at(static_cast<int>(j))) {
+            ++j;
+        }
+        qint64 from = qMax(static_cast<qint64>(0), i * n_BlockSize - n_Context),
+               to = qMin(fileSize, j * n_BlockSize);
+        if((error = submitMappedRange(map, fileSize, from, to))) {
+            return error;
+        }
+        i = j;
+    }
+    return 0;
+}
+
+/*
+ * Matches the aligned blocks of the given seed against the target directly ,
+ * with their checksums from the seed index. A block matches if its rsum and
+ * MD4 checksum are the same as of a target block , and so are the ones of the
+ * next block if the control file asks for sequential matches.
+ *
+ * Sets a flag for every aligned seed block which was used.
+*/
+qint32 ZsyncWriterPrivate::submitAlignedBlocks(QFile *file, uchar *map, QVector<bool> *matched)
+{
+    TraceScope traceScope("AlignedPass");
+    auto blocks = ZsyncSeedIndexPrivate::get(seedIndexDirectory(), file, map, n_BlockSize,
+                  n_StrongCheckSumBytes, p_WorkerPool);
+    matched->fill(false, blocks.size());
+
+    p_ScanBase = map;
+    n_ScanBaseOffset = 0;
+    n_ScanLength = file->size();
+    for(int i = 0; i < blocks.size(); ++i) {
+        const rsum &r = blocks.at(i).r;
+        rsum next = { 0, 0 };
+        if(n_SeqMatches > 1) {
+            if(i + 1 >= blocks.size()) {
+                break; /* The rolling scan pairs it with the zero padding. */
+            }
+            next = blocks.at(i + 1).r;
+        }
+
+        unsigned hash = r.b;
+        hash ^= ((n_SeqMatches > 1) ? next.b : r.a & p_WeakCheckSumMask) << BITHASHBITS;
+        const hash_entry *e;
+        if ((p_BitHash[(hash & p_BitHashMask) >> 3] & (1 << (hash & 7))) == 0
+                || (e = p_RsumHash[hash & p_HashMask]) == NULL) {
+            continue;
+        }
+
+        /* writeBlocks removes the written block from the chain , see p_Rover. */
+        p_Rover = e;
+        while (p_Rover) {
+            e = p_Rover;
+            p_Rover = e->next;
+            if (e->r.a != (r.a & p_WeakCheckSumMask) || e->r.b != r.b) {
+                continue;
+            }
+            zs_blockid id = getHashEntryBlockId(e);
+            if (n_SeqMatches > 1
+                    && (p_BlockHashes[id + 1].r.a != (next.a & p_WeakCheckSumMask)
+                        || p_BlockHashes[id + 1].r.b != next.b
+                        || memcmp(blocks.at(i + 1).checksum, p_BlockHashes[id + 1].checksum, n_StrongCheckSumBytes))) {
+                continue;
+            }
+            if (memcmp(blocks.at(i).checksum, p_BlockHashes[id].checksum, n_StrongCheckSumBytes)) {
+                continue;
+            }
+            WRITER_STATISTICS_ADD(n_AlignedMatches, 1);
+            writeBlocks(map + static_cast<qint64>(i) * n_BlockSize, id, id);
+            (*matched)[i] = true;
+        }
+
+        if(!(i % 4096) && hasScanBeenCanceled()) {
+            p_ScanBase = nullptr;
+            return -3;
+        }
+    }
+    p_ScanBase = nullptr;
+    return 0;
+}
+
+/*
+ * Places the matches of the source file from the match cache instead of
+ * scanning it. Every block is checked against its MD4 checksum before it is
+ * written , Blocks which do not match are left to the download.
+ *
+ * Sets applied to false if there is no cache for this version pair.
+*/
+qint32 ZsyncWriterPrivate::submitCachedMatches(QFile *file, uchar *map, bool *applied)
+{
+    QVector<ZsyncMatchCachePrivate::Extent> extents;
+    *applied = ZsyncMatchCachePrivate::load(matchCacheDirectory(), s_SourceFileSHA1, s_TargetFileSHA1,
+                                            n_BlockSize, n_Blocks, &extents);
+    if(!*applied) {
+        return 0;
+    }
+
+    TraceScope traceScope("MatchCache");
+    INFO_START " submitCachedMatches : placing " LOGR extents.size() LOGR " cached extents." INFO_END;
+    const qint64 fileSize = file->size();
+    QByteArray padded(n_BlockSize, 0);
+    unsigned char md4sum[CHECKSUM_SIZE];
+    qint32 rejected = 0, checked = 0;
+
+    p_ScanBase = map;
+    n_ScanBaseOffset = 0;
+    n_ScanLength = fileSize;
+    for(auto iter = extents.constBegin(), end = extents.constEnd(); iter != end; ++iter) {
+        for(qint32 i = 0; i < (*iter).blockCount; ++i) {
+            zs_blockid id = (*iter).firstBlock + i;
+            qint64 offset = (*iter).seedOffset + static_cast<qint64>(i) * n_BlockSize;
+            if(offset >= fileSize || alreadyGotBlock(id)) {
+                continue;
+            }
+
+            /* The last block of the seed is zero padded like in the scan. */
+            const unsigned char *data = map + offset;
+            if(offset + n_BlockSize > fileSize) {
+                padded.fill(0);
+                memcpy(padded.data(), map + offset, fileSize - offset);
+                data = reinterpret_cast<const unsigned char*>(padded.constData());
+            }
+            calcMd4Checksum(md4sum, data, n_BlockSize);
+            if(memcmp(md4sum, p_BlockHashes[id].checksum, n_StrongCheckSumBytes)) {
+                ++rejected;
+                continue;
+            }
+            writeBlocks(data, id, id);
+
+            if(!(++checked % 4096) && hasScanBeenCanceled()) {
+                p_ScanBase = nullptr;
+                return -3;
+            }
+        }
+    }
+    p_ScanBase = nullptr;
+    if(rejected) {
+        WARNING_START " submitCachedMatches : " LOGR rejected LOGR " cached blocks did not match." WARNING_END;
+    }
+    return 0;
+}
+
+/* Adds the given written blocks to the matches of the source file. */
+void ZsyncWriterPrivate::recordMatch(const unsigned char *data, zs_blockid bfrom, zs_blockid bto)
+{
+    if(!b_RecordingMatches || b_Replicating || !p_ScanBase ||
+       data < p_ScanBase || data >= p_ScanBase + n_ScanLength) {
+        return;
+    }
+    qint64 seedOffset = n_ScanBaseOffset + (data - p_ScanBase);
+    qint32 count = bto - bfrom + 1;
+    if(!m_MatchExtents.isEmpty()) {
+        auto &last = m_MatchExtents.last();
+        if(last.firstBlock + last.blockCount == bfrom &&
+           last.seedOffset + static_cast<qint64>(last.blockCount) * n_BlockSize == seedOffset) {
+            last.blockCount += count;
+            return;
+        }
+    }
+    ZsyncMatchCachePrivate::Extent extent = { seedOffset, bfrom, count };
+    m_MatchExtents.append(extent);
+    return;
+}
+
+/*
+ * The seed index is kept next to the block store , So nothing is written to
+ * the disk unless a block store is used. Part files are never indexed since
+ * they are removed right after the scan.
+*/
+QString ZsyncWriterPrivate::seedIndexDirectory(void) const
+{
+    if(b_TransientSeed || p_BlockStore.isNull()) {
+        return QString();
+    }
+    return p_BlockStore->directory() + "/seedindex";
+}
+
+QString ZsyncWriterPrivate::matchCacheDirectory(void) const
+{
+    if(!s_MatchCacheDirectory.isEmpty()) {
+        return s_MatchCacheDirectory;
+    }
+    return p_BlockStore.isNull() ? QString() : p_BlockStore->directory() + "/matchcache";
+}
+
+/*
+ * Tries every window of the mapped seed which starts in [from, to) , The
+ * mapping is given to the scan kernel in large chunks , each overlapping the
+ * previous one by n_Context bytes just like the buffered scan. Only the last
+ * chunk is copied , since the kernel needs n_Context zero bytes after the end
+ * of the file.
+ *
+ * Pages behind the cursor are dropped as we go , So scanning a huge seed does
+ * not push everything else out of the memory.
+*/
+qint32 ZsyncWriterPrivate::submitMappedRange(uchar *map, qint64 fileSize, qint64 from, qint64 to)
+{
+    const qint64 chunkSize = qMax(MappedScanChunkSize, static_cast<qint64>(n_Context) * 4),
+                 end = to + n_Context; /* The last window needs n_Context bytes. */
+    const qint64 pageSize = sysconf(_SC_PAGESIZE);
+    qint64 position = from,
+           dropped = (from / pageSize) * pageSize;
+
+    /* A offset of 0 starts a new stream for the scan kernel. */
+    while (position + chunkSize <= qMin(end, fileSize)) {
+        p_ScanBase = map + position;
+        n_ScanBaseOffset = position;
+        n_ScanLength = chunkSize;
+        submitSourceData(map + position, chunkSize, position == from ? 0 : position);
+        position += chunkSize - n_Context;
+
+        qint64 behind = (position / pageSize) * pageSize;
+        if(behind > dropped) {
+            madvise(map + dropped, behind - dropped, MADV_DONTNEED);
+            dropped = behind;
+        }
+        if(hasScanBeenCanceled()) {
+            p_ScanBase = nullptr;
+            return -3;
+        }
+    }
+
+    /* The rest of the range , 0 padded after the end of the file. */
+    qint64 rest = end - position;
+    unsigned char *buf = (unsigned char*)calloc(rest, 1);
+    if (!buf) {
+        p_ScanBase = nullptr;
+        return -1;
     }
+    memcpy(buf, map + position, qMin(end, fileSize) - position);
+    p_ScanBase = buf;
+    n_ScanBaseOffset = position;
+    n_ScanLength = rest;
+    submitSourceData(buf, rest, position == from ? 0 : position);
+    p_ScanBase = nullptr;
+    free(buf);
+    return hasScanBeenCanceled() ? -3 : 0;
+}
+
+/* Reads the seed file into a buffer , refilling it as the scan moves on. */
+qint32 ZsyncWriterPrivate::submitBufferedSourceFile(QFile *file)
+{
+    off_t in = 0;
+    /* Allocate buffer of at least 16 blocks */
+    register qint32 bufsize = qMax(n_BlockSize * 16, (BufferedScanSize / n_BlockSize) * n_BlockSize);
+    unsigned char *buf = (unsigned char*)malloc(bufsize + n_Context);
+    if (!buf)
+        return -1;
 
-    p_TransferSpeed->start();
+    posix_fadvise(file->handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
     while (!file->atEnd()) {
         size_t len;
         off_t start_in = in;
@@ -1104,55 +2188,325 @@ qint32 ZsyncWriterPrivate::submitSourceFile(QFile *file)
         }
 
         /* Process the data in the buffer, and report progress */
+        p_ScanBase = buf;
+        n_ScanBaseOffset = start_in;
+        n_ScanLength = len;
         submitSourceData( buf, len, start_in);
+        if(hasScanBeenCanceled()) {
+            p_ScanBase = nullptr;
+            free(buf);
+            return -3;
+        }
+    }
+    p_ScanBase = nullptr;
+    free(buf);
+    return 0;
+}
+
+/* Reports the progress of the seed scan , returns true if it was canceled. */
+bool ZsyncWriterPrivate::hasScanBeenCanceled(void)
+{
+    /* Once the ranges are published the downloader reports the progress. */
+    if(p_Progress && !b_RangesPublished) {
+        p_Progress->setBytes(n_BytesWritten);
+    }
+    QCoreApplication::processEvents();
+    if(b_CancelRequested == true) {
+        b_CancelRequested = false;
+
+        /* The downloader is canceled too and reports it. */
+        if(!b_RangesPublished) {
+            emit canceled();
+        }
+        return true;
+    }
+    return false;
+}
+
+
+
+/*
+ * Scans the extra seed files given by the user or found in the seed directories ,
+ * best matching first , until all blocks of the target file are known.
+ * Seed files which cannot be opened are skipped.
+ * Returns a negative value if canceled.
+*/
+qint32 ZsyncWriterPrivate::submitExtraSeedFiles(void)
+{
+    auto seedFiles = discoverSeedFiles();
+    if(seedFiles.isEmpty()) {
+        return 0;
+    }
+
+    if (!p_RsumHash && !buildHash()) {
+        return 0;
+    }
+
+    /* Rank by a sampled estimate , the blocks found so far are already out of the hash. */
+    QVector<QPair<qint32, QString>> rankedSeedFiles;
+    qint64 seedBlocks = 0;
+    for(auto iter = seedFiles.constBegin(), end = seedFiles.constEnd(); iter != end; ++iter) {
+        QFile *seedFile = nullptr;
+        if(tryOpenSourceFile(*iter, &seedFile) > 0 || !seedFile) {
+            WARNING_START " submitExtraSeedFiles : cannot open seed file " LOGR *iter LOGR "." WARNING_END;
+            continue;
+        }
+        auto estimate = estimateSeedMatches(seedFile);
+        delete seedFile;
+        INFO_START " submitExtraSeedFiles : " LOGR *iter LOGR " may hold " LOGR estimate LOGR " missing blocks." INFO_END;
+        seedBlocks += estimate;
+        rankedSeedFiles.append(qMakePair(estimate, *iter));
+        QCoreApplication::processEvents();
+    }
+    std::stable_sort(rankedSeedFiles.begin(), rankedSeedFiles.end(),
+    [](const QPair<qint32, QString> &a, const QPair<qint32, QString> &b) {
+        return a.first > b.first;
+    });
+
+    publishRangesEarly(seedBlocks);
+    for(auto iter = rankedSeedFiles.constBegin(), end = rankedSeedFiles.constEnd();
+            iter != end && n_BytesWritten < n_TargetFileLength;
+            ++iter) {
+        QFile *seedFile = nullptr;
+        if(tryOpenSourceFile((*iter).second, &seedFile) > 0 || !seedFile) {
+            continue;
+        }
+        if(submitSourceFile(seedFile) < 0) {
+            delete seedFile;
+            return -1;
+        }
+        delete seedFile;
+    }
+    return 0;
+}
+
+/*
+ * Returns the extra seed files , The seed files given by the user are taken
+ * as they are , Files in the seed directories are only taken if they embed
+ * the same update information as the source file.
+*/
+QStringList ZsyncWriterPrivate::discoverSeedFiles(void)
+{
+    QStringList seedFiles = m_SeedFiles;
+    if(!m_SeedDirectories.isEmpty()) {
+        QString sourceUpdateString;
         {
-            qint64 bytesReceived = n_BytesWritten,
-                   bytesTotal = n_TargetFileLength;
-
-            int nPercentage = static_cast<int>(
-                                  (static_cast<float>
-                                   ( bytesReceived ) * 100.0
-                                  ) / static_cast<float>
-                                  (
-                                      bytesTotal
-                                  )
-                              );
-
-            double nSpeed =  bytesReceived * 1000.0 / p_TransferSpeed->elapsed();
-            QString sUnit;
-            if (nSpeed < 1024) {
-                sUnit = "bytes/sec";
-            } else if (nSpeed < 1024 * 1024) {
-                nSpeed /= 1024;
-                sUnit = "kB/s";
-            } else {
-                nSpeed /= 1024 * 1024;
-                sUnit = "MB/s";
+            QFile sourceFile(s_SourceFilePath);
+            if(sourceFile.open(QIODevice::ReadOnly)) {
+                AppImageUpdateInformationPrivate::readUpdateString(&sourceFile, &sourceUpdateString);
             }
+        }
 
-            emit progress(nPercentage, bytesReceived, bytesTotal, nSpeed, sUnit);
+        for(auto iter = m_SeedDirectories.constBegin(), end = m_SeedDirectories.constEnd();
+                iter != end && !sourceUpdateString.isEmpty();
+                ++iter) {
+            QDir dir(*iter);
+            auto entries = dir.entryInfoList(QDir::Files | QDir::Readable);
+            for(auto entry = entries.constBegin(), entriesEnd = entries.constEnd(); entry != entriesEnd; ++entry) {
+                if((*entry).fileName().endsWith(".part")) {
+                    continue;
+                }
+                QFile candidate((*entry).absoluteFilePath());
+                QString updateString;
+                if(!candidate.open(QIODevice::ReadOnly) ||
+                   AppImageUpdateInformationPrivate::readUpdateString(&candidate, &updateString) != NoError ||
+                   updateString != sourceUpdateString) {
+                    continue;
+                }
+                seedFiles << (*entry).absoluteFilePath();
+                QCoreApplication::processEvents();
+            }
         }
-        QCoreApplication::processEvents();
-        if(b_CancelRequested == true) {
-            error = -3;
-            b_CancelRequested = false;
-            emit canceled();
+    }
+
+    /* The default seeds are already scanned. */
+    seedFiles.removeAll(QFileInfo(s_SourceFilePath).absoluteFilePath());
+    seedFiles.removeAll(QFileInfo(s_TargetFileDirectory + "/" + s_TargetFileName).absoluteFilePath());
+    seedFiles.removeDuplicates();
+    return seedFiles;
+}
+
+/*
+ * Quickly estimates how useful the given seed file is , by looking up the
+ * weak checksums of a few block aligned windows spread over the file.
+ * Only the rsum hash is used , So this never writes anything.
+ * Returns the estimated number of blocks of the seed file which are still
+ * missing in the target file , i.e the matched samples scaled to the file.
+*/
+qint32 ZsyncWriterPrivate::estimateSeedMatches(QFile *file)
+{
+    qint64 windows = (file->size() - n_Context) / n_BlockSize;
+    if(windows <= 0 || !p_RsumHash) {
+        return 0;
+    }
+    qint64 step = qMax(static_cast<qint64>(1), windows / SeedSampleCount);
+    QByteArray window(n_Context, 0);
+    qint32 matches = 0;
+
+    for(qint64 n = 0; n < windows && n / step < SeedSampleCount; n += step) {
+        if(!file->seek(n * n_BlockSize) || file->read(window.data(), n_Context) != n_Context) {
             break;
         }
+        auto data = reinterpret_cast<const unsigned char*>(window.constData());
+        rsum first = calc_rsum_block(data, n_BlockSize),
+             second = { 0, 0 };
+        if(n_SeqMatches > 1) {
+            second = calc_rsum_block(data + n_BlockSize, n_BlockSize);
+        }
+
+        unsigned hash = first.b;
+        hash ^= ((n_SeqMatches > 1) ? second.b : first.a & p_WeakCheckSumMask) << BITHASHBITS;
+        if ((p_BitHash[(hash & p_BitHashMask) >> 3] & (1 << (hash & 7))) == 0) {
+            continue;
+        }
+        for(const hash_entry *e = p_RsumHash[hash & p_HashMask]; e; e = e->next) {
+            if (e->r.a == (first.a & p_WeakCheckSumMask) && e->r.b == first.b) {
+                ++matches;
+                break;
+            }
+        }
     }
-    p_TransferSpeed.reset(new QTime);
-    file->close();
-    free(buf);
-    return error;
+    return static_cast<qint32>(qMin(matches * step, static_cast<qint64>(n_Blocks)));
 }
 
+/*
+ * Takes the blocks which are still missing from the local block store ,
+ * Every block is verified against the control file before it is written.
+*/
+void ZsyncWriterPrivate::submitBlockStore(void)
+{
+    if(p_BlockStore.isNull() || !p_BlockHashes) {
+        return;
+    }
+    if (!p_RsumHash && !buildHash()) {
+        return;
+    }
+    TraceScope traceScope("BlockStoreLookup");
 
+    unsigned char md4sum[CHECKSUM_SIZE];
+    QByteArray block;
+    QVector<QPair<zs_blockid, QByteArray>> blocks;
+    qint32 found = 0;
+    zs_blockid id = 0;
+    while(id < n_Blocks && n_BytesWritten < n_TargetFileLength) {
+        /*
+         * Blocks are looked up in batches , writeBlocks processes events so
+         * the store is not kept locked while they are written.
+        */
+        {
+            ZsyncBlockStoreLocker locker(p_BlockStore.data());
+            if(!locker.isLocked()) {
+                break;
+            }
+            for(; id < n_Blocks && blocks.size() < BlockStoreLookupBatch; ++id) {
+                const hash_entry *e = p_BlockHashes + id;
+                if(!alreadyGotBlock(id) &&
+                   p_BlockStore->lookup(n_BlockSize, e->r, p_WeakCheckSumMask, e->checksum, n_StrongCheckSumBytes, &block)) {
+                    blocks.append(qMakePair(id, block));
+                }
+            }
+        }
+
+        for(auto iter = blocks.constBegin(), end = blocks.constEnd(); iter != end; ++iter) {
+            auto data = reinterpret_cast<const unsigned char*>((*iter).second.constData());
+            calcMd4Checksum(md4sum, data, n_BlockSize);
+            if(alreadyGotBlock((*iter).first) || memcmp(md4sum, p_BlockHashes[(*iter).first].checksum, n_StrongCheckSumBytes)) {
+                continue;
+            }
+            writeBlocks(data, (*iter).first, (*iter).first);
+            ++found;
+        }
+        blocks.clear();
+    }
+    INFO_START " submitBlockStore : found " LOGR found LOGR " blocks in the block store." INFO_END;
+    return;
+}
+
+/*
+ * Marks the all zero blocks which are still missing as written , The target
+ * file is new so it already reads zero there once it is resized to the
+ * target file length.
+*/
+void ZsyncWriterPrivate::submitZeroBlocks(void)
+{
+    if(n_ZeroBlockGroup < 0) {
+        return;
+    }
+    if (!p_RsumHash && !buildHash()) {
+        return;
+    }
+    for(auto id : p_IdenticalBlocks.at(n_ZeroBlockGroup)) {
+        if(alreadyGotBlock(id)) {
+            continue;
+        }
+        n_BytesWritten += n_BlockSize;
+        n_BytesSynthesized += n_BlockSize;
+        removeBlockFromHash(id);
+        addToRanges(id);
+    }
+    INFO_START " submitZeroBlocks : " LOGR n_BytesSynthesized LOGR " bytes of zero blocks need no download." INFO_END;
+    return;
+}
+
+/*
+ * Copies the data of the given block , which was just written , to every
+ * identical block which is still missing.
+*/
+void ZsyncWriterPrivate::replicateBlock(const unsigned char *data, zs_blockid id)
+{
+    /* The last block may be shorter than the block size. */
+    bool partial = (id == n_Blocks - 1) && (n_TargetFileLength & (n_BlockSize - 1));
+    if(b_Replicating || partial || id >= p_BlockGroups.size() || p_BlockGroups.at(id) < 0) {
+        return;
+    }
+    b_Replicating = true;
+    for(auto other : p_IdenticalBlocks.at(p_BlockGroups.at(id))) {
+        if(other != id && !alreadyGotBlock(other)) {
+            writeBlocks(data, other, other);
+
+            /* The run of matches of the seed scan may now reach known blocks. */
+            p_NextMatch = NULL;
+        }
+    }
+    b_Replicating = false;
+    return;
+}
+
+/*
+ * Adds every block of the given chunk of the target file to the local block
+ * store , Called while the target file is verified so it is read only once.
+ * Every block is stored under its own checksums , So a lookup still gives
+ * the right data even if the target file turns out to be broken.
+*/
+void ZsyncWriterPrivate::collectBlocks(const QByteArray &chunk)
+{
+    if(p_BlockStore.isNull()) {
+        return;
+    }
+    ZsyncBlockStoreLocker locker(p_BlockStore.data());
+    if(!locker.isLocked()) {
+        return;
+    }
+
+    unsigned char md4sum[CHECKSUM_SIZE];
+    QByteArray block(n_BlockSize, 0);
+    auto data = reinterpret_cast<unsigned char*>(block.data());
+    for(qint64 offset = 0; offset < chunk.size(); offset += n_BlockSize) {
+        /* The last block is zero padded , just like in the control file. */
+        block.fill(0);
+        memcpy(data, chunk.constData() + offset, qMin(static_cast<qint64>(n_BlockSize), chunk.size() - offset));
+        calcMd4Checksum(md4sum, data, n_BlockSize);
+        p_BlockStore->insert(n_BlockSize, calc_rsum_block(data, n_BlockSize), md4sum, block.constData());
+    }
+    return;
+}
 
 /* Build hash tables to quickly lookup a block based on its rsum value.
  * Returns non-zero if successful.
  */
 qint32 ZsyncWriterPrivate::buildHash(void)
 {
+    TraceScope traceScope("BuildHash", QJsonObject { { "Blocks", n_Blocks } });
     zs_blockid id;
     qint32 i = 16;
 
@@ -1261,6 +2615,7 @@ qint32 ZsyncWriterPrivate::rangeBeforeBlock(zs_blockid x)
 void ZsyncWriterPrivate::addToRanges(zs_blockid x)
 {
     qint32 r = rangeBeforeBlock(x);
+    p_KnownBlocks->set(x);
 
     if (r == -1) {
         /* Already have this block */
@@ -1348,17 +2703,35 @@ zs_blockid ZsyncWriterPrivate::getHashEntryBlockId(const hash_entry *e)
  * under-construction output file */
 void ZsyncWriterPrivate::writeBlocks(const unsigned char *data, zs_blockid bfrom, zs_blockid bto)
 {
-    if(!p_TargetFile->isOpen() || !p_TargetFile->autoRemove())
-        return;
-
-
     off_t len = ((off_t) (bto - bfrom + 1)) << n_BlockShift;
     off_t offset = ((off_t)bfrom) << n_BlockShift;
 
-    auto pos = p_TargetFile->pos();
-    p_TargetFile->seek(offset);
-    n_BytesWritten += p_TargetFile->write((char*)data, len);
-    p_TargetFile->seek(pos);
+    /*
+     * Blocks which are known already do not count again , A range may be
+     * downloaded while a seed scan finds some of its blocks.
+    */
+    off_t known = 0;
+    for (zs_blockid id = bfrom; id <= bto; id++) {
+        known += alreadyGotBlock(id) ? n_BlockSize : 0;
+    }
+
+    recordMatch(data, bfrom, bto);
+    if(b_DryRun) {
+        /* Only account the blocks , the plan is made from the known ranges. */
+        n_BytesWritten += len - known;
+    } else {
+        if(!p_TargetFile->isOpen() || !p_TargetFile->autoRemove())
+            return;
+
+        if(addSeedExtent(data, offset, len)) {
+            n_BytesWritten += len - known;
+        } else {
+            auto pos = p_TargetFile->pos();
+            p_TargetFile->seek(offset);
+            n_BytesWritten += qMax(static_cast<qint64>(0), p_TargetFile->write((char*)data, len) - known);
+            p_TargetFile->seek(pos);
+        }
+    }
 
     {   /* Having written those blocks, discard them from the rsum hashes (as
          * we don't need to identify data for those blocks again, and this may
@@ -1366,11 +2739,126 @@ void ZsyncWriterPrivate::writeBlocks(const unsigned char *data, zs_blockid bfrom
          * blocks), and add the written blocks to the record of blocks that we
          * have received and stored the data for */
         int id;
+        WRITER_STATISTICS_ADD(n_BlocksWritten, bto - bfrom + 1);
         for (id = bfrom; id <= bto; id++) {
             removeBlockFromHash(id);
             addToRanges(id);
+            flushStatistics();
             QCoreApplication::processEvents();
         }
+        for (id = bfrom; id <= bto; id++) {
+            replicateBlock(data + (((off_t)(id - bfrom)) << n_BlockShift), id);
+        }
+    }
+    return;
+}
+
+/*
+ * Records the given matched data as a extent of the seed file being scanned
+ * if it lies within the seed , Adjacent extents are merged so a unchanged
+ * region of the seed becomes a single extent. Returns false if the data has
+ * to be written the usual way , i.e it is not from a seed or is the 0 padding
+ * after its end.
+*/
+bool ZsyncWriterPrivate::addSeedExtent(const unsigned char *data, qint64 targetOffset, qint64 len)
+{
+    if(n_SeedHandle < 0 || !p_ScanBase || data < p_ScanBase || data + len > p_ScanBase + n_ScanLength) {
+        return false;
+    }
+    qint64 seedOffset = n_ScanBaseOffset + (data - p_ScanBase);
+    if(seedOffset + len > n_SeedSize) {
+        return false;
+    }
+
+    if(n_ExtentLength &&
+       seedOffset == n_ExtentSeedOffset + n_ExtentLength &&
+       targetOffset == n_ExtentTargetOffset + n_ExtentLength) {
+        n_ExtentLength += len;
+        return true;
+    }
+    flushSeedExtent();
+    n_ExtentSeedOffset = seedOffset;
+    n_ExtentTargetOffset = targetOffset;
+    n_ExtentLength = len;
+    return true;
+}
+
+/*
+ * Places the pending seed extent in the target file without reading it into
+ * the memory if the filesystem allows it. The part which is aligned to the
+ * filesystem blocks is shared with FICLONERANGE (Btrfs , XFS) , The rest is
+ * copied with copy_file_range and only if both are not supported the data is
+ * read and written back.
+*/
+void ZsyncWriterPrivate::flushSeedExtent(void)
+{
+    if(!n_ExtentLength) {
+        return;
+    }
+    qint64 seedOffset = n_ExtentSeedOffset,
+           targetOffset = n_ExtentTargetOffset,
+           left = n_ExtentLength;
+    n_ExtentLength = 0;
+
+    p_TargetFile->flush();
+    int target = p_TargetFile->handle();
+
+#if defined(Q_OS_LINUX) && defined(FICLONERANGE)
+    struct stat targetStat;
+    if(b_CloneSupported && fstat(target, &targetStat) == 0 && targetStat.st_blksize > 0) {
+        qint64 alignment = targetStat.st_blksize,
+               cloneLength = (left / alignment) * alignment;
+        if(cloneLength && !(seedOffset % alignment) && !(targetOffset % alignment)) {
+            struct file_clone_range range;
+            range.src_fd = n_SeedHandle;
+            range.src_offset = seedOffset;
+            range.src_length = cloneLength;
+            range.dest_offset = targetOffset;
+            if(ioctl(target, FICLONERANGE, &range) == 0) {
+                WRITER_STATISTICS_ADD(n_BytesCloned, cloneLength);
+                seedOffset += cloneLength;
+                targetOffset += cloneLength;
+                left -= cloneLength;
+            } else if(errno == EOPNOTSUPP || errno == ENOTTY || errno == EXDEV || errno == EINVAL) {
+                b_CloneSupported = false; /* Not for this seed , do not ask again. */
+            }
+        }
+    }
+#endif // Q_OS_LINUX && FICLONERANGE
+
+#if defined(Q_OS_LINUX) && defined(SYS_copy_file_range)
+    while(left > 0 && b_CopyRangeSupported) {
+        loff_t from = seedOffset,
+               to = targetOffset;
+        auto copied = syscall(SYS_copy_file_range, n_SeedHandle, &from, target, &to, static_cast<size_t>(left), 0u);
+        if(copied <= 0) {
+            if(copied < 0 && errno == EINTR) {
+                continue;
+            }
+            b_CopyRangeSupported = false;
+            break;
+        }
+        WRITER_STATISTICS_ADD(n_BytesCopiedInKernel, copied);
+        seedOffset += copied;
+        targetOffset += copied;
+        left -= copied;
+    }
+#endif // Q_OS_LINUX && SYS_copy_file_range
+
+    if(left > 0) {
+        QByteArray buffer(static_cast<int>(qMin(left, static_cast<qint64>(BufferedScanSize))), Qt::Uninitialized);
+        while(left > 0) {
+            auto got = pread(n_SeedHandle, buffer.data(), static_cast<size_t>(qMin(left, static_cast<qint64>(buffer.size()))), seedOffset);
+            if(got <= 0 || pwrite(target, buffer.constData(), got, targetOffset) != got) {
+                /* The target file will not verify , which is reported at the end. */
+                WARNING_START " flushSeedExtent : cannot place a extent of the seed file." WARNING_END;
+                break;
+            }
+            WRITER_STATISTICS_ADD(n_BytesCopiedInUserspace, got);
+            seedOffset += got;
+            targetOffset += got;
+            left -= got;
+        }
     }
     return;
 }
@@ -1378,9 +2866,23 @@ void ZsyncWriterPrivate::writeBlocks(const unsigned char *data, zs_blockid bfrom
 /* Calculates the Md4 Checksum of the given data with respect to the given len. */
 void ZsyncWriterPrivate::calcMd4Checksum(unsigned char *c, const unsigned char *data, size_t len)
 {
-    p_Md4Ctx->reset();
-    p_Md4Ctx->addData((const char*)data, len);
-    auto result = p_Md4Ctx->result();
-    memmove(c, result.constData(), sizeof(const char) * result.size());
+    calcMd4Checksum(p_Md4Ctx.data(), c, data, len, CHECKSUM_SIZE);
+    return;
+}
+
+/*
+ * Hashes the given data with the given MD4 context into the given buffer of
+ * CHECKSUM_SIZE bytes , Only the first checksumBytes are kept and the rest
+ * is zeroed , just like the strong checksums of the control file.
+*/
+void ZsyncWriterPrivate::calcMd4Checksum(QCryptographicHash *ctx, unsigned char *c, const unsigned char *data,
+        size_t len, size_t checksumBytes)
+{
+    ctx->reset();
+    ctx->addData((const char*)data, len);
+    auto result = ctx->result();
+    checksumBytes = qMin(checksumBytes, static_cast<size_t>(CHECKSUM_SIZE));
+    memcpy(c, result.constData(), checksumBytes);
+    memset(c + checksumBytes, 0, CHECKSUM_SIZE - checksumBytes);
     return;
 }
@@ -0,0 +1,70 @@
+#ifndef APPIMAGE_BATCH_SCANNER_TESTS_HPP_INCLUDED
+#define APPIMAGE_BATCH_SCANNER_TESTS_HPP_INCLUDED
+#include <QTest>
+#include <QSignalSpy>
+#include <QFileInfo>
+#include "../include/appimagebatchscanner.hpp"
+
+/*
+ * Get the official appimage tool to test it with
+ * our library.
+*/
+#define APPIMAGE_TOOL_RELATIVE_PATH QString("test_cases/appimagetool.AppImage")
+#define APPIMAGE_TOOL_MODIFIED_RELATIVE_PATH QString("test_cases/appimagetool-mod.AppImage")
+
+class AppImageBatchScanner : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase(void)
+    {
+        QFileInfo file(APPIMAGE_TOOL_RELATIVE_PATH);
+        if(!file.exists()) {
+            QFAIL("required test cases does not exist!");
+        }
+        return;
+    }
+
+    void scanAppImages(void)
+    {
+        using AppImageUpdaterBridge::AppImageBatchScanner;
+        AppImageBatchScanner Scanner(/*maxConcurrentReads=*/2);
+        QSignalSpy spyScanned(&Scanner, SIGNAL(appImageScanned(QJsonObject)));
+        QSignalSpy spyError(&Scanner, SIGNAL(scanError(QString, short)));
+        QSignalSpy spyFinished(&Scanner, SIGNAL(finished(void)));
+
+        Scanner.scanAppImages(QStringList() << APPIMAGE_TOOL_RELATIVE_PATH
+                              << APPIMAGE_TOOL_MODIFIED_RELATIVE_PATH
+                              << QString("test_cases/does-not-exist.AppImage"));
+
+        QVERIFY(spyFinished.wait(10 * 1000));
+        QCOMPARE(spyScanned.count(), 2);
+        QCOMPARE(spyError.count(), 1);
+
+        for(auto &arguments : spyScanned) {
+            auto result = arguments.at(0).toJsonObject();
+            auto fileInfo = result["FileInformation"].toObject();
+            QVERIFY(!fileInfo["AppImageSHA1Hash"].toString().isEmpty());
+            QVERIFY(!result["UpdateInformation"].toObject().isEmpty());
+        }
+        return;
+    }
+
+    void scanDirectorySkipsOtherFiles(void)
+    {
+        using AppImageUpdaterBridge::AppImageBatchScanner;
+        AppImageBatchScanner Scanner;
+        QSignalSpy spyScanned(&Scanner, SIGNAL(appImageScanned(QJsonObject)));
+        QSignalSpy spyError(&Scanner, SIGNAL(scanError(QString, short)));
+        QSignalSpy spyFinished(&Scanner, SIGNAL(finished(void)));
+
+        Scanner.setCalculateSha1Hash(false);
+        Scanner.scanDirectory(QFileInfo(APPIMAGE_TOOL_RELATIVE_PATH).absolutePath());
+
+        QVERIFY(spyFinished.wait(10 * 1000));
+        QVERIFY(spyScanned.count() >= 2);
+        QCOMPARE(spyError.count(), 0);
+        return;
+    }
+};
+#endif // APPIMAGE_BATCH_SCANNER_TESTS_HPP_INCLUDED
@@ -2,7 +2,16 @@
 #define APPIMAGE_DELTA_REVISIONER_TESTS_HPP_INCLUDED
 #include <QTest>
 #include <QSignalSpy>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QThread>
 #include "../include/appimagedeltarevisioner.hpp"
+#include "LocalHttpServer.hpp"
+#include "SyntheticAppImage.hpp"
 
 /*
  * Get the official appimage tool to test it with
@@ -12,6 +21,80 @@
 #define APPIMAGE_TOOL_MODIFIED_RELATIVE_PATH QString("test_cases/appimagetool-mod.AppImage")
 #define APPIMAGE_UPDATE_RESULT QString("test_cases/appimagetool-x86_64.AppImage")
 
+/*
+ * A synthetic AppImage whose new version is served by a local server.
+ * The blocking calls block the test's thread , So the server runs in its own.
+*/
+class LocalBlockingUpdate
+{
+public:
+    explicit LocalBlockingUpdate(int latency = 0)
+        : m_Server(latency)
+    {
+        const QString fileName = QString("Synthetic-x86_64.AppImage");
+        if(!m_WorkingDirectory.isValid() || !m_Server.listen()) {
+            return;
+        }
+        QString updateString = "zsync|" + m_Server.url(fileName + ".zsync").toString();
+        QByteArray oldVersion = SyntheticAppImage::generate(updateString, /*payloadSize=*/1 << 20, /*seed=*/1),
+                   newVersion = SyntheticAppImage::edit(oldVersion, updateString, Insertions, /*seed=*/2);
+        m_Server.addFile(fileName, newVersion);
+        m_Server.addFile(fileName + ".zsync", SyntheticAppImage::controlFile(newVersion, fileName, /*blockSize=*/4096));
+        m_NewVersion = newVersion;
+
+        QFile file(m_WorkingDirectory.path() + "/" + fileName);
+        if(!file.open(QIODevice::WriteOnly) || file.write(oldVersion) != oldVersion.size()) {
+            return;
+        }
+        file.setPermissions(file.permissions() | QFileDevice::ExeUser);
+        file.close();
+        QDir(m_WorkingDirectory.path()).mkdir("output");
+
+        m_Server.moveToThread(&m_ServerThread);
+        m_ServerThread.start();
+        s_AppImagePath = file.fileName();
+        return;
+    }
+
+    ~LocalBlockingUpdate()
+    {
+        m_ServerThread.quit();
+        m_ServerThread.wait();
+        return;
+    }
+
+    AppImageUpdaterBridge::UpdateOptions options(void) const
+    {
+        AppImageUpdaterBridge::UpdateOptions options;
+        options.appImagePath = s_AppImagePath;
+        options.outputDirectory = m_WorkingDirectory.path() + "/output";
+        options.timeout = 30 * 1000;
+        return options;
+    }
+
+    bool isValid(void) const
+    {
+        return !s_AppImagePath.isEmpty();
+    }
+
+    /* Writes a copy of the new version under the given name , to be used as a extra seed file. */
+    QString writeSeedFile(const QString &fileName) const
+    {
+        QFile file(m_WorkingDirectory.path() + "/" + fileName);
+        if(!file.open(QIODevice::WriteOnly) || file.write(m_NewVersion) != m_NewVersion.size()) {
+            return QString();
+        }
+        return QFileInfo(file).absoluteFilePath();
+    }
+
+private:
+    QTemporaryDir m_WorkingDirectory;
+    LocalHttpServer m_Server;
+    QThread m_ServerThread;
+    QString s_AppImagePath;
+    QByteArray m_NewVersion;
+};
+
 class AppImageDeltaRevisioner : public QObject
 {
     Q_OBJECT
@@ -131,6 +214,265 @@ private slots:
 	QVERIFY(spyInfo.count() || spyInfo.wait(50 * 1000));
     }
 
+    void updateShouldSucceedWithSeparateNetworkThread(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        AppImageDeltaRevisioner AIDeltaRev(APPIMAGE_TOOL_RELATIVE_PATH, AppImageUpdaterBridge::SeparateNetworkThread);
+
+        QSignalSpy spyInfo(&AIDeltaRev, SIGNAL(finished(QJsonObject , QString)));
+        AIDeltaRev.start();
+	
+	QVERIFY(spyInfo.count() || spyInfo.wait(50 * 1000));
+    }
+
+    void updateShouldFillBlockStore(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        QTemporaryDir blockStore;
+        QVERIFY(blockStore.isValid());
+        {
+            AppImageDeltaRevisioner AIDeltaRev;
+            AIDeltaRev.setAppImage(APPIMAGE_TOOL_RELATIVE_PATH);
+            AIDeltaRev.setBlockStore(blockStore.path());
+
+            QSignalSpy spyInfo(&AIDeltaRev, SIGNAL(finished(QJsonObject , QString)));
+            AIDeltaRev.start();
+
+	    QVERIFY(spyInfo.count() || spyInfo.wait(50 * 1000));
+        }
+	/* The index is written when the last user of the store is gone. */
+	QTRY_VERIFY(QFileInfo(blockStore.path() + "/blocks.index").exists());
+	QVERIFY(!QDir(blockStore.path()).entryList(QStringList() << "*.pack").isEmpty());
+    }
+
+    void matchCacheShouldGiveTheSamePlan(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        QTemporaryDir matchCache, imported;
+        QVERIFY(matchCache.isValid() && imported.isValid());
+        LocalBlockingUpdate update;
+        QVERIFY(update.isValid());
+        AppImageDeltaRevisioner AIDeltaRev;
+        AIDeltaRev.setAppImage(update.options().appImagePath);
+        AIDeltaRev.setOutputDirectory(update.options().outputDirectory);
+        AIDeltaRev.setMatchCache(matchCache.path());
+
+        QSignalSpy spyPlan(&AIDeltaRev, SIGNAL(updatePlan(QJsonObject)));
+        AIDeltaRev.planUpdate();
+	QVERIFY(spyPlan.count() || spyPlan.wait(50 * 1000));
+	auto scanned = spyPlan.takeFirst().at(0).toJsonObject();
+	QVERIFY(scanned["UpdateAvailable"].toBool());
+	auto caches = QDir(matchCache.path()).entryList(QStringList() << "*.matches");
+	QCOMPARE(caches.size(), 1);
+
+	/* The second plan is made from the cache. */
+        AIDeltaRev.planUpdate();
+	QVERIFY(spyPlan.count() || spyPlan.wait(50 * 1000));
+	auto cached = spyPlan.takeFirst().at(0).toJsonObject();
+	QCOMPARE(cached["BytesAvailable"].toDouble(), scanned["BytesAvailable"].toDouble());
+
+	auto pair = QFileInfo(caches.first()).completeBaseName().split("-");
+	QString exported = imported.path() + "/exported.matches";
+	QVERIFY(AppImageDeltaRevisioner::exportMatchCache(pair.at(0), pair.at(1), exported, matchCache.path()));
+	QVERIFY(AppImageDeltaRevisioner::importMatchCache(exported, imported.path()));
+	QVERIFY(QFileInfo(imported.path() + "/" + caches.first()).exists());
+	QVERIFY(!AppImageDeltaRevisioner::importMatchCache(update.options().appImagePath, imported.path()));
+    }
+
+    void planUpdateShouldNotWriteAnything(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        LocalBlockingUpdate update;
+        QVERIFY(update.isValid());
+        auto options = update.options();
+        AppImageDeltaRevisioner AIDeltaRev;
+        AIDeltaRev.setAppImage(options.appImagePath);
+        AIDeltaRev.setOutputDirectory(options.outputDirectory);
+	QDir dir(QFileInfo(options.appImagePath).path()),
+	     outputDir(options.outputDirectory);
+	auto files = dir.entryList(QDir::Files),
+	     outputFiles = outputDir.entryList(QDir::Files);
+
+        QSignalSpy spyInfo(&AIDeltaRev, SIGNAL(updatePlan(QJsonObject)));
+        AIDeltaRev.planUpdate();
+
+	QVERIFY(spyInfo.count() || spyInfo.wait(50 * 1000));
+	auto plan = spyInfo.takeFirst().at(0).toJsonObject();
+	QVERIFY(plan["UpdateAvailable"].toBool());
+	QVERIFY(plan["BytesToDownload"].toDouble() + plan["BytesAvailable"].toDouble() +
+		plan["BytesDeduplicated"].toDouble() >= plan["TargetFileLength"].toDouble());
+	QCOMPARE(plan["RequestCount"].toInt(), plan["RequiredRanges"].toArray().size());
+
+	/* No temporary target file should be created by a dry run. */
+	QCOMPARE(dir.entryList(QDir::Files), files);
+	QCOMPARE(outputDir.entryList(QDir::Files), outputFiles);
+    }
+
+    void statisticsShouldCountTheSeedScan(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        LocalBlockingUpdate update;
+        QVERIFY(update.isValid());
+        AppImageDeltaRevisioner AIDeltaRev;
+        AIDeltaRev.setAppImage(update.options().appImagePath);
+        AIDeltaRev.setOutputDirectory(update.options().outputDirectory);
+
+        QSignalSpy spyPlan(&AIDeltaRev, SIGNAL(updatePlan(QJsonObject)));
+        AIDeltaRev.planUpdate();
+	QVERIFY(spyPlan.count() || spyPlan.wait(50 * 1000));
+	auto plan = spyPlan.takeFirst().at(0).toJsonObject();
+	QVERIFY(plan["UpdateAvailable"].toBool());
+
+        QSignalSpy spyStats(&AIDeltaRev, SIGNAL(statistics(QJsonObject)));
+        AIDeltaRev.getStatistics();
+	QVERIFY(spyStats.count() || spyStats.wait(10 * 1000));
+	auto stats = spyStats.takeFirst().at(0).toJsonObject();
+	if(stats.isEmpty()) {
+		QSKIP("Compiled with STATISTICS_DISABLED.");
+	}
+	/* The insertions shift most blocks , So the rolling scan has to find them. */
+	QVERIFY(stats["StrongHits"].toDouble() > 0);
+	QVERIFY(stats["StrongHits"].toDouble() <= stats["WeakHits"].toDouble());
+	QVERIFY(stats["WeakHits"].toDouble() <= stats["ChainEntries"].toDouble());
+	QVERIFY(stats["BucketHits"].toDouble() <= stats["BitHashProbes"].toDouble());
+	QCOMPARE(stats["FalseWeakHits"].toDouble(),
+		 stats["WeakHits"].toDouble() - stats["StrongHits"].toDouble());
+    }
+
+    void traceFileShouldHaveThePhases(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        QTemporaryDir traceDir;
+        QVERIFY(traceDir.isValid());
+        QString traceFile = traceDir.path() + "/update.trace.json";
+        AppImageDeltaRevisioner AIDeltaRev;
+        AIDeltaRev.setAppImage(APPIMAGE_TOOL_RELATIVE_PATH);
+        AIDeltaRev.setTraceFile(traceFile);
+
+        QSignalSpy spyInfo(&AIDeltaRev, SIGNAL(updateAvailable(bool, QJsonObject)));
+        AIDeltaRev.checkForUpdate();
+	QVERIFY(spyInfo.count() || spyInfo.wait(50 * 1000));
+
+	QFile file(traceFile);
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	auto events = QJsonDocument::fromJson(file.readAll()).object()["traceEvents"].toArray();
+	QStringList names;
+	for(auto event : events) {
+		names << event.toObject()["name"].toString();
+	}
+	QVERIFY(names.contains("ReadElf"));
+	QVERIFY(names.contains("AppImageSHA1Hash"));
+	QVERIFY(names.contains("FetchControlFile"));
+	AIDeltaRev.setTraceFile(QString());
+    }
+
+    void progressShouldBeRateLimited(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        AppImageDeltaRevisioner AIDeltaRev;
+        AIDeltaRev.setAppImage(APPIMAGE_TOOL_RELATIVE_PATH);
+        AIDeltaRev.setProgressInterval(500);
+
+        QSignalSpy spyProgress(&AIDeltaRev, SIGNAL(progress(int, qint64, qint64, double, QString)));
+        QSignalSpy spyInfo(&AIDeltaRev, SIGNAL(finished(QJsonObject , QString)));
+        QElapsedTimer elapsed;
+        elapsed.start();
+        AIDeltaRev.start();
+
+	QVERIFY(spyInfo.count() || spyInfo.wait(50 * 1000));
+	/* At most one per interval , a few more for the phase changes. */
+	QVERIFY(spyProgress.count() <= elapsed.elapsed() / 500 + 4);
+    }
+
+    void logCaptureShouldKeepMessages(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        AppImageDeltaRevisioner AIDeltaRev;
+        AIDeltaRev.setAppImage(APPIMAGE_TOOL_RELATIVE_PATH);
+        AIDeltaRev.setLogCapture(true);
+
+        QSignalSpy spyInfo(&AIDeltaRev, SIGNAL(updateAvailable(bool, QJsonObject)));
+        AIDeltaRev.checkForUpdate();
+	QVERIFY(spyInfo.count() || spyInfo.wait(50 * 1000));
+
+        QSignalSpy spyLog(&AIDeltaRev, SIGNAL(capturedLog(QStringList)));
+        AIDeltaRev.getCapturedLog();
+	QVERIFY(spyLog.count() || spyLog.wait(10 * 1000));
+	auto messages = spyLog.takeFirst().at(0).toStringList();
+	AIDeltaRev.setLogCapture(false);
+	if(messages.isEmpty()) {
+		QSKIP("Compiled with LOGGING_DISABLED.");
+	}
+	QVERIFY(messages.filter("INFO").count() > 0);
+    }
+
+    void extraSeedFileIsScanned(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        LocalBlockingUpdate update;
+        QVERIFY(update.isValid());
+        QString seedFile = update.writeSeedFile(QString("Synthetic-seed.AppImage"));
+        QVERIFY(!seedFile.isEmpty());
+        AppImageDeltaRevisioner AIDeltaRev;
+        AIDeltaRev.setAppImage(update.options().appImagePath);
+        AIDeltaRev.setOutputDirectory(update.options().outputDirectory);
+        AIDeltaRev.addSeedFile(seedFile);
+
+        QSignalSpy spyInfo(&AIDeltaRev, SIGNAL(updatePlan(QJsonObject)));
+        AIDeltaRev.planUpdate();
+
+	QVERIFY(spyInfo.count() || spyInfo.wait(50 * 1000));
+	auto plan = spyInfo.takeFirst().at(0).toJsonObject();
+	QVERIFY(plan["UpdateAvailable"].toBool());
+
+	QStringList seedFiles;
+	for(auto seed : plan["SeedFiles"].toArray()) {
+		seedFiles << seed.toObject()["AbsolutePath"].toString();
+	}
+	/* The extra seed is a copy of the new version , So it gives everything the old version lacks. */
+	QVERIFY(seedFiles.contains(seedFile));
+	QCOMPARE(plan["BytesToDownload"].toDouble(), 0.0);
+    }
+
+    void checkForUpdateBlocking(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        LocalBlockingUpdate update;
+        QVERIFY(update.isValid());
+
+        auto result = AppImageDeltaRevisioner::checkForUpdateBlocking(update.options());
+        QCOMPARE(result.errorCode, (short)AppImageUpdaterBridge::NoError);
+        QVERIFY(result.updateAvailable);
+        QVERIFY(!result.remoteSha1Hash.isEmpty());
+    }
+
+    void updateBlocking(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        LocalBlockingUpdate update;
+        QVERIFY(update.isValid());
+
+        auto result = AppImageDeltaRevisioner::updateBlocking(update.options());
+        QCOMPARE(result.errorCode, (short)AppImageUpdaterBridge::NoError);
+        QVERIFY(QFileInfo(result.newVersionPath).exists());
+        QVERIFY(result.newVersionPath != result.oldVersionPath);
+    }
+
+    /* The server never answers within the test , So the call must return on its own. */
+    void blockingTimeoutReturnsPromptly(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        LocalBlockingUpdate update(/*latency=*/10 * 60 * 1000);
+        QVERIFY(update.isValid());
+
+        auto options = update.options();
+        options.timeout = 1000;
+        QElapsedTimer clock;
+        clock.start();
+        auto result = AppImageDeltaRevisioner::checkForUpdateBlocking(options);
+        QVERIFY(clock.elapsed() < options.timeout + 2000);
+        QCOMPARE(result.errorCode, (short)AppImageUpdaterBridge::TimeoutError);
+        QVERIFY(result.canceled);
+    }
+
+    void blockingErrorIsReported(void){
+        using AppImageUpdaterBridge::AppImageDeltaRevisioner;
+        AppImageUpdaterBridge::UpdateOptions options;
+        options.appImagePath = QString("test_cases/does-not-exist.AppImage");
+        options.timeout = 30 * 1000;
+
+        auto result = AppImageDeltaRevisioner::updateBlocking(options);
+        QVERIFY(result.errorCode != AppImageUpdaterBridge::NoError);
+    }
+
     void checkErrorSignal(void)
     {
         using AppImageUpdaterBridge::AppImageDeltaRevisioner;
@@ -2,6 +2,8 @@
 #define APPIMAGE_UPDATE_INFORMATION_TESTS_HPP_INCLUDED
 #include <QTest>
 #include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QCryptographicHash>
 #include "../include/appimageupdateinformation_p.hpp"
 
 /*
@@ -94,6 +96,53 @@ private slots:
 
     }
 
+    void partialInfoIsEmittedBeforeHashing(void)
+    {
+        using AppImageUpdaterBridge::AppImageUpdateInformationPrivate;
+        AppImageUpdateInformationPrivate AIUpdateInformation;
+        AIUpdateInformation.setAppImage(APPIMAGE_TOOL_RELATIVE_PATH);
+
+        QSignalSpy spyPartialInfo(&AIUpdateInformation, SIGNAL(partialInfo(QJsonObject)));
+        QSignalSpy spyInfo(&AIUpdateInformation, SIGNAL(info(QJsonObject)));
+        AIUpdateInformation.getInfo();
+
+        /* The update information must be available before the SHA1 hash. */
+        QCOMPARE(spyPartialInfo.count(), 1);
+        QVERIFY(spyInfo.count() || spyInfo.wait());
+
+        auto partial = spyPartialInfo.takeFirst().at(0).toJsonObject();
+        auto result = spyInfo.takeFirst().at(0).toJsonObject();
+        QCOMPARE(partial["UpdateInformation"].toObject(), result["UpdateInformation"].toObject());
+        QVERIFY(!partial["FileInformation"].toObject().contains("AppImageSHA1Hash"));
+        QVERIFY(!result["FileInformation"].toObject()["AppImageSHA1Hash"].toString().isEmpty());
+        return;
+    }
+
+    void hashesGivenDeviceWithUnlinkedPath(void)
+    {
+        using AppImageUpdaterBridge::AppImageUpdateInformationPrivate;
+        QFile original(APPIMAGE_TOOL_RELATIVE_PATH);
+        QVERIFY(original.open(QIODevice::ReadOnly));
+        QByteArray data = original.readAll();
+
+        QTemporaryFile file;
+        QVERIFY(file.open());
+        QCOMPARE(file.write(data), (qint64)data.size());
+        QVERIFY(file.flush());
+        QVERIFY(QFile::remove(file.fileName())); /* The open device stays readable. */
+
+        AppImageUpdateInformationPrivate AIUpdateInformation;
+        AIUpdateInformation.setAppImage(&file);
+        QSignalSpy spyInfo(&AIUpdateInformation, SIGNAL(info(QJsonObject)));
+        AIUpdateInformation.getInfo();
+        QVERIFY(spyInfo.count() || spyInfo.wait());
+
+        auto result = spyInfo.takeFirst().at(0).toJsonObject();
+        QCOMPARE(result["FileInformation"].toObject()["AppImageSHA1Hash"].toString(),
+                 QString(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex().toUpper()));
+        return;
+    }
+
     void checkErrorSignal(void)
     {
         using AppImageUpdaterBridge::AppImageUpdateInformationPrivate;
@@ -0,0 +1,147 @@
+#ifndef APPIMAGE_UPDATE_MANAGER_TESTS_HPP_INCLUDED
+#define APPIMAGE_UPDATE_MANAGER_TESTS_HPP_INCLUDED
+#include <QTest>
+#include <QSignalSpy>
+#include <QFileInfo>
+#include "../include/appimageupdatemanager.hpp"
+#include "../include/zsyncrequestlimiter_p.hpp"
+
+/*
+ * Get the official appimage tool to test it with
+ * our library.
+*/
+#define APPIMAGE_TOOL_RELATIVE_PATH QString("test_cases/appimagetool.AppImage")
+#define APPIMAGE_TOOL_MODIFIED_RELATIVE_PATH QString("test_cases/appimagetool-mod.AppImage")
+
+/* Counts how often the request limiter handed it a slot. */
+class RequestLimiterWaiter : public QObject
+{
+    Q_OBJECT
+public:
+    int n_Woken = 0;
+public Q_SLOTS:
+    void wake(void)
+    {
+        ++n_Woken;
+        return;
+    }
+};
+
+class AppImageUpdateManager : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase(void)
+    {
+        QFileInfo file(APPIMAGE_TOOL_RELATIVE_PATH);
+        if(!file.exists()) {
+            QFAIL("required test cases does not exist!");
+        }
+        return;
+    }
+
+    void checkForUpdateOfManyAppImages(void)
+    {
+        using AppImageUpdaterBridge::AppImageUpdateManager;
+        AppImageUpdateManager Manager(/*workerThreads=*/2, /*maxInFlightRequests=*/4);
+        QSignalSpy spyAvailable(&Manager, SIGNAL(updateAvailable(bool, QJsonObject, QString)));
+        QSignalSpy spyError(&Manager, SIGNAL(error(short, QString)));
+        QSignalSpy spyAllFinished(&Manager, SIGNAL(allFinished(void)));
+
+        Manager.checkForUpdate(QStringList() << APPIMAGE_TOOL_RELATIVE_PATH
+                               << APPIMAGE_TOOL_MODIFIED_RELATIVE_PATH);
+
+        QVERIFY(spyAllFinished.wait(30 * 1000));
+        QCOMPARE(spyAvailable.count(), 2);
+        QCOMPARE(spyError.count(), 0);
+
+        QStringList paths;
+        for(auto arguments : spyAvailable) {
+            paths << arguments.at(2).toString();
+        }
+        paths.sort();
+        QCOMPARE(paths, QStringList() << APPIMAGE_TOOL_MODIFIED_RELATIVE_PATH << APPIMAGE_TOOL_RELATIVE_PATH);
+        return;
+    }
+
+    /* With one worker thread the second AppImage waits in the queue , So it is canceled right away. */
+    void queuedJobIsCanceled(void)
+    {
+        using AppImageUpdaterBridge::AppImageUpdateManager;
+        AppImageUpdateManager Manager(/*workerThreads=*/1);
+        QSignalSpy spyAvailable(&Manager, SIGNAL(updateAvailable(bool, QJsonObject, QString)));
+        QSignalSpy spyCanceled(&Manager, SIGNAL(canceled(QString)));
+        QSignalSpy spyAllFinished(&Manager, SIGNAL(allFinished(void)));
+
+        Manager.checkForUpdate(QStringList() << APPIMAGE_TOOL_RELATIVE_PATH
+                               << APPIMAGE_TOOL_MODIFIED_RELATIVE_PATH);
+        Manager.cancel(APPIMAGE_TOOL_MODIFIED_RELATIVE_PATH);
+
+        QVERIFY(spyCanceled.count() || spyCanceled.wait());
+        QCOMPARE(spyCanceled.at(0).at(0).toString(), APPIMAGE_TOOL_MODIFIED_RELATIVE_PATH);
+
+        QVERIFY(spyAllFinished.count() || spyAllFinished.wait(30 * 1000));
+        QCOMPARE(spyAvailable.count(), 1);
+        QCOMPARE(spyAvailable.at(0).at(2).toString(), APPIMAGE_TOOL_RELATIVE_PATH);
+        return;
+    }
+
+    /* A released slot must wake only the first waiter , and a unused slot goes to the next one. */
+    void requestLimiterWakesOneWaiter(void)
+    {
+        using AppImageUpdaterBridge::ZsyncRequestLimiterPrivate;
+        ZsyncRequestLimiterPrivate limiter(1);
+        RequestLimiterWaiter first, second;
+
+        QVERIFY(limiter.tryAcquire(&first, "wake"));
+        QVERIFY(!limiter.tryAcquire(&first, "wake"));
+        QVERIFY(!limiter.tryAcquire(&second, "wake"));
+
+        limiter.release();
+        QCoreApplication::processEvents();
+        QCOMPARE(first.n_Woken, 1);
+        QCOMPARE(second.n_Woken, 0);
+        QCOMPARE(limiter.available(), 0);
+
+        /* The first waiter has nothing to send anymore. */
+        limiter.releaseUnclaimed(&first);
+        QCoreApplication::processEvents();
+        QCOMPARE(second.n_Woken, 1);
+        QVERIFY(limiter.tryAcquire(&second, "wake"));
+        limiter.release();
+        QCOMPARE(limiter.available(), 1);
+        return;
+    }
+
+    void errorCarriesAppImagePath(void)
+    {
+        using AppImageUpdaterBridge::AppImageUpdateManager;
+        AppImageUpdateManager Manager(/*workerThreads=*/1);
+        QSignalSpy spyError(&Manager, SIGNAL(error(short, QString)));
+
+        QString path("test_cases/does-not-exist.AppImage");
+        Manager.checkForUpdate(QStringList() << path);
+
+        QVERIFY(spyError.count() || spyError.wait());
+        QCOMPARE(spyError.at(0).at(1).toString(), path);
+        return;
+    }
+
+    /* A single request slot and a single seed scan slot must still finish. */
+    void updateShouldSucceedWithTightLimits(void)
+    {
+        using AppImageUpdaterBridge::AppImageUpdateManager;
+        AppImageUpdateManager Manager(/*workerThreads=*/1, /*maxInFlightRequests=*/1,
+                                      /*maxConcurrentSeedScans=*/1);
+        QSignalSpy spyFinished(&Manager, SIGNAL(finished(QJsonObject, QString, QString)));
+        QSignalSpy spyAllFinished(&Manager, SIGNAL(allFinished(void)));
+
+        Manager.update(QStringList() << APPIMAGE_TOOL_RELATIVE_PATH);
+
+        QVERIFY(spyAllFinished.wait(50 * 1000));
+        QCOMPARE(spyFinished.count(), 1);
+        QCOMPARE(spyFinished.at(0).at(2).toString(), APPIMAGE_TOOL_RELATIVE_PATH);
+        return;
+    }
+};
+#endif // APPIMAGE_UPDATE_MANAGER_TESTS_HPP_INCLUDED
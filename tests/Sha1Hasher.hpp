@@ -0,0 +1,63 @@
+#ifndef SHA1_HASHER_TESTS_HPP_INCLUDED
+#define SHA1_HASHER_TESTS_HPP_INCLUDED
+#include <QTest>
+#include <QTemporaryFile>
+#include <QCryptographicHash>
+#include "../include/sha1hasher_p.hpp"
+
+using AppImageUpdaterBridge::Sha1HasherPrivate;
+
+class Sha1Hasher : public QObject
+{
+    Q_OBJECT
+private:
+    static QByteArray pattern(qint64 size)
+    {
+        QByteArray ret(size, 0);
+        for(qint64 i = 0; i < size; ++i) {
+            ret[(int)i] = (char)((i * 131) ^ (i >> 11));
+        }
+        return ret;
+    }
+private slots:
+    void compareWithQCryptographicHash(void)
+    {
+        QByteArray data = pattern(1048576 + 77);
+        QList<int> sizes = { 0, 1, 3, 55, 56, 63, 64, 65, 119, 120, 128, 1000, 1048576 + 77 };
+        for(auto size : sizes) {
+            QByteArray input = data.left(size);
+            QByteArray expected = QCryptographicHash::hash(input, QCryptographicHash::Sha1);
+
+            Sha1HasherPrivate hasher;
+            hasher.addData(input.constData(), input.size());
+            QCOMPARE(hasher.result(), expected);
+
+            /* Feed the same data in odd sized pieces. */
+            hasher.reset();
+            for(int i = 0; i < input.size(); i += 7) {
+                hasher.addData(input.constData() + i, qMin(7, input.size() - i));
+            }
+            QCOMPARE(hasher.result(), expected);
+        }
+        return;
+    }
+
+    void compareFileWithQCryptographicHash(void)
+    {
+        QTemporaryFile file;
+        QVERIFY(file.open());
+        QByteArray data = pattern(3 * 1048576 + 5);
+        file.write(data);
+        file.seek(0);
+
+        Sha1HasherPrivate hasher(4096);
+        QVERIFY(hasher.addData(&file, 1048576));
+        QCOMPARE(file.pos(), (qint64)1048576);
+        QVERIFY(hasher.addData(&file));
+        QVERIFY(file.atEnd());
+        QCOMPARE(hasher.result().toHex().toUpper(),
+                 QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex().toUpper());
+        return;
+    }
+};
+#endif // SHA1_HASHER_TESTS_HPP_INCLUDED
@@ -0,0 +1,109 @@
+#ifndef ZSYNC_BLOCK_RANGE_DOWNLOADER_TESTS_HPP_INCLUDED
+#define ZSYNC_BLOCK_RANGE_DOWNLOADER_TESTS_HPP_INCLUDED
+#include <QTest>
+#include <QSignalSpy>
+#include <QThread>
+#include <QNetworkAccessManager>
+#include "../include/zsyncblockrangedownloader_p.hpp"
+#include "../include/zsyncwriter_p.hpp"
+#include "LocalHttpServer.hpp"
+
+/* Size of every block range requested in these tests. */
+#define BLOCK_RANGE_SIZE 65536
+
+class ZsyncBlockRangeDownloader : public QObject
+{
+    Q_OBJECT
+private slots:
+    /*
+     * The writer's thread is not running at first , So nothing is written and
+     * the downloader must stop once the pending write bytes reach the bound.
+    */
+    void pendingWritesAreBounded(void)
+    {
+        using AppImageUpdaterBridge::ZsyncWriterPrivate;
+        using AppImageUpdaterBridge::ZsyncBlockRangeDownloaderPrivate;
+        const int ranges = 16;
+        LocalHttpServer server;
+        QVERIFY(server.listen());
+        server.addFile("target", QByteArray(ranges * BLOCK_RANGE_SIZE, 'x'));
+
+        QNetworkAccessManager manager;
+        QThread writerThread;
+        auto writer = new ZsyncWriterPrivate;
+        ZsyncBlockRangeDownloaderPrivate downloader(writer, &manager);
+        downloader.setMaxPendingWriteBytes(2 * BLOCK_RANGE_SIZE);
+        writer->moveToThread(&writerThread);
+
+        /* The ranges are given below , the unconfigured writer has none. */
+        QObject::disconnect(&downloader, SIGNAL(blockRangesRequested()), writer, SLOT(getBlockRanges()));
+
+        int served = 0;
+        connect(&server, &LocalHttpServer::request, [&served]() {
+            ++served;
+        });
+        QSignalSpy spyFinished(&downloader, SIGNAL(finished()));
+
+        emit writer->download(0, ranges * BLOCK_RANGE_SIZE, server.url("target"));
+        for(int i = 0; i < ranges; ++i) {
+            emit writer->blockRange(i * BLOCK_RANGE_SIZE, (i + 1) * BLOCK_RANGE_SIZE);
+        }
+        emit writer->endOfBlockRanges();
+
+        QTest::qWait(1000);
+        QCOMPARE(served, 2);
+        QCOMPARE(spyFinished.count(), 0);
+
+        /* Every written range makes room for the next one. */
+        writerThread.start();
+        QVERIFY(spyFinished.count() || spyFinished.wait(10 * 1000));
+        QCOMPARE(served, ranges);
+
+        writerThread.quit();
+        writerThread.wait();
+        delete writer;
+        return;
+    }
+
+    /*
+     * Every new connection waits for the connect latency of the server , The
+     * connections opened when the seed scan started must spare the first
+     * range request that wait.
+    */
+    void preConnectSparesTheHandshake(void)
+    {
+        using AppImageUpdaterBridge::ZsyncWriterPrivate;
+        using AppImageUpdaterBridge::ZsyncBlockRangeDownloaderPrivate;
+        const int connectLatency = 1000;
+        LocalHttpServer server(/*latency=*/0, /*bandwidth=*/0, connectLatency);
+        QVERIFY(server.listen());
+        server.addFile("target", QByteArray(BLOCK_RANGE_SIZE, 'x'));
+
+        QNetworkAccessManager manager;
+        auto writer = new ZsyncWriterPrivate;
+        ZsyncBlockRangeDownloaderPrivate downloader(writer, &manager);
+        QObject::disconnect(&downloader, SIGNAL(blockRangesRequested()), writer, SLOT(getBlockRanges()));
+
+        qint64 firstByte = -1;
+        connect(&server, &LocalHttpServer::request, [&firstByte](QString, QByteArray, qint64, qint64 wait) {
+            if(firstByte < 0) {
+                firstByte = wait;
+            }
+        });
+        QSignalSpy spyFinished(&downloader, SIGNAL(finished()));
+
+        emit writer->seedScanStarted(server.url("target"));
+        QTest::qWait(connectLatency + 500);
+
+        emit writer->download(0, BLOCK_RANGE_SIZE, server.url("target"));
+        emit writer->blockRange(0, BLOCK_RANGE_SIZE);
+        emit writer->endOfBlockRanges();
+        QVERIFY(spyFinished.count() || spyFinished.wait(10 * 1000));
+        QVERIFY(firstByte >= 0);
+        QVERIFY(firstByte < connectLatency);
+
+        delete writer;
+        return;
+    }
+};
+#endif // ZSYNC_BLOCK_RANGE_DOWNLOADER_TESTS_HPP_INCLUDED
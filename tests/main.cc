@@ -2,6 +2,10 @@
 #include <AppImageUpdateInformation.hpp>
 #include <ZsyncRemoteControlFileParser.hpp>
 #include <AppImageDeltaRevisioner.hpp>
+#include <Sha1Hasher.hpp>
+#include <AppImageBatchScanner.hpp>
+#include <AppImageUpdateManager.hpp>
+#include <ZsyncBlockRangeDownloader.hpp>
 
 int main(int ac, char **av)
 {
@@ -9,11 +13,19 @@ int main(int ac, char **av)
     AppImageUpdateInformation AIUITest;
     ZsyncRemoteControlFileParser ZRCFParserTest;
     AppImageDeltaRevisioner AIDRTest;
+    Sha1Hasher SHA1HasherTest;
+    AppImageBatchScanner AIBScannerTest;
+    AppImageUpdateManager AIUManagerTest;
+    ZsyncBlockRangeDownloader ZBRDownloaderTest;
 
     auto startTests = [&]() {
         /* Test AppImage Update Information. */
         QTest::qExec(&AIUITest);
         QTest::qExec(&ZRCFParserTest);
+        QTest::qExec(&SHA1HasherTest);
+        QTest::qExec(&AIBScannerTest);
+        QTest::qExec(&AIUManagerTest);
+        QTest::qExec(&ZBRDownloaderTest);
 	QTest::qExec(&AIDRTest);
         return;
     };
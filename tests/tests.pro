@@ -1,8 +1,16 @@
 include(../AppImageUpdaterBridge.pri)
-INCLUDEPATH += .
+INCLUDEPATH += . ../benchmarks
 CONFIG += release
 QT += testlib
-SOURCES += main.cc
+SOURCES += main.cc \
+	   ../benchmarks/LocalHttpServer.cc \
+	   ../benchmarks/SyntheticAppImage.cc
 HEADERS += AppImageUpdateInformation.hpp \
 	   ZsyncRemoteControlFileParser.hpp \
-	   AppImageDeltaRevisioner.hpp
+	   AppImageDeltaRevisioner.hpp \
+	   Sha1Hasher.hpp \
+	   AppImageBatchScanner.hpp \
+	   AppImageUpdateManager.hpp \
+	   ZsyncBlockRangeDownloader.hpp \
+	   ../benchmarks/LocalHttpServer.hpp \
+	   ../benchmarks/SyntheticAppImage.hpp